@@ -0,0 +1,569 @@
+/*--------------------------------------------------------------------*/
+/* benchsymtable.c                                                    */
+/* Author: Tara Shukla                                                */
+/*--------------------------------------------------------------------*/
+
+/* Benchmark a SymTable implementation. The makefile links this file
+   against each backend (benchsymtablelist, benchsymtablehash, ...) with
+   the linker wrapping malloc, calloc, realloc and free, so that
+   allocations can be counted. Each workload prints one JSON object per
+   line to stdout. */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "symtable.h"
+#include "symtableu64.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <assert.h>
+#include <stdint.h>
+#include <sys/resource.h>
+
+/*--------------------------------------------------------------------*/
+
+/*allocation calls made since the program started*/
+static unsigned long ulAllocCount = 0;
+
+void *__real_malloc(size_t uSize);
+void *__real_calloc(size_t uCount, size_t uSize);
+void *__real_realloc(void *pv, size_t uSize);
+void __real_free(void *pv);
+
+/*count, then forward to the real malloc*/
+void *__wrap_malloc(size_t uSize)
+{
+   ulAllocCount++;
+   return __real_malloc(uSize);
+}
+
+/*count, then forward to the real calloc*/
+void *__wrap_calloc(size_t uCount, size_t uSize)
+{
+   ulAllocCount++;
+   return __real_calloc(uCount, uSize);
+}
+
+/*count, then forward to the real realloc*/
+void *__wrap_realloc(void *pv, size_t uSize)
+{
+   ulAllocCount++;
+   return __real_realloc(pv, uSize);
+}
+
+/*forward to the real free*/
+void __wrap_free(void *pv)
+{
+   __real_free(pv);
+}
+
+/*--------------------------------------------------------------------*/
+
+/*key distributions*/
+enum Distribution {DIST_UNIFORM, DIST_ZIPF};
+
+/*benchmark settings, filled in from the command line*/
+struct Config {
+   /*workload name: insert, lookup, churn, ids or all*/
+   const char *pcWorkload;
+   /*distribution of the keys that operations touch*/
+   enum Distribution eDist;
+   /*Zipf exponent*/
+   double dSkew;
+   /*number of distinct keys in the table*/
+   size_t uKeys;
+   /*number of timed operations*/
+   size_t uOps;
+   /*shortest and longest key length in characters*/
+   size_t uMinLen;
+   size_t uMaxLen;
+   /*percentage of lookups that hit, for the lookup workload*/
+   unsigned int uHitPercent;
+   /*random seed*/
+   uint64_t uSeed;
+};
+
+/*state of the xorshift64* generator*/
+static uint64_t uRandState;
+
+/*return the next pseudo-random number*/
+static uint64_t nextRandom(void)
+{
+   uRandState ^= uRandState >> 12;
+   uRandState ^= uRandState << 25;
+   uRandState ^= uRandState >> 27;
+   return uRandState * (uint64_t)2685821657736338717ULL;
+}
+
+/*return nanoseconds on the monotonic clock*/
+static uint64_t nowNs(void)
+{
+   struct timespec sTime;
+   clock_gettime(CLOCK_MONOTONIC, &sTime);
+   return (uint64_t)sTime.tv_sec * 1000000000u + (uint64_t)sTime.tv_nsec;
+}
+
+/*return peak resident set size of the process in kilobytes*/
+static long peakRssKb(void)
+{
+   struct rusage sUsage;
+   getrusage(RUSAGE_SELF, &sUsage);
+   return sUsage.ru_maxrss;
+}
+
+/*--------------------------------------------------------------------*/
+
+/*return a malloc'd array of uCount distinct keys, each between
+  psConfig->uMinLen and uMaxLen chars; cPrefix distinguishes key sets*/
+static char **makeKeys(const struct Config *psConfig, size_t uCount,
+   char cPrefix)
+{
+   static const char acAlphabet[] =
+      "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789";
+   char **ppcKeys;
+   char acId[32];
+   size_t uLen;
+   size_t uIdLen;
+   size_t i;
+   size_t j;
+
+   ppcKeys = (char**)malloc(uCount * sizeof(char*));
+   if (ppcKeys == NULL) return NULL;
+   for (i = 0; i < uCount; i++){
+      uLen = psConfig->uMinLen;
+      if (psConfig->uMaxLen > psConfig->uMinLen)
+         uLen += (size_t)(nextRandom()
+            % (psConfig->uMaxLen - psConfig->uMinLen + 1));
+      /*a unique id makes keys distinct; random filler pads them out*/
+      sprintf(acId, "%c%lu", cPrefix, (unsigned long)i);
+      uIdLen = strlen(acId);
+      if (uLen < uIdLen) uLen = uIdLen;
+      ppcKeys[i] = (char*)malloc(uLen + 1);
+      if (ppcKeys[i] == NULL) return NULL;
+      for (j = 0; j < uLen - uIdLen; j++)
+         ppcKeys[i][j] = acAlphabet[nextRandom() % (sizeof(acAlphabet) - 1)];
+      strcpy(ppcKeys[i] + uLen - uIdLen, acId);
+   }
+   return ppcKeys;
+}
+
+/*free the uCount keys in ppcKeys and the array itself*/
+static void freeKeys(char **ppcKeys, size_t uCount)
+{
+   size_t i;
+   for (i = 0; i < uCount; i++) free(ppcKeys[i]);
+   free(ppcKeys);
+}
+
+/*return a malloc'd cumulative Zipf distribution over uCount ranks*/
+static double *makeZipfCdf(size_t uCount, double dSkew)
+{
+   double *pdCdf;
+   double dSum = 0.0;
+   size_t i;
+
+   pdCdf = (double*)malloc(uCount * sizeof(double));
+   if (pdCdf == NULL) return NULL;
+   for (i = 0; i < uCount; i++){
+      dSum += 1.0 / pow((double)(i + 1), dSkew);
+      pdCdf[i] = dSum;
+   }
+   for (i = 0; i < uCount; i++) pdCdf[i] /= dSum;
+   return pdCdf;
+}
+
+/*return a key index in [0, uCount) drawn from the configured
+  distribution; pdCdf is the Zipf CDF (unused for uniform)*/
+static size_t pickIndex(const struct Config *psConfig, const double *pdCdf,
+   size_t uCount)
+{
+   double dU;
+   size_t uLow = 0;
+   size_t uHigh;
+   size_t uMid;
+
+   if (psConfig->eDist == DIST_UNIFORM)
+      return (size_t)(nextRandom() % uCount);
+
+   dU = (double)(nextRandom() >> 11) / 9007199254740992.0;
+   uHigh = uCount - 1;
+   while (uLow < uHigh){
+      uMid = uLow + (uHigh - uLow) / 2;
+      if (pdCdf[uMid] < dU) uLow = uMid + 1;
+      else uHigh = uMid;
+   }
+   /*scatter the ranks so that hot keys are not also adjacent keys*/
+   return (uLow * 2654435761u) % uCount;
+}
+
+/*qsort comparison for latency samples*/
+static int compareSamples(const void *pv1, const void *pv2)
+{
+   uint64_t u1 = *(const uint64_t*)pv1;
+   uint64_t u2 = *(const uint64_t*)pv2;
+   return u1 < u2 ? -1 : (u1 > u2 ? 1 : 0);
+}
+
+/*return the smallest observable interval between two clock reads*/
+static uint64_t timerOverhead(void)
+{
+   uint64_t uMin = (uint64_t)-1;
+   uint64_t uStart;
+   uint64_t uDelta;
+   int i;
+
+   for (i = 0; i < 1000; i++){
+      uStart = nowNs();
+      uDelta = nowNs() - uStart;
+      if (uDelta < uMin) uMin = uDelta;
+   }
+   return uMin;
+}
+
+/*print one JSON result line from the uOps latencies in puSamples*/
+static void report(const char *pcBackend, const char *pcWorkload,
+   const struct Config *psConfig, uint64_t *puSamples, size_t uOps,
+   unsigned long ulAllocs, uint64_t uOverhead)
+{
+   uint64_t uTotal = 0;
+   size_t i;
+
+   for (i = 0; i < uOps; i++){
+      puSamples[i] = puSamples[i] > uOverhead ? puSamples[i] - uOverhead : 0;
+      uTotal += puSamples[i];
+   }
+   qsort(puSamples, uOps, sizeof(uint64_t), compareSamples);
+
+   printf("{\"backend\":\"%s\",\"workload\":\"%s\",\"dist\":\"%s\","
+      "\"skew\":%.2f,\"keys\":%lu,\"ops\":%lu,\"min_key_len\":%lu,"
+      "\"max_key_len\":%lu,\"ns_per_op\":%.1f,\"p50_ns\":%lu,"
+      "\"p99_ns\":%lu,\"p999_ns\":%lu,\"peak_rss_kb\":%ld,"
+      "\"allocs_per_op\":%.3f}\n",
+      pcBackend, pcWorkload,
+      psConfig->eDist == DIST_ZIPF ? "zipf" : "uniform", psConfig->dSkew,
+      (unsigned long)psConfig->uKeys, (unsigned long)uOps,
+      (unsigned long)psConfig->uMinLen, (unsigned long)psConfig->uMaxLen,
+      uOps == 0 ? 0.0 : (double)uTotal / (double)uOps,
+      (unsigned long)puSamples[uOps / 2],
+      (unsigned long)puSamples[(size_t)((double)uOps * 0.99)],
+      (unsigned long)puSamples[(size_t)((double)uOps * 0.999)],
+      peakRssKb(),
+      uOps == 0 ? 0.0 : (double)ulAllocs / (double)uOps);
+   fflush(stdout);
+}
+
+/*--------------------------------------------------------------------*/
+
+/*time putting every key into an empty table*/
+static void benchInsert(const char *pcBackend,
+   const struct Config *psConfig, char **ppcKeys, uint64_t *puSamples,
+   uint64_t uOverhead)
+{
+   SymTable_T oSymTable;
+   unsigned long ulAllocs;
+   uint64_t uStart;
+   size_t i;
+
+   oSymTable = SymTable_new();
+   assert(oSymTable != NULL);
+   ulAllocs = ulAllocCount;
+   for (i = 0; i < psConfig->uKeys; i++){
+      uStart = nowNs();
+      SymTable_put(oSymTable, ppcKeys[i], ppcKeys[i]);
+      puSamples[i] = nowNs() - uStart;
+   }
+   ulAllocs = ulAllocCount - ulAllocs;
+   report(pcBackend, "insert", psConfig, puSamples, psConfig->uKeys,
+      ulAllocs, uOverhead);
+   SymTable_free(oSymTable);
+}
+
+/*time lookups of which uHitPercent percent hit*/
+static void benchLookup(const char *pcBackend,
+   const struct Config *psConfig, unsigned int uHitPercent,
+   char **ppcKeys, char **ppcMissKeys, const double *pdCdf,
+   uint64_t *puSamples, uint64_t uOverhead)
+{
+   SymTable_T oSymTable;
+   char acWorkload[32];
+   const char *pcKey;
+   unsigned long ulAllocs;
+   uint64_t uStart;
+   size_t uIndex;
+   size_t i;
+   volatile void *pvSink;
+
+   oSymTable = SymTable_new();
+   assert(oSymTable != NULL);
+   for (i = 0; i < psConfig->uKeys; i++)
+      SymTable_put(oSymTable, ppcKeys[i], ppcKeys[i]);
+
+   ulAllocs = ulAllocCount;
+   for (i = 0; i < psConfig->uOps; i++){
+      uIndex = pickIndex(psConfig, pdCdf, psConfig->uKeys);
+      pcKey = (nextRandom() % 100 < uHitPercent)
+         ? ppcKeys[uIndex] : ppcMissKeys[uIndex];
+      uStart = nowNs();
+      pvSink = SymTable_get(oSymTable, pcKey);
+      puSamples[i] = nowNs() - uStart;
+   }
+   (void)pvSink;
+   ulAllocs = ulAllocCount - ulAllocs;
+   sprintf(acWorkload, "lookup_hit%u", uHitPercent);
+   report(pcBackend, acWorkload, psConfig, puSamples, psConfig->uOps,
+      ulAllocs, uOverhead);
+   SymTable_free(oSymTable);
+}
+
+/*time a mix of puts and removes over twice as many keys as the table
+  starts with, so the table stays about half full*/
+static void benchChurn(const char *pcBackend,
+   const struct Config *psConfig, char **ppcKeys, char **ppcMissKeys,
+   const double *pdCdf, uint64_t *puSamples, uint64_t uOverhead)
+{
+   SymTable_T oSymTable;
+   unsigned char *pucPresent;
+   const char *pcKey;
+   unsigned long ulAllocs;
+   uint64_t uStart;
+   size_t uIndex;
+   size_t i;
+
+   oSymTable = SymTable_new();
+   pucPresent = (unsigned char*)calloc(2 * psConfig->uKeys, 1);
+   assert(oSymTable != NULL && pucPresent != NULL);
+   for (i = 0; i < psConfig->uKeys; i++){
+      SymTable_put(oSymTable, ppcKeys[i], ppcKeys[i]);
+      pucPresent[i] = 1;
+   }
+
+   ulAllocs = ulAllocCount;
+   for (i = 0; i < psConfig->uOps; i++){
+      uIndex = pickIndex(psConfig, pdCdf, psConfig->uKeys);
+      if (nextRandom() & 1) uIndex += psConfig->uKeys;
+      pcKey = uIndex < psConfig->uKeys
+         ? ppcKeys[uIndex] : ppcMissKeys[uIndex - psConfig->uKeys];
+      uStart = nowNs();
+      if (pucPresent[uIndex]) SymTable_remove(oSymTable, pcKey);
+      else SymTable_put(oSymTable, pcKey, pcKey);
+      puSamples[i] = nowNs() - uStart;
+      pucPresent[uIndex] = (unsigned char)!pucPresent[uIndex];
+   }
+   ulAllocs = ulAllocCount - ulAllocs;
+   report(pcBackend, "churn", psConfig, puSamples, psConfig->uOps,
+      ulAllocs, uOverhead);
+   SymTable_free(oSymTable);
+   free(pucPresent);
+}
+
+/*time putting then looking up uKeys 64-bit ids two ways: formatted
+  into strings with sprintf (the path callers take with symtable.h) and
+  directly in a SymTableU64*/
+static void benchIds(const char *pcBackend,
+   const struct Config *psConfig, const double *pdCdf,
+   uint64_t *puSamples, uint64_t uOverhead)
+{
+   SymTable_T oSymTable;
+   SymTableU64_T oU64Table;
+   char acKey[32];
+   unsigned long ulAllocs;
+   uint64_t uStart;
+   uint64_t uId;
+   size_t i;
+   volatile void *pvSink;
+
+   oSymTable = SymTable_new();
+   assert(oSymTable != NULL);
+   ulAllocs = ulAllocCount;
+   for (i = 0; i < psConfig->uKeys; i++){
+      uStart = nowNs();
+      sprintf(acKey, "%lu", (unsigned long)i);
+      SymTable_put(oSymTable, acKey, oSymTable);
+      puSamples[i] = nowNs() - uStart;
+   }
+   ulAllocs = ulAllocCount - ulAllocs;
+   report(pcBackend, "ids_insert", psConfig, puSamples, psConfig->uKeys,
+      ulAllocs, uOverhead);
+
+   ulAllocs = ulAllocCount;
+   for (i = 0; i < psConfig->uOps; i++){
+      uId = (uint64_t)pickIndex(psConfig, pdCdf, psConfig->uKeys);
+      uStart = nowNs();
+      sprintf(acKey, "%lu", (unsigned long)uId);
+      pvSink = SymTable_get(oSymTable, acKey);
+      puSamples[i] = nowNs() - uStart;
+   }
+   ulAllocs = ulAllocCount - ulAllocs;
+   report(pcBackend, "ids_lookup", psConfig, puSamples, psConfig->uOps,
+      ulAllocs, uOverhead);
+   SymTable_free(oSymTable);
+
+   oU64Table = SymTableU64_new();
+   assert(oU64Table != NULL);
+   ulAllocs = ulAllocCount;
+   for (i = 0; i < psConfig->uKeys; i++){
+      uStart = nowNs();
+      SymTableU64_put(oU64Table, (uint64_t)i, oU64Table);
+      puSamples[i] = nowNs() - uStart;
+   }
+   ulAllocs = ulAllocCount - ulAllocs;
+   report("u64", "ids_insert", psConfig, puSamples, psConfig->uKeys,
+      ulAllocs, uOverhead);
+
+   ulAllocs = ulAllocCount;
+   for (i = 0; i < psConfig->uOps; i++){
+      uId = (uint64_t)pickIndex(psConfig, pdCdf, psConfig->uKeys);
+      uStart = nowNs();
+      pvSink = SymTableU64_get(oU64Table, uId);
+      puSamples[i] = nowNs() - uStart;
+   }
+   (void)pvSink;
+   ulAllocs = ulAllocCount - ulAllocs;
+   report("u64", "ids_lookup", psConfig, puSamples, psConfig->uOps,
+      ulAllocs, uOverhead);
+   SymTableU64_free(oU64Table);
+}
+
+/*--------------------------------------------------------------------*/
+
+/*print usage for program pcProgram to stderr and exit*/
+static void usage(const char *pcProgram)
+{
+   fprintf(stderr,
+      "Usage: %s [-w insert|lookup|churn|ids|all] [-d uniform|zipf]\n"
+      "          [-z skew] [-n keys] [-o ops] [-l minlen[:maxlen]]\n"
+      "          [-p hitpercent] [-s seed]\n", pcProgram);
+   exit(EXIT_FAILURE);
+}
+
+/* Run the benchmark workloads selected by the command-line options in
+   argv on the SymTable implementation this program is linked with.
+   The backend name is taken from argv[0]. Exit with EXIT_FAILURE on
+   bad usage; otherwise return 0. */
+
+int main(int argc, char *argv[])
+{
+   struct Config sConfig;
+   const char *pcBackend;
+   char **ppcKeys;
+   char **ppcMissKeys;
+   double *pdCdf = NULL;
+   uint64_t *puSamples;
+   uint64_t uOverhead;
+   unsigned long ulMin;
+   unsigned long ulMax;
+   unsigned long ulValue;
+   int iAll;
+   int i;
+
+   sConfig.pcWorkload = "all";
+   sConfig.eDist = DIST_UNIFORM;
+   sConfig.dSkew = 0.99;
+   sConfig.uKeys = 10000;
+   sConfig.uOps = 200000;
+   sConfig.uMinLen = 8;
+   sConfig.uMaxLen = 8;
+   sConfig.uHitPercent = 90;
+   sConfig.uSeed = 88172645463325252ULL;
+
+   for (i = 1; i < argc; i++){
+      if (argv[i][0] != '-' || argv[i][1] == '\0' || argv[i][2] != '\0'
+         || i + 1 == argc)
+         usage(argv[0]);
+      switch (argv[i][1]){
+         case 'w': sConfig.pcWorkload = argv[++i]; break;
+         case 'd':
+            i++;
+            if (strcmp(argv[i], "zipf") == 0) sConfig.eDist = DIST_ZIPF;
+            else if (strcmp(argv[i], "uniform") == 0)
+               sConfig.eDist = DIST_UNIFORM;
+            else usage(argv[0]);
+            break;
+         case 'z':
+            if (sscanf(argv[++i], "%lf", &sConfig.dSkew) != 1)
+               usage(argv[0]);
+            break;
+         case 'n':
+         case 'o':
+         case 'p':
+         case 's':
+            if (sscanf(argv[i + 1], "%lu", &ulValue) != 1) usage(argv[0]);
+            if (argv[i][1] == 'n') sConfig.uKeys = (size_t)ulValue;
+            else if (argv[i][1] == 'o') sConfig.uOps = (size_t)ulValue;
+            else if (argv[i][1] == 'p')
+               sConfig.uHitPercent = (unsigned int)ulValue;
+            else sConfig.uSeed = (uint64_t)ulValue;
+            i++;
+            break;
+         case 'l':
+            i++;
+            if (sscanf(argv[i], "%lu:%lu", &ulMin, &ulMax) == 2){
+               sConfig.uMinLen = (size_t)ulMin;
+               sConfig.uMaxLen = (size_t)ulMax;
+            }
+            else if (sscanf(argv[i], "%lu", &ulMin) == 1)
+               sConfig.uMinLen = sConfig.uMaxLen = (size_t)ulMin;
+            else usage(argv[0]);
+            break;
+         default:
+            usage(argv[0]);
+      }
+   }
+   if (sConfig.uKeys == 0 || sConfig.uOps == 0
+      || sConfig.uMinLen > sConfig.uMaxLen || sConfig.uHitPercent > 100)
+      usage(argv[0]);
+   if (strcmp(sConfig.pcWorkload, "all") != 0
+      && strcmp(sConfig.pcWorkload, "insert") != 0
+      && strcmp(sConfig.pcWorkload, "lookup") != 0
+      && strcmp(sConfig.pcWorkload, "churn") != 0
+      && strcmp(sConfig.pcWorkload, "ids") != 0)
+      usage(argv[0]);
+   if (sConfig.uSeed == 0) sConfig.uSeed = 1;
+   uRandState = sConfig.uSeed;
+
+   pcBackend = strrchr(argv[0], '/');
+   pcBackend = pcBackend == NULL ? argv[0] : pcBackend + 1;
+   if (strncmp(pcBackend, "benchsymtable", 13) == 0) pcBackend += 13;
+
+   ppcKeys = makeKeys(&sConfig, sConfig.uKeys, 'k');
+   ppcMissKeys = makeKeys(&sConfig, sConfig.uKeys, 'm');
+   if (sConfig.eDist == DIST_ZIPF)
+      pdCdf = makeZipfCdf(sConfig.uKeys, sConfig.dSkew);
+   puSamples = (uint64_t*)malloc(
+      (sConfig.uOps > sConfig.uKeys ? sConfig.uOps : sConfig.uKeys)
+      * sizeof(uint64_t));
+   if (ppcKeys == NULL || ppcMissKeys == NULL || puSamples == NULL
+      || (sConfig.eDist == DIST_ZIPF && pdCdf == NULL)){
+      fprintf(stderr, "%s: insufficient memory\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+   uOverhead = timerOverhead();
+
+   iAll = strcmp(sConfig.pcWorkload, "all") == 0;
+   if (iAll || strcmp(sConfig.pcWorkload, "insert") == 0)
+      benchInsert(pcBackend, &sConfig, ppcKeys, puSamples, uOverhead);
+   if (iAll){
+      benchLookup(pcBackend, &sConfig, 90, ppcKeys, ppcMissKeys, pdCdf,
+         puSamples, uOverhead);
+      benchLookup(pcBackend, &sConfig, 10, ppcKeys, ppcMissKeys, pdCdf,
+         puSamples, uOverhead);
+   }
+   else if (strcmp(sConfig.pcWorkload, "lookup") == 0)
+      benchLookup(pcBackend, &sConfig, sConfig.uHitPercent, ppcKeys,
+         ppcMissKeys, pdCdf, puSamples, uOverhead);
+   if (iAll || strcmp(sConfig.pcWorkload, "churn") == 0)
+      benchChurn(pcBackend, &sConfig, ppcKeys, ppcMissKeys, pdCdf,
+         puSamples, uOverhead);
+   if (iAll || strcmp(sConfig.pcWorkload, "ids") == 0)
+      benchIds(pcBackend, &sConfig, pdCdf, puSamples, uOverhead);
+
+   freeKeys(ppcKeys, sConfig.uKeys);
+   freeKeys(ppcMissKeys, sConfig.uKeys);
+   free(pdCdf);
+   free(puSamples);
+   return 0;
+}
+
+/*--------------------------------------------------------------------*/
@@ -0,0 +1,67 @@
+/*--------------------------------------------------------------------*/
+/* loadsymtable.c                                                     */
+/* Author: Tara Shukla                                                */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "symtableload.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+
+/*return seconds on the monotonic clock*/
+static double nowSeconds(void)
+{
+   struct timespec sTime;
+   clock_gettime(CLOCK_MONOTONIC, &sTime);
+   return (double)sTime.tv_sec + (double)sTime.tv_nsec / 1e9;
+}
+
+/* Load the file named by the last argument in argv into a SymTable
+   with SymTable_loadFile, as key/value lines or, with -k, as key
+   lines, and report the number of bindings and the load rate. Return
+   0, or EXIT_FAILURE on bad usage or if the file cannot be loaded. */
+
+int main(int argc, char *argv[])
+{
+   enum SymTableFormat eFormat = SYMTABLE_FORMAT_TSV;
+   SymTable_T oSymTable;
+   struct stat sStat;
+   const char *pcPath;
+   double dStart;
+   double dSeconds;
+
+   if (argc == 3 && strcmp(argv[1], "-k") == 0)
+      eFormat = SYMTABLE_FORMAT_KEYS;
+   else if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s [-k] file\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+   pcPath = argv[argc - 1];
+   if (stat(pcPath, &sStat) != 0)
+   {
+      perror(pcPath);
+      exit(EXIT_FAILURE);
+   }
+
+   dStart = nowSeconds();
+   oSymTable = SymTable_loadFile(pcPath, eFormat);
+   dSeconds = nowSeconds() - dStart;
+   if (oSymTable == NULL)
+   {
+      fprintf(stderr, "%s: cannot load %s\n", argv[0], pcPath);
+      exit(EXIT_FAILURE);
+   }
+
+   printf("%lu bindings from %ld bytes in %.3f seconds (%.1f MB/s)\n",
+      (unsigned long)SymTable_getLength(oSymTable), (long)sStat.st_size,
+      dSeconds, dSeconds > 0.0 ? (double)sStat.st_size / dSeconds / 1e6 : 0.0);
+   SymTable_free(oSymTable);
+   return 0;
+}
+
+/*--------------------------------------------------------------------*/
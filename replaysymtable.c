@@ -0,0 +1,263 @@
+/*--------------------------------------------------------------------*/
+/* replaysymtable.c                                                   */
+/* Author: Tara Shukla                                                */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "symtabletrace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/*--------------------------------------------------------------------*/
+
+/* Number of SYMTABLE_TRACE_ kinds, counting from 1. */
+
+enum {KIND_COUNT = SYMTABLE_TRACE_PRELOAD + 1};
+
+/* Names of the SYMTABLE_TRACE_ kinds. */
+
+static const char *const apcKindNames[KIND_COUNT] =
+   {"", "put", "replace", "get", "contains", "remove", "preload"};
+
+/* The value bound to every key. */
+
+static int iValue;
+
+/*--------------------------------------------------------------------*/
+
+/* Return nanoseconds on the monotonic clock. */
+
+static double nowNanos(void)
+{
+   struct timespec sTime;
+   clock_gettime(CLOCK_MONOTONIC, &sTime);
+   return (double)sTime.tv_sec * 1e9 + (double)sTime.tv_nsec;
+}
+
+/* Write to pcKey a key standing for the token ulKey: the token's
+   base-36 digits, padded to uKeyLength characters with upper-case
+   letters, which are not digits, so the digits always end where the
+   padding begins. Equal tokens give equal keys, and distinct tokens
+   distinct keys even when that makes the key longer than uKeyLength.
+   Return the key's length. */
+
+static size_t makeKey(char *pcKey, unsigned long ulKey, size_t uKeyLength)
+{
+   size_t uLength = 0;
+
+   do
+   {
+      pcKey[uLength++] = "0123456789abcdefghijklmnopqrstuvwxyz"[ulKey % 36];
+      ulKey /= 36;
+   } while (ulKey != 0);
+   while (uLength < uKeyLength)
+   {
+      pcKey[uLength] = (char)('A' + uLength % 26);
+      uLength++;
+   }
+   pcKey[uLength] = '\0';
+   return uLength;
+}
+
+/* Perform psOp on oSymTable with the key pcKey. Return 1 if it found
+   or added a binding, else 0. */
+
+static int perform(SymTable_T oSymTable, const struct SymTableTraceOp *psOp,
+   const char *pcKey)
+{
+   switch (psOp->iKind)
+   {
+      case SYMTABLE_TRACE_PUT:
+      case SYMTABLE_TRACE_PRELOAD:
+         return SymTable_put(oSymTable, pcKey, &iValue);
+      case SYMTABLE_TRACE_REPLACE:
+         return SymTable_replace(oSymTable, pcKey, &iValue) != NULL;
+      case SYMTABLE_TRACE_GET:
+         return SymTable_get(oSymTable, pcKey) != NULL;
+      case SYMTABLE_TRACE_CONTAINS:
+         return SymTable_contains(oSymTable, pcKey);
+      default:
+         return SymTable_remove(oSymTable, pcKey) != NULL;
+   }
+}
+
+/* Compare the doubles at pvFirst and pvSecond for qsort. */
+
+static int compareDoubles(const void *pvFirst, const void *pvSecond)
+{
+   double dFirst = *(const double*)pvFirst;
+   double dSecond = *(const double*)pvSecond;
+   return (dFirst > dSecond) - (dFirst < dSecond);
+}
+
+/* Return the latency below which the fraction dRank of the uCount
+   sorted latencies at pdLatencies fall. */
+
+static double percentile(const double *pdLatencies, size_t uCount,
+   double dRank)
+{
+   size_t uIndex = (size_t)(dRank * (double)uCount);
+   if (uIndex >= uCount)
+      uIndex = uCount - 1;
+   return pdLatencies[uIndex];
+}
+
+/* Return a new table holding the preloaded bindings at the start of
+   the uCount operations at psOps, whose keys are at ppcKeys, storing in
+   *puFirst the index of the first operation that is not a preload.
+   Exit with EXIT_FAILURE if insufficient memory is available. */
+
+static SymTable_T preload(const struct SymTableTraceOp *psOps,
+   char **ppcKeys, size_t uCount, size_t *puFirst)
+{
+   SymTable_T oSymTable;
+   size_t i;
+
+   oSymTable = SymTable_new();
+   if (oSymTable == NULL)
+   {
+      fprintf(stderr, "insufficient memory\n");
+      exit(EXIT_FAILURE);
+   }
+   for (i = 0; i < uCount && psOps[i].iKind == SYMTABLE_TRACE_PRELOAD; i++)
+      perform(oSymTable, &psOps[i], ppcKeys[i]);
+   *puFirst = i;
+   return oSymTable;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Replay the trace named by argv[1] against the SymTable backend this
+   program is linked with: once untimed per operation, to report
+   throughput, and once timing each operation, to report the latency
+   distribution of each kind. Return 0, or EXIT_FAILURE on bad usage,
+   if the trace cannot be read, or if insufficient memory is
+   available. */
+
+int main(int argc, char *argv[])
+{
+   struct SymTableTraceOp *psOps;
+   SymTable_T oSymTable;
+   char **ppcKeys;
+   char *pcKeys;
+   double *pdLatencies;
+   double *apdLatencies[KIND_COUNT];
+   size_t auKindCounts[KIND_COUNT];
+   size_t auHits[KIND_COUNT];
+   size_t uCount;
+   size_t uFirst;
+   size_t uKeyBytes;
+   size_t uOffset;
+   size_t uKind;
+   size_t i;
+   int iMode;
+   double dStart;
+   double dSeconds;
+   double dOverhead;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s tracefile\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+   psOps = SymTableTrace_load(argv[1], &uCount, &iMode);
+   if (psOps == NULL)
+   {
+      fprintf(stderr, "%s: cannot read the trace %s\n", argv[0], argv[1]);
+      exit(EXIT_FAILURE);
+   }
+
+   /* Make every key before timing anything; a token has at most 7
+      base-36 digits. */
+   uKeyBytes = 0;
+   memset(auKindCounts, 0, sizeof(auKindCounts));
+   for (i = 0; i < uCount; i++)
+   {
+      uKeyBytes += (psOps[i].uKeyLength > 7 ? psOps[i].uKeyLength : 7) + 1;
+      auKindCounts[psOps[i].iKind]++;
+   }
+   ppcKeys = (char**)malloc((uCount + 1) * sizeof(char*));
+   pcKeys = (char*)malloc(uKeyBytes + 1);
+   pdLatencies = (double*)malloc((uCount + 1) * sizeof(double));
+   if (ppcKeys == NULL || pcKeys == NULL || pdLatencies == NULL)
+   {
+      fprintf(stderr, "%s: insufficient memory\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+   for (i = 0, uOffset = 0; i < uCount; i++)
+   {
+      ppcKeys[i] = pcKeys + uOffset;
+      uOffset += makeKey(ppcKeys[i], psOps[i].ulKey, psOps[i].uKeyLength) + 1;
+   }
+
+   printf("%lu operations (%lu preloaded) with %s keys\n",
+      (unsigned long)uCount,
+      (unsigned long)auKindCounts[SYMTABLE_TRACE_PRELOAD],
+      iMode == SYMTABLE_TRACE_NUMBERED ? "numbered" : "hashed");
+
+   /* Throughput, without a clock read per operation. */
+   oSymTable = preload(psOps, ppcKeys, uCount, &uFirst);
+   memset(auHits, 0, sizeof(auHits));
+   dStart = nowNanos();
+   for (i = uFirst; i < uCount; i++)
+      auHits[psOps[i].iKind] += (size_t)perform(oSymTable, &psOps[i],
+         ppcKeys[i]);
+   dSeconds = (nowNanos() - dStart) / 1e9;
+   SymTable_free(oSymTable);
+   printf("%lu operations in %.3f seconds (%.2f million per second)\n",
+      (unsigned long)(uCount - uFirst), dSeconds,
+      dSeconds > 0.0 ? (double)(uCount - uFirst) / dSeconds / 1e6 : 0.0);
+
+   /* Latency, grouping each kind's timings together in pdLatencies. */
+   for (uKind = 1, uOffset = 0; uKind < KIND_COUNT; uKind++)
+   {
+      apdLatencies[uKind] = pdLatencies + uOffset;
+      if (uKind != SYMTABLE_TRACE_PRELOAD)
+         uOffset += auKindCounts[uKind];
+      auKindCounts[uKind] = 0;
+   }
+   dStart = nowNanos();
+   for (i = 0; i < 1000; i++)
+      nowNanos();
+   dOverhead = (nowNanos() - dStart) / 1000.0;
+   oSymTable = preload(psOps, ppcKeys, uCount, &uFirst);
+   for (i = uFirst; i < uCount; i++)
+   {
+      uKind = (size_t)psOps[i].iKind;
+      dStart = nowNanos();
+      perform(oSymTable, &psOps[i], ppcKeys[i]);
+      apdLatencies[uKind][auKindCounts[uKind]++] = nowNanos() - dStart;
+   }
+   SymTable_free(oSymTable);
+
+   printf("latency in ns, including about %.0f ns to read the clock:\n",
+      dOverhead);
+   printf("%-9s %10s %10s %8s %8s %8s %8s %8s\n", "operation", "count",
+      "hits", "p50", "p90", "p99", "p99.9", "max");
+   for (uKind = 1; uKind < SYMTABLE_TRACE_PRELOAD; uKind++)
+   {
+      size_t uKindCount = auKindCounts[uKind];
+      double *pdKind = apdLatencies[uKind];
+
+      if (uKindCount == 0)
+         continue;
+      qsort(pdKind, uKindCount, sizeof(double), compareDoubles);
+      printf("%-9s %10lu %10lu %8.0f %8.0f %8.0f %8.0f %8.0f\n",
+         apcKindNames[uKind], (unsigned long)uKindCount,
+         (unsigned long)auHits[uKind], percentile(pdKind, uKindCount, 0.5),
+         percentile(pdKind, uKindCount, 0.9),
+         percentile(pdKind, uKindCount, 0.99),
+         percentile(pdKind, uKindCount, 0.999), pdKind[uKindCount - 1]);
+   }
+
+   free(pdLatencies);
+   free(pcKeys);
+   free(ppcKeys);
+   free(psOps);
+   return 0;
+}
+
+/*--------------------------------------------------------------------*/
@@ -49,5 +49,311 @@ void SymTable_map(SymTable_T oSymTable,
      void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
      const void *pvExtra);
 
+/*return a new SymTable object holding a copy of every binding in oSymTable
+  (keys are copied, values are shared), or NULL if insufficient memory is available.
+  Changes to either table afterwards do not affect the other.*/
+SymTable_T SymTable_clone(SymTable_T oSymTable);
+
+/*--------------------------------------------------------------------*/
+/* The functions below are provided by symtablelist.c and            */
+/* symtablehash.c.                                                    */
+/*--------------------------------------------------------------------*/
+
+/*return a new SymTable object that contains no bindings and is sized
+  to take about uExpected bindings without growing, or NULL if
+  insufficient memory is available. symtablehash.c also allocates the
+  first uExpected nodes in one piece, released only with the table.*/
+SymTable_T SymTable_newSized(size_t uExpected);
+
+/*make oSymTable call pfRelease(pvResource) when it is freed, tying the
+  lifetime of storage its borrowed keys or values point into (see
+  SymTable_putBorrowed) to the table. Return 1, or 0 if insufficient
+  memory is available, in which case nothing is adopted.*/
+int SymTable_adopt(SymTable_T oSymTable, void *pvResource,
+    void (*pfRelease)(void *pvResource));
+
+/*remove every binding from oSymTable without freeing the table, for
+  reuse. Its buckets or arrays stay allocated, and symtablehash.c keeps
+  the nodes, key buffers and expiry timers on free lists that later
+  puts draw from first, so a table refilled to about the same size
+  allocates nothing. symtablelist.c holds its bindings in its entry
+  array, so refilling it allocates only key copies. Clearing takes time
+  proportional to the bindings, not constant time: symtablehash.c moves
+  each node to its free list, since a generation counter would instead
+  add a check to every lookup, growth and map. No eviction or expiry
+  callback is called.*/
+void SymTable_clear(SymTable_T oSymTable);
+
+/*remove from oSymTable every binding for which pfTest(pcKey, pvValue,
+  pvExtra) returns nonzero, in one sweep that neither hashes keys nor
+  allocates, and return the number removed. Unless pfRemoved is NULL,
+  each removed binding's key and value are then passed to pfRemoved
+  with pvExtra before the key is freed. Neither function may change
+  oSymTable.*/
+size_t SymTable_removeIf(SymTable_T oSymTable,
+    int (*pfTest)(const char *pcKey, void *pvValue, void *pvExtra),
+    void (*pfRemoved)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra);
+
+/*how SymTable_merge settles a key bound in both tables: keep the
+  destination's value, or replace it with the source's*/
+enum {SYMTABLE_MERGE_KEEP = 0, SYMTABLE_MERGE_REPLACE = 1};
+
+/*move every binding of oSrc into oDst, leaving oSrc empty, and return
+  the number of keys bound in both. Nodes (or entries) and keys change
+  hands rather than being copied, oDst grows at most once, and blocks
+  and resources oSrc adopted go with them. A key bound in both keeps
+  oDst's value if iPolicy is SYMTABLE_MERGE_KEEP, or takes oSrc's if it
+  is SYMTABLE_MERGE_REPLACE; the other value is dropped, after being
+  passed with the key and pvExtra to pfDropped unless pfDropped is NULL.
+  Bindings of oSrc that have expired are reclaimed, through oSrc's
+  pfExpire, rather than moved. Pending expiries keep the time they had
+  left, so oDst must be expiring if oSrc has any, and both tables must
+  share an intern pool or have none. A bounded oDst then evicts down to
+  its limit, through its pfEvict. pfDropped must not change either
+  table. If symtablelist.c cannot make room for every binding first,
+  nothing moves and 0 is returned, with oSrc still nonempty.*/
+size_t SymTable_merge(SymTable_T oDst, SymTable_T oSrc, int iPolicy,
+    void (*pfDropped)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra);
+
+/*call pfApply(pcKey, pvValue, pvExtra) for each binding of oA whose
+  key oB does not contain. Neither table may change meanwhile, and
+  neither is changed: no binding moves to the front, none is reclaimed
+  and no SymTableStats counter changes. Cached hash codes (or tags) are
+  reused, so no key is hashed again, and symtablehash.c walks the
+  matching buckets of the two tables in lockstep when they have the
+  same bucket count.*/
+void SymTable_diff(SymTable_T oA, SymTable_T oB,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra);
+
+/*as SymTable_diff, but call pfApply(pcKey, pvValueA, pvValueB, pvExtra)
+  for each key both oA and oB contain, with its value in each*/
+void SymTable_intersectMap(SymTable_T oA, SymTable_T oB,
+    void (*pfApply)(const char *pcKey, void *pvValueA, void *pvValueB,
+        void *pvExtra),
+    const void *pvExtra);
+
+/*add to oDst a binding, with a copy of the key, for each binding of
+  oSrc whose key oDst does not contain; oSrc is unchanged, and keys of
+  oDst keep their values. Cached hash codes (or tags) are reused, and
+  oDst looked up without side effects, as in SymTable_diff, except that
+  an expired binding of a key being added is first reclaimed. Return 1,
+  or 0 if insufficient memory is available, in which case only some of
+  the bindings may have been added.*/
+int SymTable_unionInto(SymTable_T oDst, SymTable_T oSrc);
+
+/*give oSymTable a negative-lookup filter, a blocked Bloom filter over
+  its keys' hash codes, so that most lookups of absent keys are answered
+  from one 32-byte block without walking a chain. The filter takes 2
+  bytes per bucket and is rebuilt when the table grows or removed keys
+  clog it. Return 1, or 0 if insufficient memory is available, in which
+  case the table works as before. symtablelist.c has no filter and just
+  returns 1.*/
+int SymTable_addFilter(SymTable_T oSymTable);
+
+/*if iEnable is nonzero, make every lookup in oSymTable that finds its
+  key move the binding to the front of its chain (symtablehash.c) or of
+  the array (symtablelist.c), so keys looked up often are found first;
+  if it is 0, stop. Lookups then change the table: an address from
+  SymTable_slot lasts only until the next lookup, and lookups must not
+  run concurrently with SymTable_incrementAtomic.*/
+void SymTable_setMoveToFront(SymTable_T oSymTable, int iEnable);
+
+/*give oSymTable a reverse index from value pointers to bindings, kept
+  up to date by every put, replace, remove, eviction and expiry in
+  O(1) expected time, however many bindings share a value. The index
+  is open-addressed over the distinct values and at most half full,
+  costing 16 to 32 bytes per distinct value; the bindings sharing a
+  value are kept in a ring, through two pointers that every node of
+  symtablehash.c carries. SymTable_findKeyByValue then takes O(1)
+  expected time instead of a scan, plus a step for each expired binding
+  with the value that is still awaiting reclamation. Expanding the
+  table leaves the index alone. SymTable_slot changes values behind its
+  back, so calling it on the table drops the index, as does running out
+  of memory to grow it; SymTable_incrementAtomic must not be called on
+  an indexed table. Return 1, or 0 if insufficient memory is available,
+  in which case the table works as before.
+  symtablelist.c has no index and just returns 1.*/
+int SymTable_addReverseIndex(SymTable_T oSymTable);
+
+/*return the key of a binding in oSymTable whose value is pvValue (any
+  one of them, if there are several), or NULL if there is none. Without
+  a reverse index the bindings are scanned.*/
+const char *SymTable_findKeyByValue(SymTable_T oSymTable, const void *pvValue);
+
+/*struct storing a pool of interned keys (symtableintern.c)*/
+struct SymTableInterns;
+/*SymTableInterns_T stores pointer to SymTableInterns struct*/
+typedef struct SymTableInterns *SymTableInterns_T;
+
+/*return a new intern pool holding no keys, or NULL if insufficient
+  memory is available*/
+SymTableInterns_T SymTableInterns_new(void);
+
+/*free all memory occupied by oInterns, which every table made against
+  it must already have been freed*/
+void SymTableInterns_free(SymTableInterns_T oInterns);
+
+/*return the number of distinct keys oInterns holds for its tables*/
+size_t SymTableInterns_getLength(SymTableInterns_T oInterns);
+
+/*return a new, empty SymTable object whose keys are kept in oInterns
+  rather than copied, or NULL if insufficient memory is available. All
+  tables made against one pool share a single reference-counted copy of
+  each key, freed when the last binding of it goes, and compare keys by
+  address once a lookup has found the pool's copy; a key the pool lacks
+  is a miss at once. SymTable_putBorrowed interns its key too. The pool
+  is not locked: its tables must be used from one thread at a time.*/
+SymTable_T SymTable_newInterned(SymTableInterns_T oInterns);
+
+/*return a new, empty SymTable object that holds at most uMaxBindings
+  bindings, or NULL if insufficient memory is available. When
+  SymTable_put adds a binding to a full table, the table first evicts
+  a binding not used recently (approximate LRU, CLOCK algorithm),
+  passing its key, value and pvExtra to pfEvict unless pfEvict is NULL;
+  pfEvict runs in the middle of SymTable_put and must not change the
+  table.
+  SymTable_get, SymTable_contains and SymTable_replace count as uses.*/
+SymTable_T SymTable_newBounded(size_t uMaxBindings,
+    void (*pfEvict)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra);
+
+/*as SymTable_put, but store pcKey itself rather than a copy: the
+  table never copies or frees it, so it must stay valid and unchanged
+  for as long as the binding is in oSymTable. Suits keys that already
+  live in long-lived storage (string pools, mapped files, literals).*/
+int SymTable_putBorrowed(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue);
+
+/*SymTable_putBorrowed each of the uCount keys in ppcKeys with the
+  matching value in ppvValues, skipping keys already present. Return 1,
+  or 0 if insufficient memory is available, in which case only some of
+  the bindings may have been added. symtablehash.c hashes keys a few
+  at a time and prefetches their buckets, overlapping the cache misses
+  that dominate loading a large table.*/
+int SymTable_putBorrowedBatch(SymTable_T oSymTable,
+    const char *const *ppcKeys, const void *const *ppvValues, size_t uCount);
+
+/*if oSymTable contains a binding with key pcKey, replace its value
+  with pvValue, else add a new binding of pcKey to pvValue; either way
+  with one lookup. If ppvOldValue is not NULL, store the old value there
+  (NULL if the binding is new). Return 1, or 0 if insufficient memory
+  is available.*/
+int SymTable_upsert(SymTable_T oSymTable, const char *pcKey,
+    const void *pvValue, void **ppvOldValue);
+
+/*return the value of the binding in oSymTable with key pcKey; if there
+  is none, add a binding of pcKey to pvValue and return pvValue. Return
+  NULL if insufficient memory is available.*/
+void *SymTable_getOrPut(SymTable_T oSymTable, const char *pcKey,
+    const void *pvValue);
+
+/*return the address of the value of the binding in oSymTable with key
+  pcKey, first adding a binding of pcKey to NULL if there is none, or
+  NULL if insufficient memory is available. The address is valid until
+  oSymTable is next changed.*/
+void **SymTable_slot(SymTable_T oSymTable, const char *pcKey);
+
+/*add lDelta to the count of the binding in oSymTable with key pcKey,
+  first adding the binding with count 0 if there is none, with one
+  lookup. A count is kept in place of the binding's value pointer, so
+  counting needs no allocation per key; read it with SymTable_getCount.
+  Return 1, or 0 if insufficient memory is available.*/
+int SymTable_increment(SymTable_T oSymTable, const char *pcKey,
+    long lDelta);
+
+/*as SymTable_increment, but the count is updated with an atomic add,
+  so several threads may count into oSymTable at once provided every
+  key is already present and the table is neither bounded nor
+  expiring. Adding keys still needs exclusive access. The lookup of a
+  present key changes nothing else: it does not move the binding to
+  the front or count in SymTableStats. oSymTable must not have a
+  reverse index (SymTable_addReverseIndex), which a count changing
+  underneath it would leave stale.*/
+int SymTable_incrementAtomic(SymTable_T oSymTable, const char *pcKey,
+    long lDelta);
+
+/*return the count of the binding in oSymTable with key pcKey, or 0 if
+  there is no such binding*/
+long SymTable_getCount(SymTable_T oSymTable, const char *pcKey);
+
+/*return a new, empty SymTable object whose bindings may expire, or
+  NULL if insufficient memory is available. The table keeps its own
+  time, which starts at 0 and only moves when the caller passes a later
+  time to SymTable_expire. An expired binding acts as absent at once;
+  it is reclaimed, passing its key, value and pvExtra to pfExpire
+  unless pfExpire is NULL, by SymTable_expire or by the first lookup
+  that finds it. Until then it still counts in SymTable_getLength.
+  pfExpire runs in the middle of those calls and must not change the
+  table.*/
+SymTable_T SymTable_newExpiring(
+    void (*pfExpire)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra);
+
+/*as SymTable_put, but the new binding in expiring table oSymTable
+  expires ulTTL time units after the table's current time, or at time
+  ULONG_MAX if that is sooner. Bindings added with SymTable_put never
+  expire.*/
+int SymTable_putWithTTL(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue, unsigned long ulTTL);
+
+/*advance expiring table oSymTable's time to ulNow (time never moves
+  back) and reclaim at most uMaxReclaim expired bindings. Return the
+  number reclaimed. symtablehash.c keeps pending expiries in a
+  hierarchical timer wheel, whose levels each cover 64 times the span
+  of the one below: a timer moves down a level at most once per level
+  as its expiry nears, and times with nothing due are skipped, so a
+  call costs the bindings reclaimed plus a bounded scan of the wheel,
+  however many far-off expiries are pending or however much time has
+  passed; symtablelist.c scans the whole list.*/
+size_t SymTable_expire(SymTable_T oSymTable, unsigned long ulNow,
+    size_t uMaxReclaim);
+
+#ifdef SYMTABLE_STATS
+/*number of entries in SymTableStats' chain-length histogram*/
+enum {SYMTABLE_STATS_HISTOGRAM = 16};
+
+/*snapshot of the internal state of a SymTable object; only compiled
+  in when SYMTABLE_STATS is defined, so normal builds pay nothing*/
+struct SymTableStats {
+    /*number of buckets (1 for the list implementation)*/
+    size_t uBucketCount;
+    /*bindings per bucket*/
+    double dLoadFactor;
+    /*entry i counts buckets holding i bindings; the last entry counts
+      buckets holding SYMTABLE_STATS_HISTOGRAM-1 or more*/
+    size_t auChainHistogram[SYMTABLE_STATS_HISTOGRAM];
+    /*length of the longest chain*/
+    size_t uMaxChain;
+    /*average keys compared per lookup that found its key, and per
+      lookup that did not, over the table's lifetime*/
+    double dAvgProbesHit;
+    double dAvgProbesMiss;
+    /*number of times the bucket array grew, and CPU seconds spent on it*/
+    size_t uExpansions;
+    double dExpandSeconds;
+    /*bytes used by nodes (none in the cuckoo implementation), by key
+      copies and by the bucket array*/
+    size_t uNodeBytes;
+    size_t uKeyBytes;
+    size_t uBucketBytes;
+    /*bytes used by the filter added with SymTable_addFilter, and the
+      fraction of lookups of absent keys it failed to answer (0 if
+      there is no filter)*/
+    size_t uFilterBytes;
+    double dFilterFalsePositiveRate;
+    /*for the cuckoo implementation, bindings held in the stash rather
+      than a bucket, and keys moved to their other bucket to make room
+      (0 for the others)*/
+    size_t uStashed;
+    size_t uDisplacements;
+};
+
+/*fill *psStats with statistics about oSymTable*/
+void SymTable_getStats(SymTable_T oSymTable, struct SymTableStats *psStats);
+#endif
+
 /*--------------------------------------------------------------------*/
 #endif
\ No newline at end of file
@@ -0,0 +1,582 @@
+/*--------------------------------------------------------------------*/
+/* symtablecuckoo.c                                                   */
+/* Author: Tara Shukla                                                */
+/*--------------------------------------------------------------------*/
+
+#include "symtable.h"
+#include <assert.h>
+#include <stdint.h>
+#ifdef SYMTABLE_STATS
+#include <time.h>
+#endif
+
+/* symtablecuckoo.c implements symtable.h as a bucketized cuckoo hash
+   table. Every key lives in one of the 4 slots of one of exactly two
+   buckets, or in a small stash that is nearly always empty, so a
+   lookup reads two tag words, at most two 64-byte buckets and the
+   stash: its cost is bounded, not just small on average. Inserts make
+   room by moving keys to their other bucket along the shortest path
+   found by breadth-first search. */
+
+/*slots per bucket*/
+enum {BUCKET_SLOTS = 4};
+/*buckets a table starts with; always a power of 2*/
+enum {MIN_BUCKETS = 16};
+/*bindings the stash holds when no displacement path is found*/
+enum {STASH_SLOTS = 4};
+/*buckets the displacement search may visit before giving up*/
+enum {MAX_SEARCH = 256};
+/*hash seeds growing tries at one size before doubling again*/
+enum {MAX_REHASHES = 8};
+/*bytes in a cache line*/
+enum {CACHE_LINE = 64};
+
+/*one bucket; a full bucket of keys and values fills one cache line on
+  machines with 8-byte pointers*/
+struct Bucket {
+    /* The binding keys, NULL in empty slots */
+    char *apcKeys[BUCKET_SLOTS];
+    /*the matching values*/
+    const void *apvValues[BUCKET_SLOTS];
+};
+
+/*a binding kept in the stash*/
+struct Stashed {
+    char *pcKey;
+    const void *pvValue;
+};
+
+/*a bucket reached by the displacement search, and how*/
+struct Step {
+    /*the bucket*/
+    size_t uBucket;
+    /*index of the step whose bucket leads here, or -1 for a start*/
+    int iParent;
+    /*slot in the parent's bucket whose key would move here*/
+    unsigned int uSlot;
+};
+
+/*stores SymTable struct*/
+struct SymTable{
+    /*array of uBucketCount buckets (a power of 2), aligned to a cache
+      line inside the allocation pvBuckets*/
+    struct Bucket *psBuckets;
+    void *pvBuckets;
+    size_t uBucketCount;
+    /*one-byte tag per slot, 0 if the slot is empty, packed 4 to a
+      bucket so a lookup checks a bucket's tags with one load*/
+    unsigned char *pucTags;
+    /*bindings that did not fit, in the first uStashed entries*/
+    struct Stashed asStash[STASH_SLOTS];
+    size_t uStashed;
+    /*seed mixed into every hash; changed when keys will not fit*/
+    uint64_t uSeed;
+    /*len = number of bindings in symboltable*/
+    size_t len;
+#ifdef SYMTABLE_STATS
+    /*lookups that found / did not find their key, and keys compared*/
+    size_t uHits;
+    size_t uHitProbes;
+    size_t uMisses;
+    size_t uMissProbes;
+    /*number of times the table grew, and CPU time spent on it*/
+    size_t uExpansions;
+    clock_t iExpandClocks;
+    /*keys moved to their other bucket to make room*/
+    size_t uDisplacements;
+#endif
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return a hash code for pcKey under seed uSeed, mixed so that all 64
+   bits depend on every character. */
+static uint64_t SymTable_hash(const char *pcKey, uint64_t uSeed)
+{
+   const uint64_t HASH_MULTIPLIER = 65599;
+   size_t u;
+   uint64_t uHash = uSeed;
+
+   assert(pcKey != NULL);
+
+   for (u = 0; pcKey[u] != '\0'; u++)
+      uHash = uHash * HASH_MULTIPLIER + (unsigned char)pcKey[u];
+
+   uHash ^= uHash >> 33;
+   uHash *= UINT64_C(0xff51afd7ed558ccd);
+   uHash ^= uHash >> 33;
+   return uHash;
+}
+
+/*helper: return the tag (1 to 255) of a key with hash code uHash*/
+static unsigned char SymTable_tag(uint64_t uHash){
+    return (unsigned char)((uHash >> 56) % 255 + 1);
+}
+
+/*helper: return the first bucket in oSymTable of a key with hash uHash*/
+static size_t SymTable_firstBucket(SymTable_T oSymTable, uint64_t uHash){
+    return (size_t)uHash & (oSymTable->uBucketCount - 1);
+}
+
+/*helper: return the other bucket in oSymTable of a key with tag ucTag
+  held in bucket uBucket. The tag alone gives the offset, so keys move
+  between their buckets without being hashed again; the offset is odd,
+  so the two buckets always differ.*/
+static size_t SymTable_altBucket(SymTable_T oSymTable, size_t uBucket,
+    unsigned char ucTag){
+    return (uBucket ^ ((size_t)(ucTag * UINT32_C(0x5bd1e995)) | 1))
+        & (oSymTable->uBucketCount - 1);
+}
+
+/*helper: return the index of a slot of bucket uBucket in oSymTable
+  whose tag is ucTag (0 finds an empty slot), starting at slot uFrom,
+  or BUCKET_SLOTS if there is none*/
+static unsigned int SymTable_matchTag(SymTable_T oSymTable, size_t uBucket,
+    unsigned char ucTag, unsigned int uFrom){
+    const unsigned char *pucTags = oSymTable->pucTags + uBucket * BUCKET_SLOTS;
+    unsigned int i;
+
+    for (i = uFrom; i < BUCKET_SLOTS; i++)
+        if (pucTags[i] == ucTag) return i;
+    return BUCKET_SLOTS;
+}
+
+/*helper: return the address of the value slot of pcKey, whose hash is
+  uHash, in oSymTable, or NULL if it is absent. Reads the two buckets'
+  tags, compares keys only where the tags match, then checks the
+  stash.*/
+static const void **SymTable_find(SymTable_T oSymTable, const char *pcKey,
+    uint64_t uHash){
+    unsigned char ucTag = SymTable_tag(uHash);
+    size_t auBuckets[2];
+    unsigned int uSlot;
+    size_t i;
+#ifdef SYMTABLE_STATS
+    size_t uProbes = 0;
+#endif
+
+    auBuckets[0] = SymTable_firstBucket(oSymTable, uHash);
+    auBuckets[1] = SymTable_altBucket(oSymTable, auBuckets[0], ucTag);
+    for (i = 0; i < 2; i++){
+        for (uSlot = SymTable_matchTag(oSymTable, auBuckets[i], ucTag, 0);
+            uSlot < BUCKET_SLOTS;
+            uSlot = SymTable_matchTag(oSymTable, auBuckets[i], ucTag, uSlot + 1)){
+#ifdef SYMTABLE_STATS
+            uProbes++;
+#endif
+            if (strcmp(oSymTable->psBuckets[auBuckets[i]].apcKeys[uSlot], pcKey) == 0){
+#ifdef SYMTABLE_STATS
+                oSymTable->uHits++;
+                oSymTable->uHitProbes += uProbes;
+#endif
+                return &oSymTable->psBuckets[auBuckets[i]].apvValues[uSlot];
+            }
+        }
+    }
+    for (i = 0; i < oSymTable->uStashed; i++){
+#ifdef SYMTABLE_STATS
+        uProbes++;
+#endif
+        if (strcmp(oSymTable->asStash[i].pcKey, pcKey) == 0){
+#ifdef SYMTABLE_STATS
+            oSymTable->uHits++;
+            oSymTable->uHitProbes += uProbes;
+#endif
+            return &oSymTable->asStash[i].pvValue;
+        }
+    }
+#ifdef SYMTABLE_STATS
+    oSymTable->uMisses++;
+    oSymTable->uMissProbes += uProbes;
+#endif
+    return NULL;
+}
+
+/*helper: store key pcKey with tag ucTag and value pvValue in slot
+  uSlot of bucket uBucket of oSymTable*/
+static void SymTable_store(SymTable_T oSymTable, size_t uBucket,
+    unsigned int uSlot, char *pcKey, unsigned char ucTag, const void *pvValue){
+    oSymTable->psBuckets[uBucket].apcKeys[uSlot] = pcKey;
+    oSymTable->psBuckets[uBucket].apvValues[uSlot] = pvValue;
+    oSymTable->pucTags[uBucket * BUCKET_SLOTS + uSlot] = ucTag;
+}
+
+/*helper: place pcKey (hash uHash, absent from oSymTable) bound to
+  pvValue in one of its buckets, displacing other keys to their other
+  buckets if need be. Return 1, or 0 if no path to a free slot was
+  found within MAX_SEARCH buckets, leaving oSymTable unchanged.*/
+static int SymTable_place(SymTable_T oSymTable, char *pcKey, uint64_t uHash,
+    const void *pvValue){
+    struct Step asQueue[MAX_SEARCH];
+    unsigned char ucTag = SymTable_tag(uHash);
+    struct Bucket *psBucket;
+    size_t uHead = 0;
+    size_t uTail = 0;
+    size_t uFree;
+    size_t uAlt;
+    unsigned int uFreeSlot;
+    unsigned int uSlot;
+    unsigned char ucMovedTag;
+    int iStep;
+
+    /*breadth-first search from both buckets for a free slot, so the
+      chain of moves is as short as possible*/
+    asQueue[uTail].uBucket = SymTable_firstBucket(oSymTable, uHash);
+    asQueue[uTail++].iParent = -1;
+    asQueue[uTail].uBucket = SymTable_altBucket(oSymTable, asQueue[0].uBucket, ucTag);
+    asQueue[uTail++].iParent = -1;
+    for (; uHead < uTail; uHead++){
+        uFreeSlot = SymTable_matchTag(oSymTable, asQueue[uHead].uBucket, 0, 0);
+        if (uFreeSlot < BUCKET_SLOTS) break;
+        for (uSlot = 0; uSlot < BUCKET_SLOTS && uTail < MAX_SEARCH; uSlot++){
+            uAlt = SymTable_altBucket(oSymTable, asQueue[uHead].uBucket,
+                oSymTable->pucTags[asQueue[uHead].uBucket * BUCKET_SLOTS + uSlot]);
+            /*a path through the same bucket twice would move a key
+              that is no longer the one the search saw*/
+            for (iStep = (int)uHead; iStep >= 0; iStep = asQueue[iStep].iParent)
+                if (asQueue[iStep].uBucket == uAlt) break;
+            if (iStep >= 0) continue;
+            asQueue[uTail].uBucket = uAlt;
+            asQueue[uTail].iParent = (int)uHead;
+            asQueue[uTail++].uSlot = uSlot;
+        }
+    }
+    if (uHead == uTail) return 0;
+
+    /*walk back along the path, moving each key into the slot freed
+      ahead of it; the slot left at the start takes the new key*/
+    uFree = asQueue[uHead].uBucket;
+    for (iStep = (int)uHead; asQueue[iStep].iParent >= 0;
+        iStep = asQueue[iStep].iParent){
+        uSlot = asQueue[iStep].uSlot;
+        psBucket = &oSymTable->psBuckets[asQueue[asQueue[iStep].iParent].uBucket];
+        ucMovedTag = oSymTable->pucTags[
+            asQueue[asQueue[iStep].iParent].uBucket * BUCKET_SLOTS + uSlot];
+        SymTable_store(oSymTable, uFree, uFreeSlot, psBucket->apcKeys[uSlot],
+            ucMovedTag, psBucket->apvValues[uSlot]);
+        uFree = asQueue[asQueue[iStep].iParent].uBucket;
+        uFreeSlot = uSlot;
+#ifdef SYMTABLE_STATS
+        oSymTable->uDisplacements++;
+#endif
+    }
+    SymTable_store(oSymTable, uFree, uFreeSlot, pcKey, ucTag, pvValue);
+    return 1;
+}
+
+/*helper: give oSymTable uBucketCount empty buckets. Return 1, or 0 if
+  insufficient memory is available, leaving oSymTable unchanged.*/
+static int SymTable_allocBuckets(SymTable_T oSymTable, size_t uBucketCount){
+    void *pvBuckets;
+    unsigned char *pucTags;
+
+    if (uBucketCount > (SIZE_MAX - CACHE_LINE) / sizeof(struct Bucket))
+        return 0;
+    pvBuckets = calloc(1, uBucketCount * sizeof(struct Bucket) + CACHE_LINE);
+    if (pvBuckets == NULL) return 0;
+    pucTags = (unsigned char*)calloc(uBucketCount, BUCKET_SLOTS);
+    if (pucTags == NULL){
+        free(pvBuckets);
+        return 0;
+    }
+    oSymTable->pvBuckets = pvBuckets;
+    oSymTable->psBuckets = (struct Bucket*)((char*)pvBuckets
+        + (CACHE_LINE - (uintptr_t)pvBuckets % CACHE_LINE) % CACHE_LINE);
+    oSymTable->pucTags = pucTags;
+    oSymTable->uBucketCount = uBucketCount;
+    return 1;
+}
+
+/*helper: move every binding of oSymTable into twice as many buckets,
+  rehashing with a new seed whenever keys still will not fit, and
+  doubling again after every MAX_REHASHES seeds that fail. Return 1, or
+  0 if insufficient memory is available, leaving oSymTable unchanged.*/
+static int SymTable_grow(SymTable_T oSymTable){
+    struct SymTable sOld = *oSymTable;
+    struct Bucket *psBucket;
+    size_t uBucketCount = oSymTable->uBucketCount;
+    size_t i;
+    unsigned int uSlot;
+    uint64_t uRehash;
+#ifdef SYMTABLE_STATS
+    clock_t iStart = clock();
+#endif
+
+    for (uRehash = 1; ; uRehash++){
+        if (uRehash % MAX_REHASHES == 1) uBucketCount *= 2;
+        if (!SymTable_allocBuckets(oSymTable, uBucketCount)) break;
+        oSymTable->uStashed = 0;
+        oSymTable->uSeed = sOld.uSeed + uRehash * UINT64_C(0x9e3779b97f4a7c15);
+        for (i = 0; i < sOld.uBucketCount; i++){
+            psBucket = &sOld.psBuckets[i];
+            for (uSlot = 0; uSlot < BUCKET_SLOTS; uSlot++)
+                if (sOld.pucTags[i * BUCKET_SLOTS + uSlot] != 0
+                    && !SymTable_place(oSymTable, psBucket->apcKeys[uSlot],
+                        SymTable_hash(psBucket->apcKeys[uSlot], oSymTable->uSeed),
+                        psBucket->apvValues[uSlot]))
+                    goto retry;
+        }
+        for (i = 0; i < sOld.uStashed; i++)
+            if (!SymTable_place(oSymTable, sOld.asStash[i].pcKey,
+                SymTable_hash(sOld.asStash[i].pcKey, oSymTable->uSeed),
+                sOld.asStash[i].pvValue))
+                goto retry;
+        free(sOld.pvBuckets);
+        free(sOld.pucTags);
+#ifdef SYMTABLE_STATS
+        oSymTable->uExpansions++;
+        oSymTable->iExpandClocks += clock() - iStart;
+#endif
+        return 1;
+retry:
+        free(oSymTable->pvBuckets);
+        free(oSymTable->pucTags);
+    }
+    *oSymTable = sOld;
+    return 0;
+}
+
+/*helper: after a removal, move stashed bindings of oSymTable into any
+  bucket slot that has come free, so lookups rarely need the stash*/
+static void SymTable_drainStash(SymTable_T oSymTable){
+    size_t i = 0;
+
+    while (i < oSymTable->uStashed){
+        if (SymTable_place(oSymTable, oSymTable->asStash[i].pcKey,
+            SymTable_hash(oSymTable->asStash[i].pcKey, oSymTable->uSeed),
+            oSymTable->asStash[i].pvValue))
+            oSymTable->asStash[i] = oSymTable->asStash[--oSymTable->uStashed];
+        else i++;
+    }
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_new(void){
+    SymTable_T oSymTable;
+    oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+    if (oSymTable==NULL){
+        return NULL;
+    }
+    if (!SymTable_allocBuckets(oSymTable, MIN_BUCKETS)){
+        free(oSymTable);
+        return NULL;
+    }
+    oSymTable->uStashed = 0;
+    oSymTable->uSeed = 0;
+    oSymTable->len = 0;
+#ifdef SYMTABLE_STATS
+    oSymTable->uHits = oSymTable->uHitProbes = 0;
+    oSymTable->uMisses = oSymTable->uMissProbes = 0;
+    oSymTable->uExpansions = 0;
+    oSymTable->iExpandClocks = 0;
+    oSymTable->uDisplacements = 0;
+#endif
+    return oSymTable;
+}
+
+void SymTable_free(SymTable_T oSymTable){
+    size_t i;
+
+    assert(oSymTable != NULL);
+
+    for (i = 0; i < oSymTable->uBucketCount * BUCKET_SLOTS; i++)
+        if (oSymTable->pucTags[i] != 0)
+            free(oSymTable->psBuckets[i / BUCKET_SLOTS].apcKeys[i % BUCKET_SLOTS]);
+    for (i = 0; i < oSymTable->uStashed; i++)
+        free(oSymTable->asStash[i].pcKey);
+    free(oSymTable->pvBuckets);
+    free(oSymTable->pucTags);
+    free(oSymTable);
+}
+
+size_t SymTable_getLength(SymTable_T oSymTable){
+    assert(oSymTable!=NULL);
+    return oSymTable->len;
+}
+
+int SymTable_put(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue){
+    char *pcKeyCopy;
+    uint64_t uHash;
+
+    assert(oSymTable != NULL);
+    assert(pcKey!=NULL);
+
+    uHash = SymTable_hash(pcKey, oSymTable->uSeed);
+    if (SymTable_find(oSymTable, pcKey, uHash) != NULL) return 0;
+
+    pcKeyCopy = (char*)malloc(strlen(pcKey) + 1);
+    if (pcKeyCopy == NULL) return 0;
+    strcpy(pcKeyCopy, pcKey);
+
+    /*no path to a free slot: stash the binding if there is room, else
+      grow (which may change the seed) and try again*/
+    while (!SymTable_place(oSymTable, pcKeyCopy, uHash, pvValue)){
+        if (oSymTable->uStashed < STASH_SLOTS){
+            oSymTable->asStash[oSymTable->uStashed].pcKey = pcKeyCopy;
+            oSymTable->asStash[oSymTable->uStashed++].pvValue = pvValue;
+            break;
+        }
+        if (!SymTable_grow(oSymTable)){
+            free(pcKeyCopy);
+            return 0;
+        }
+        uHash = SymTable_hash(pcKey, oSymTable->uSeed);
+    }
+    oSymTable->len++;
+    return 1;
+}
+
+void *SymTable_replace(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue){
+    const void **ppvValue;
+    const void *oldVal;
+
+    assert(oSymTable!=NULL);
+    assert(pcKey!=NULL);
+
+    ppvValue = SymTable_find(oSymTable, pcKey,
+        SymTable_hash(pcKey, oSymTable->uSeed));
+    if (ppvValue == NULL) return NULL;
+    oldVal = *ppvValue;
+    *ppvValue = pvValue;
+    return (void*)oldVal;
+}
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey){
+    assert(oSymTable!=NULL);
+    assert(pcKey!=NULL);
+
+    return SymTable_find(oSymTable, pcKey,
+        SymTable_hash(pcKey, oSymTable->uSeed)) != NULL;
+}
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey){
+    const void **ppvValue;
+
+    assert(oSymTable!=NULL);
+    assert(pcKey!=NULL);
+
+    ppvValue = SymTable_find(oSymTable, pcKey,
+        SymTable_hash(pcKey, oSymTable->uSeed));
+    if (ppvValue == NULL) return NULL;
+    return (void*)*ppvValue;
+}
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey){
+    const void **ppvValue;
+    const void *val;
+    size_t uOffset;
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(pcKey!=NULL);
+
+    ppvValue = SymTable_find(oSymTable, pcKey,
+        SymTable_hash(pcKey, oSymTable->uSeed));
+    if (ppvValue == NULL) return NULL;
+    val = *ppvValue;
+
+    /*the value's address tells whether it is in a bucket or the stash*/
+    if ((const char*)ppvValue >= (const char*)oSymTable->asStash
+        && (const char*)ppvValue < (const char*)(oSymTable->asStash + STASH_SLOTS)){
+        i = (size_t)((const char*)ppvValue - (const char*)oSymTable->asStash)
+            / sizeof(struct Stashed);
+        free(oSymTable->asStash[i].pcKey);
+        oSymTable->asStash[i] = oSymTable->asStash[--oSymTable->uStashed];
+    }
+    else {
+        uOffset = (size_t)((const char*)ppvValue - (const char*)oSymTable->psBuckets);
+        i = uOffset / sizeof(struct Bucket);
+        uOffset = (uOffset % sizeof(struct Bucket)
+            - offsetof(struct Bucket, apvValues)) / sizeof(const void*);
+        free(oSymTable->psBuckets[i].apcKeys[uOffset]);
+        oSymTable->psBuckets[i].apcKeys[uOffset] = NULL;
+        oSymTable->pucTags[i * BUCKET_SLOTS + uOffset] = 0;
+        if (oSymTable->uStashed > 0) SymTable_drainStash(oSymTable);
+    }
+    oSymTable->len--;
+    return (void*)val;
+}
+
+void SymTable_map(SymTable_T oSymTable,
+     void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+     const void *pvExtra)
+{
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(pfApply!=NULL);
+
+    for (i = 0; i < oSymTable->uBucketCount * BUCKET_SLOTS; i++)
+        if (oSymTable->pucTags[i] != 0)
+            (*pfApply)(oSymTable->psBuckets[i / BUCKET_SLOTS].apcKeys[i % BUCKET_SLOTS],
+                (void*)oSymTable->psBuckets[i / BUCKET_SLOTS].apvValues[i % BUCKET_SLOTS],
+                (void*)pvExtra);
+    for (i = 0; i < oSymTable->uStashed; i++)
+        (*pfApply)(oSymTable->asStash[i].pcKey,
+            (void*)oSymTable->asStash[i].pvValue, (void*)pvExtra);
+}
+
+/*map function: put a copy of binding pcKey/pvValue in the clone
+  pvExtra points to, clearing it on failure*/
+static void SymTable_copyBinding(const char *pcKey, void *pvValue,
+    void *pvExtra){
+    SymTable_T *poClone = (SymTable_T*)pvExtra;
+
+    if (*poClone != NULL && !SymTable_put(*poClone, pcKey, pvValue)){
+        SymTable_free(*poClone);
+        *poClone = NULL;
+    }
+}
+
+SymTable_T SymTable_clone(SymTable_T oSymTable){
+    SymTable_T oClone;
+
+    assert(oSymTable != NULL);
+
+    oClone = SymTable_new();
+    SymTable_map(oSymTable, SymTable_copyBinding, &oClone);
+    return oClone;
+}
+
+#ifdef SYMTABLE_STATS
+void SymTable_getStats(SymTable_T oSymTable, struct SymTableStats *psStats){
+    size_t uChain;
+    size_t i;
+    unsigned int uSlot;
+
+    assert(oSymTable != NULL);
+    assert(psStats != NULL);
+
+    memset(psStats, 0, sizeof(struct SymTableStats));
+    psStats->uBucketCount = oSymTable->uBucketCount;
+    psStats->dLoadFactor = (double)oSymTable->len / (double)oSymTable->uBucketCount;
+    for (i = 0; i < oSymTable->uBucketCount; i++){
+        uChain = 0;
+        for (uSlot = 0; uSlot < BUCKET_SLOTS; uSlot++)
+            if (oSymTable->pucTags[i * BUCKET_SLOTS + uSlot] != 0){
+                uChain++;
+                psStats->uKeyBytes += strlen(oSymTable->psBuckets[i].apcKeys[uSlot]) + 1;
+            }
+        if (uChain > psStats->uMaxChain) psStats->uMaxChain = uChain;
+        psStats->auChainHistogram[uChain]++;
+    }
+    for (i = 0; i < oSymTable->uStashed; i++)
+        psStats->uKeyBytes += strlen(oSymTable->asStash[i].pcKey) + 1;
+    if (oSymTable->uHits > 0)
+        psStats->dAvgProbesHit = (double)oSymTable->uHitProbes / (double)oSymTable->uHits;
+    if (oSymTable->uMisses > 0)
+        psStats->dAvgProbesMiss = (double)oSymTable->uMissProbes / (double)oSymTable->uMisses;
+    psStats->uExpansions = oSymTable->uExpansions;
+    psStats->dExpandSeconds = (double)oSymTable->iExpandClocks / CLOCKS_PER_SEC;
+    /*bindings live in the buckets and the stash, not in nodes*/
+    psStats->uBucketBytes = oSymTable->uBucketCount
+        * (sizeof(struct Bucket) + BUCKET_SLOTS);
+    psStats->uStashed = oSymTable->uStashed;
+    psStats->uDisplacements = oSymTable->uDisplacements;
+}
+#endif
+
+/*--------------------------------------------------------------------*/
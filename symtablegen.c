@@ -0,0 +1,371 @@
+/*--------------------------------------------------------------------*/
+/* symtablegen.c                                                      */
+/* Author: Tara Shukla                                                */
+/*--------------------------------------------------------------------*/
+
+/* Read a key/value list from stdin and write to stdout a C source file
+   that defines a constant, perfect-hashed struct SymTableStatic (see
+   symtablestatic.h). Each input line is a key, optionally followed by
+   a tab and a string value; blank lines and lines starting with '#'
+   are ignored. With -h, write the matching header instead.
+
+   The slots and seeds depend on SymTableStatic_hash, which works in
+   size_t arithmetic, so a generated table is valid only where size_t
+   is as wide as on the machine that ran symtablegen; the source it
+   writes fails to compile elsewhere. */
+
+#include "symtablestatic.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <assert.h>
+#include <limits.h>
+
+/*average number of keys per first-level bucket*/
+enum {KEYS_PER_BUCKET = 3};
+/*seeds tried for one bucket before the slot array is enlarged*/
+enum {MAX_SEED = 1 << 16};
+
+/*one input binding plus its first-level bucket*/
+struct Entry {
+    /*the binding key*/
+    char *pcKey;
+    /*the matching value, or NULL if the line had no tab*/
+    char *pcValue;
+    /*first-level bucket the key hashes to*/
+    size_t uBucket;
+};
+
+/*a first-level bucket: the entries that hash to it*/
+struct Bucket {
+    /*index of the bucket in the seed array*/
+    size_t uIndex;
+    /*number of entries in the bucket*/
+    size_t uSize;
+    /*index of the bucket's first entry in the sorted entry array*/
+    size_t uFirst;
+};
+
+/*--------------------------------------------------------------------*/
+
+/*print message pcMessage to stderr and exit with EXIT_FAILURE*/
+static void die(const char *pcMessage)
+{
+    fprintf(stderr, "symtablegen: %s\n", pcMessage);
+    exit(EXIT_FAILURE);
+}
+
+/*return a malloc'd copy of the uLength chars at pc, NUL-terminated*/
+static char *copyString(const char *pc, size_t uLength)
+{
+    char *pcCopy = (char*)malloc(uLength + 1);
+    if (pcCopy == NULL) die("insufficient memory");
+    memcpy(pcCopy, pc, uLength);
+    pcCopy[uLength] = '\0';
+    return pcCopy;
+}
+
+/*read all of stdin into a malloc'd NUL-terminated buffer*/
+static char *readInput(void)
+{
+    size_t uCap = 4096;
+    size_t uLen = 0;
+    size_t uRead;
+    char *pcBuf = (char*)malloc(uCap);
+
+    if (pcBuf == NULL) die("insufficient memory");
+    while ((uRead = fread(pcBuf + uLen, 1, uCap - uLen - 1, stdin)) > 0){
+        uLen += uRead;
+        if (uCap - uLen - 1 == 0){
+            uCap *= 2;
+            pcBuf = (char*)realloc(pcBuf, uCap);
+            if (pcBuf == NULL) die("insufficient memory");
+        }
+    }
+    pcBuf[uLen] = '\0';
+    return pcBuf;
+}
+
+/*split pcInput into entries; store the count in *puCount*/
+static struct Entry *parseEntries(char *pcInput, size_t *puCount)
+{
+    struct Entry *psEntries = NULL;
+    size_t uCount = 0;
+    size_t uCap = 0;
+    char *pcLine = pcInput;
+    char *pcEnd;
+    char *pcTab;
+    size_t uLineLen;
+
+    while (*pcLine != '\0'){
+        pcEnd = strchr(pcLine, '\n');
+        if (pcEnd == NULL) pcEnd = pcLine + strlen(pcLine);
+        uLineLen = (size_t)(pcEnd - pcLine);
+        if (uLineLen > 0 && pcLine[uLineLen - 1] == '\r') uLineLen--;
+
+        if (uLineLen > 0 && pcLine[0] != '#'){
+            if (uCount == uCap){
+                uCap = uCap == 0 ? 64 : uCap * 2;
+                psEntries = (struct Entry*)realloc(psEntries,
+                    uCap * sizeof(struct Entry));
+                if (psEntries == NULL) die("insufficient memory");
+            }
+            pcTab = (char*)memchr(pcLine, '\t', uLineLen);
+            if (pcTab == NULL){
+                psEntries[uCount].pcKey = copyString(pcLine, uLineLen);
+                psEntries[uCount].pcValue = NULL;
+            }
+            else {
+                psEntries[uCount].pcKey =
+                    copyString(pcLine, (size_t)(pcTab - pcLine));
+                psEntries[uCount].pcValue = copyString(pcTab + 1,
+                    uLineLen - (size_t)(pcTab - pcLine) - 1);
+            }
+            uCount++;
+        }
+        pcLine = (*pcEnd == '\n') ? pcEnd + 1 : pcEnd;
+    }
+    *puCount = uCount;
+    return psEntries;
+}
+
+/*qsort comparison: order entries by bucket, then key*/
+static int compareEntries(const void *pv1, const void *pv2)
+{
+    const struct Entry *ps1 = (const struct Entry*)pv1;
+    const struct Entry *ps2 = (const struct Entry*)pv2;
+    if (ps1->uBucket != ps2->uBucket)
+        return ps1->uBucket < ps2->uBucket ? -1 : 1;
+    return strcmp(ps1->pcKey, ps2->pcKey);
+}
+
+/*qsort comparison: order buckets largest first*/
+static int compareBuckets(const void *pv1, const void *pv2)
+{
+    const struct Bucket *ps1 = (const struct Bucket*)pv1;
+    const struct Bucket *ps2 = (const struct Bucket*)pv2;
+    if (ps1->uSize != ps2->uSize)
+        return ps1->uSize > ps2->uSize ? -1 : 1;
+    return ps1->uIndex < ps2->uIndex ? -1 : 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+/*find a seed for every bucket so that all uCount entries land in
+  distinct slots out of uSlotCount. Fill puSeeds and puSlotOf (the
+  slot of each entry). Return 1 on success, 0 if some bucket could not
+  be placed.*/
+static int placeBuckets(const struct Entry *psEntries,
+    const struct Bucket *psBuckets, size_t uBucketCount,
+    size_t uSlotCount, size_t *puSeeds, size_t *puSlotOf)
+{
+    unsigned char *pucUsed;
+    size_t b;
+    size_t i;
+    size_t j;
+    size_t uSeed;
+    size_t uSlot;
+    int iOk;
+
+    pucUsed = (unsigned char*)calloc(uSlotCount, 1);
+    if (pucUsed == NULL) die("insufficient memory");
+
+    for (b = 0; b < uBucketCount && psBuckets[b].uSize > 0; b++){
+        for (uSeed = 1; uSeed < MAX_SEED; uSeed++){
+            iOk = 1;
+            for (i = 0; i < psBuckets[b].uSize && iOk; i++){
+                uSlot = SymTableStatic_hash(
+                    psEntries[psBuckets[b].uFirst + i].pcKey, uSeed)
+                    % uSlotCount;
+                if (pucUsed[uSlot]) iOk = 0;
+                for (j = 0; j < i && iOk; j++){
+                    if (puSlotOf[psBuckets[b].uFirst + j] == uSlot) iOk = 0;
+                }
+                puSlotOf[psBuckets[b].uFirst + i] = uSlot;
+            }
+            if (iOk) break;
+        }
+        if (uSeed == MAX_SEED){
+            free(pucUsed);
+            return 0;
+        }
+        puSeeds[psBuckets[b].uIndex] = uSeed;
+        for (i = 0; i < psBuckets[b].uSize; i++)
+            pucUsed[puSlotOf[psBuckets[b].uFirst + i]] = 1;
+    }
+    free(pucUsed);
+    return 1;
+}
+
+/*write pc to stdout as a C string literal, escaping as needed; '?' is
+  escaped too, so that no run of the key reads as a trigraph*/
+static void writeLiteral(const char *pc)
+{
+    putchar('"');
+    for (; *pc != '\0'; pc++){
+        unsigned char uc = (unsigned char)*pc;
+        if (uc == '"' || uc == '\\' || uc == '?') printf("\\%c", uc);
+        else if (uc < 0x20 || uc >= 0x7f) printf("\\%03o", uc);
+        else putchar(uc);
+    }
+    putchar('"');
+}
+
+/*return 1 if pc is a C identifier, so it can name the table and the
+  arrays and include guard made from it, else 0*/
+static int isIdentifier(const char *pc)
+{
+    if (!isalpha((unsigned char)*pc) && *pc != '_') return 0;
+    for (pc++; *pc != '\0'; pc++)
+        if (!isalnum((unsigned char)*pc) && *pc != '_') return 0;
+    return 1;
+}
+
+/*write the header declaring table pcName*/
+static void writeHeader(const char *pcName)
+{
+    printf("/* Generated by symtablegen; do not edit. */\n");
+    printf("#ifndef %s_GENERATED_INCLUDED\n", pcName);
+    printf("#define %s_GENERATED_INCLUDED\n", pcName);
+    printf("#include \"symtablestatic.h\"\n\n");
+    printf("extern const struct SymTableStatic %s;\n\n", pcName);
+    printf("#endif\n");
+}
+
+/*write the definition of table pcName*/
+static void writeSource(const char *pcName, const struct Entry *psEntries,
+    size_t uCount, const size_t *puSeeds, size_t uBucketCount,
+    const size_t *puSlotOf, size_t uSlotCount)
+{
+    size_t *puEntryAt;
+    size_t i;
+
+    puEntryAt = (size_t*)malloc(uSlotCount * sizeof(size_t));
+    if (puEntryAt == NULL) die("insufficient memory");
+    for (i = 0; i < uSlotCount; i++) puEntryAt[i] = uCount;
+    for (i = 0; i < uCount; i++) puEntryAt[puSlotOf[i]] = i;
+
+    printf("/* Generated by symtablegen; do not edit. */\n");
+    printf("#include \"symtablestatic.h\"\n");
+    printf("#include <limits.h>\n\n");
+
+    /*the layout holds only for a size_t as wide as this one*/
+    printf("typedef char ac%sSizeCheck[sizeof(size_t) * CHAR_BIT == %lu"
+        " ? 1 : -1];\n\n", pcName, (unsigned long)(sizeof(size_t) * CHAR_BIT));
+
+    printf("static const struct SymTableStaticBinding as%sSlots[] = {\n",
+        pcName);
+    for (i = 0; i < uSlotCount; i++){
+        printf("   {");
+        if (puEntryAt[i] == uCount) printf("NULL, NULL");
+        else {
+            writeLiteral(psEntries[puEntryAt[i]].pcKey);
+            printf(", ");
+            if (psEntries[puEntryAt[i]].pcValue == NULL) printf("NULL");
+            else writeLiteral(psEntries[puEntryAt[i]].pcValue);
+        }
+        printf("}%s\n", i + 1 < uSlotCount ? "," : "");
+    }
+    printf("};\n\n");
+
+    printf("static const size_t au%sSeeds[] = {", pcName);
+    for (i = 0; i < uBucketCount; i++){
+        if (i % 8 == 0) printf("\n  ");
+        printf(" %lu%s", (unsigned long)puSeeds[i],
+            i + 1 < uBucketCount ? "," : "");
+    }
+    printf("\n};\n\n");
+
+    printf("const struct SymTableStatic %s = {\n", pcName);
+    printf("   as%sSlots, %lu, au%sSeeds, %lu, %lu\n};\n", pcName,
+        (unsigned long)uSlotCount, pcName, (unsigned long)uBucketCount,
+        (unsigned long)uCount);
+
+    free(puEntryAt);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Generate a static table named argv[argc-1] from stdin. If argv[1]
+   is "-h", write the header instead of the source file. Exit with
+   EXIT_FAILURE on bad usage, a table name that is not a C identifier,
+   duplicate keys or insufficient memory. */
+
+int main(int argc, char *argv[])
+{
+    const char *pcName;
+    char *pcInput;
+    struct Entry *psEntries;
+    struct Bucket *psBuckets;
+    size_t *puSeeds;
+    size_t *puSlotOf;
+    size_t uCount;
+    size_t uBucketCount;
+    size_t uSlotCount;
+    size_t i;
+
+    if (argc == 3 && strcmp(argv[1], "-h") == 0){
+        if (!isIdentifier(argv[2])) die("table name is not a C identifier");
+        writeHeader(argv[2]);
+        return 0;
+    }
+    if (argc != 2){
+        fprintf(stderr, "Usage: %s [-h] tablename < input\n", argv[0]);
+        exit(EXIT_FAILURE);
+    }
+    pcName = argv[1];
+    if (!isIdentifier(pcName)) die("table name is not a C identifier");
+
+    pcInput = readInput();
+    psEntries = parseEntries(pcInput, &uCount);
+    free(pcInput);
+
+    uBucketCount = uCount / KEYS_PER_BUCKET + 1;
+    for (i = 0; i < uCount; i++)
+        psEntries[i].uBucket =
+            SymTableStatic_hash(psEntries[i].pcKey, 0) % uBucketCount;
+    if (uCount > 0)
+        qsort(psEntries, uCount, sizeof(struct Entry), compareEntries);
+    for (i = 1; i < uCount; i++){
+        if (psEntries[i].uBucket == psEntries[i-1].uBucket
+            && strcmp(psEntries[i].pcKey, psEntries[i-1].pcKey) == 0){
+            fprintf(stderr, "symtablegen: duplicate key \"%s\"\n",
+                psEntries[i].pcKey);
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    psBuckets = (struct Bucket*)calloc(uBucketCount, sizeof(struct Bucket));
+    puSeeds = (size_t*)calloc(uBucketCount, sizeof(size_t));
+    puSlotOf = (size_t*)calloc(uCount + 1, sizeof(size_t));
+    if (psBuckets == NULL || puSeeds == NULL || puSlotOf == NULL)
+        die("insufficient memory");
+    for (i = 0; i < uBucketCount; i++) psBuckets[i].uIndex = i;
+    for (i = uCount; i > 0; i--){
+        psBuckets[psEntries[i-1].uBucket].uSize++;
+        psBuckets[psEntries[i-1].uBucket].uFirst = i - 1;
+    }
+    qsort(psBuckets, uBucketCount, sizeof(struct Bucket), compareBuckets);
+
+    /*start minimal; enlarge the slot array if a bucket cannot be placed*/
+    uSlotCount = uCount > 0 ? uCount : 1;
+    while (!placeBuckets(psEntries, psBuckets, uBucketCount, uSlotCount,
+        puSeeds, puSlotOf))
+        uSlotCount += uSlotCount / 8 + 1;
+
+    writeSource(pcName, psEntries, uCount, puSeeds, uBucketCount,
+        puSlotOf, uSlotCount);
+
+    for (i = 0; i < uCount; i++){
+        free(psEntries[i].pcKey);
+        free(psEntries[i].pcValue);
+    }
+    free(psEntries);
+    free(psBuckets);
+    free(puSeeds);
+    free(puSlotOf);
+    return 0;
+}
+
+/*--------------------------------------------------------------------*/
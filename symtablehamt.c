@@ -0,0 +1,600 @@
+/*--------------------------------------------------------------------*/
+/* symtablehamt.c                                                     */
+/* Author: Tara Shukla                                                */
+/*--------------------------------------------------------------------*/
+
+#include "symtablehamt.h"
+#include <assert.h>
+
+/*number of hash bits consumed at each level of the trie*/
+enum {BITS_PER_LEVEL = 5};
+/*number of children a branch can have*/
+enum {BRANCH_WIDTH = 1 << BITS_PER_LEVEL};
+/*number of bits in a hash code*/
+static const unsigned int uHashBits = sizeof(size_t) * 8;
+
+/*header shared by every trie node*/
+struct Node {
+    /*number of pointers (from tables, branches or leaves) to this node*/
+    size_t uRefs;
+    /*1 if this node is a struct Branch, 0 if it is a struct Leaf*/
+    int iIsBranch;
+};
+
+/*a binding; leaves whose keys have the same full hash are chained*/
+struct Leaf {
+    /*common node header*/
+    struct Node sHeader;
+    /*full hash code of pcKey*/
+    size_t uHash;
+    /* The binding key */
+    char *pcKey;
+    /*the matching value*/
+    const void *pvValue;
+    /*next leaf with the same full hash, or NULL*/
+    struct Leaf *psNext;
+};
+
+/*interior node; children are stored directly after the struct*/
+struct Branch {
+    /*common node header*/
+    struct Node sHeader;
+    /*bit i is set if the child for hash digit i is present*/
+    unsigned long ulBitmap;
+    /*the children, one per set bit of ulBitmap, in bit order*/
+    struct Node **ppsChildren;
+};
+
+/*stores SymTable struct*/
+struct SymTable{
+    /*root of the trie, or NULL if the table is empty*/
+    struct Node *psRoot;
+    /*len = number of bindings in symboltable*/
+    size_t len;
+};
+
+/*--------------------------------------------------------------------*/
+
+/* Return a hash code for pcKey, using the full width of size_t. */
+static size_t SymTable_hash(const char *pcKey)
+{
+   const size_t HASH_MULTIPLIER = 65599;
+   size_t u;
+   size_t uHash = 0;
+
+   assert(pcKey != NULL);
+
+   for (u = 0; pcKey[u] != '\0'; u++)
+      uHash = uHash * HASH_MULTIPLIER + (size_t)pcKey[u];
+
+   /*spread the high bits down, since the trie uses the low bits first*/
+   uHash ^= uHash >> 16;
+   uHash *= (size_t)0x45d9f3bUL;
+   uHash ^= uHash >> 16;
+   return uHash;
+}
+
+/*return the number of set bits in ulBits*/
+static unsigned int SymTable_popCount(unsigned long ulBits){
+    unsigned int uCount = 0;
+    while (ulBits != 0){
+        ulBits &= ulBits - 1;
+        uCount++;
+    }
+    return uCount;
+}
+
+/*add one reference to psNode, which may be NULL*/
+static void SymTable_retain(struct Node *psNode){
+    if (psNode == NULL) return;
+#ifdef __GNUC__
+    __atomic_add_fetch(&psNode->uRefs, 1, __ATOMIC_RELAXED);
+#else
+    psNode->uRefs++;
+#endif
+}
+
+/*drop one reference to psNode, which may be NULL, freeing it and
+  releasing its children once no references are left*/
+static void SymTable_release(struct Node *psNode){
+    struct Branch *psBranch;
+    struct Leaf *psLeaf;
+    size_t uRefs;
+    unsigned int i;
+
+    while (psNode != NULL){
+#ifdef __GNUC__
+        uRefs = __atomic_sub_fetch(&psNode->uRefs, 1, __ATOMIC_ACQ_REL);
+#else
+        uRefs = --psNode->uRefs;
+#endif
+        if (uRefs > 0) return;
+
+        if (psNode->iIsBranch){
+            psBranch = (struct Branch*)psNode;
+            for (i = 0; i < SymTable_popCount(psBranch->ulBitmap); i++)
+                SymTable_release(psBranch->ppsChildren[i]);
+            free(psBranch);
+            return;
+        }
+        /*walk a collision chain iteratively*/
+        psLeaf = (struct Leaf*)psNode;
+        psNode = (struct Node*)psLeaf->psNext;
+        free(psLeaf->pcKey);
+        free(psLeaf);
+    }
+}
+
+/*helper: allocate a branch with room for uCount children*/
+static struct Branch *SymTable_newBranch(unsigned long ulBitmap,
+    unsigned int uCount){
+    struct Branch *psBranch;
+
+    psBranch = (struct Branch*)malloc(sizeof(struct Branch)
+        + uCount * sizeof(struct Node*));
+    if (psBranch == NULL) return NULL;
+    psBranch->sHeader.uRefs = 1;
+    psBranch->sHeader.iIsBranch = 1;
+    psBranch->ulBitmap = ulBitmap;
+    psBranch->ppsChildren = (struct Node**)(psBranch + 1);
+    return psBranch;
+}
+
+/*helper: allocate a leaf holding a copy of pcKey*/
+static struct Leaf *SymTable_newLeaf(const char *pcKey, size_t uHash,
+    const void *pvValue){
+    struct Leaf *psLeaf;
+
+    psLeaf = (struct Leaf*)malloc(sizeof(struct Leaf));
+    if (psLeaf == NULL) return NULL;
+    psLeaf->pcKey = (char*)malloc(strlen(pcKey) + 1);
+    if (psLeaf->pcKey == NULL){
+        free(psLeaf);
+        return NULL;
+    }
+    strcpy(psLeaf->pcKey, pcKey);
+    psLeaf->sHeader.uRefs = 1;
+    psLeaf->sHeader.iIsBranch = 0;
+    psLeaf->uHash = uHash;
+    psLeaf->pvValue = pvValue;
+    psLeaf->psNext = NULL;
+    return psLeaf;
+}
+
+/*helper: given the caller's reference to psNode, return a node with
+  the same contents that only the caller references, copying psNode
+  if it is shared. Return NULL if insufficient memory is available,
+  in which case the caller's reference to psNode is kept.*/
+static struct Node *SymTable_own(struct Node *psNode){
+    struct Branch *psBranch;
+    struct Branch *psCopy;
+    struct Leaf *psLeaf;
+    struct Leaf *psLeafCopy;
+    unsigned int uCount;
+    unsigned int i;
+
+    assert(psNode != NULL);
+    /*acquire pairs with the release in SymTable_release, so that a
+      snapshot dropping its reference on another thread has finished
+      with the node before this table writes to it*/
+#ifdef __GNUC__
+    if (__atomic_load_n(&psNode->uRefs, __ATOMIC_ACQUIRE) == 1) return psNode;
+#else
+    if (psNode->uRefs == 1) return psNode;
+#endif
+
+    if (psNode->iIsBranch){
+        psBranch = (struct Branch*)psNode;
+        uCount = SymTable_popCount(psBranch->ulBitmap);
+        psCopy = SymTable_newBranch(psBranch->ulBitmap, uCount);
+        if (psCopy == NULL) return NULL;
+        for (i = 0; i < uCount; i++){
+            psCopy->ppsChildren[i] = psBranch->ppsChildren[i];
+            SymTable_retain(psCopy->ppsChildren[i]);
+        }
+        SymTable_release(psNode);
+        return (struct Node*)psCopy;
+    }
+
+    psLeaf = (struct Leaf*)psNode;
+    psLeafCopy = SymTable_newLeaf(psLeaf->pcKey, psLeaf->uHash,
+        psLeaf->pvValue);
+    if (psLeafCopy == NULL) return NULL;
+    psLeafCopy->psNext = psLeaf->psNext;
+    SymTable_retain((struct Node*)psLeafCopy->psNext);
+    SymTable_release(psNode);
+    return (struct Node*)psLeafCopy;
+}
+
+/*helper: return the index in a branch's child array of hash digit
+  uDigit, given the branch's bitmap*/
+static unsigned int SymTable_childIndex(unsigned long ulBitmap,
+    unsigned int uDigit){
+    return SymTable_popCount(ulBitmap & ((1UL << uDigit) - 1));
+}
+
+/*helper: return the hash digit of uHash at bit offset uShift*/
+static unsigned int SymTable_digit(size_t uHash, unsigned int uShift){
+    return (unsigned int)(uHash >> uShift) & (BRANCH_WIDTH - 1);
+}
+
+/*--------------------------------------------------------------------*/
+
+/*helper func: return the leaf with key pcKey (hashing to uHash) in
+  the trie rooted at psNode, or NULL if there is none*/
+static struct Leaf *SymTable_find(struct Node *psNode, const char *pcKey,
+    size_t uHash){
+    struct Branch *psBranch;
+    struct Leaf *psLeaf;
+    unsigned int uShift = 0;
+    unsigned int uDigit;
+
+    assert(pcKey != NULL);
+
+    while (psNode != NULL && psNode->iIsBranch){
+        psBranch = (struct Branch*)psNode;
+        uDigit = SymTable_digit(uHash, uShift);
+        if ((psBranch->ulBitmap & (1UL << uDigit)) == 0) return NULL;
+        psNode = psBranch->ppsChildren[
+            SymTable_childIndex(psBranch->ulBitmap, uDigit)];
+        uShift += BITS_PER_LEVEL;
+    }
+    for (psLeaf = (struct Leaf*)psNode; psLeaf != NULL;
+        psLeaf = psLeaf->psNext){
+        if (psLeaf->uHash != uHash) return NULL;
+        if (strcmp(psLeaf->pcKey, pcKey) == 0) return psLeaf;
+    }
+    return NULL;
+}
+
+/*helper: build the smallest subtrie at bit offset uShift holding the
+  leaf chains psA and psB, whose hashes differ. Return NULL if
+  insufficient memory is available.*/
+static struct Node *SymTable_join(struct Leaf *psA, struct Leaf *psB,
+    unsigned int uShift){
+    struct Branch *psBranch;
+    struct Node *psJoined;
+    struct Node *psNext;
+    unsigned int uDigitA;
+    unsigned int uDigitB;
+    unsigned int uSplit = uShift;
+
+    /*find the first level at which the two hashes differ*/
+    while (SymTable_digit(psA->uHash, uSplit)
+        == SymTable_digit(psB->uHash, uSplit))
+        uSplit += BITS_PER_LEVEL;
+
+    uDigitA = SymTable_digit(psA->uHash, uSplit);
+    uDigitB = SymTable_digit(psB->uHash, uSplit);
+    psBranch = SymTable_newBranch((1UL << uDigitA) | (1UL << uDigitB), 2);
+    if (psBranch == NULL) return NULL;
+    psBranch->ppsChildren[uDigitA < uDigitB ? 0 : 1] = (struct Node*)psA;
+    psBranch->ppsChildren[uDigitA < uDigitB ? 1 : 0] = (struct Node*)psB;
+    psJoined = (struct Node*)psBranch;
+
+    /*wrap it in single-child branches for the shared digits*/
+    while (uSplit > uShift){
+        uSplit -= BITS_PER_LEVEL;
+        psBranch = SymTable_newBranch(
+            1UL << SymTable_digit(psA->uHash, uSplit), 1);
+        if (psBranch == NULL){
+            while (psJoined != NULL){
+                psBranch = (struct Branch*)psJoined;
+                psNext = psBranch->ppsChildren[0];
+                psJoined = psNext->iIsBranch ? psNext : NULL;
+                free(psBranch);
+            }
+            return NULL;
+        }
+        psBranch->ppsChildren[0] = psJoined;
+        psJoined = (struct Node*)psBranch;
+    }
+    return psJoined;
+}
+
+/*helper: insert psNew, whose key is absent, into the subtrie at bit
+  offset uShift that *ppsNode points to, copying shared nodes on the
+  way down. Return 1 on success, 0 if insufficient memory is
+  available (the subtrie is then unchanged apart from copies).*/
+static int SymTable_insert(struct Node **ppsNode, struct Leaf *psNew,
+    unsigned int uShift){
+    struct Node *psNode = *ppsNode;
+    struct Branch *psBranch;
+    struct Branch *psGrown;
+    struct Leaf *psLeaf;
+    struct Node *psJoined;
+    unsigned int uDigit;
+    unsigned int uIndex;
+    unsigned int uCount;
+
+    if (psNode == NULL){
+        *ppsNode = (struct Node*)psNew;
+        return 1;
+    }
+
+    if (!psNode->iIsBranch){
+        psLeaf = (struct Leaf*)psNode;
+        if (psLeaf->uHash == psNew->uHash || uShift >= uHashBits){
+            /*same full hash: chain psNew in front of the existing leaves*/
+            psNew->psNext = psLeaf;
+            *ppsNode = (struct Node*)psNew;
+            return 1;
+        }
+        psJoined = SymTable_join(psLeaf, psNew, uShift);
+        if (psJoined == NULL) return 0;
+        *ppsNode = psJoined;
+        return 1;
+    }
+
+    psNode = SymTable_own(psNode);
+    if (psNode == NULL) return 0;
+    *ppsNode = psNode;
+    psBranch = (struct Branch*)psNode;
+    uDigit = SymTable_digit(psNew->uHash, uShift);
+    uIndex = SymTable_childIndex(psBranch->ulBitmap, uDigit);
+
+    if ((psBranch->ulBitmap & (1UL << uDigit)) != 0)
+        return SymTable_insert(&psBranch->ppsChildren[uIndex], psNew,
+            uShift + BITS_PER_LEVEL);
+
+    /*no child for this digit yet: grow the branch by one slot*/
+    uCount = SymTable_popCount(psBranch->ulBitmap);
+    psGrown = SymTable_newBranch(psBranch->ulBitmap | (1UL << uDigit),
+        uCount + 1);
+    if (psGrown == NULL) return 0;
+    memcpy(psGrown->ppsChildren, psBranch->ppsChildren,
+        uIndex * sizeof(struct Node*));
+    psGrown->ppsChildren[uIndex] = (struct Node*)psNew;
+    memcpy(psGrown->ppsChildren + uIndex + 1,
+        psBranch->ppsChildren + uIndex,
+        (uCount - uIndex) * sizeof(struct Node*));
+    free(psBranch);
+    *ppsNode = (struct Node*)psGrown;
+    return 1;
+}
+
+/*helper: make every node on the path from *ppsNode (at bit offset
+  uShift) to the leaf with key pcKey exclusively owned, and return
+  that leaf. The key must be present. Return NULL if insufficient
+  memory is available.*/
+static struct Leaf *SymTable_ownPath(struct Node **ppsNode,
+    const char *pcKey, size_t uHash, unsigned int uShift){
+    struct Node *psNode;
+    struct Branch *psBranch;
+    struct Leaf **ppsLeaf;
+    unsigned int uDigit;
+
+    for (;;){
+        psNode = SymTable_own(*ppsNode);
+        if (psNode == NULL) return NULL;
+        *ppsNode = psNode;
+        if (!psNode->iIsBranch) break;
+        psBranch = (struct Branch*)psNode;
+        uDigit = SymTable_digit(uHash, uShift);
+        ppsNode = &psBranch->ppsChildren[
+            SymTable_childIndex(psBranch->ulBitmap, uDigit)];
+        uShift += BITS_PER_LEVEL;
+    }
+
+    /*walk the collision chain, owning each leaf before the target*/
+    ppsLeaf = (struct Leaf**)ppsNode;
+    while (strcmp((*ppsLeaf)->pcKey, pcKey) != 0){
+        ppsLeaf = &(*ppsLeaf)->psNext;
+        psNode = SymTable_own((struct Node*)*ppsLeaf);
+        if (psNode == NULL) return NULL;
+        *ppsLeaf = (struct Leaf*)psNode;
+    }
+    return *ppsLeaf;
+}
+
+/*helper: remove the binding with key pcKey, which must be present,
+  from the subtrie *ppsNode at bit offset uShift and store its value
+  in *ppvValue. Branches left with a single leaf collapse into it.
+  Return 1 on success, 0 if insufficient memory is available.*/
+static int SymTable_delete(struct Node **ppsNode, const char *pcKey,
+    size_t uHash, unsigned int uShift, const void **ppvValue){
+    struct Node *psNode;
+    struct Branch *psBranch;
+    struct Leaf **ppsLeaf;
+    struct Leaf *psTarget;
+    unsigned int uDigit;
+    unsigned int uIndex;
+    unsigned int uCount;
+
+    psNode = SymTable_own(*ppsNode);
+    if (psNode == NULL) return 0;
+    *ppsNode = psNode;
+
+    if (!psNode->iIsBranch){
+        ppsLeaf = (struct Leaf**)ppsNode;
+        while (strcmp((*ppsLeaf)->pcKey, pcKey) != 0){
+            ppsLeaf = &(*ppsLeaf)->psNext;
+            psNode = SymTable_own((struct Node*)*ppsLeaf);
+            if (psNode == NULL) return 0;
+            *ppsLeaf = (struct Leaf*)psNode;
+        }
+        psTarget = *ppsLeaf;
+        *ppvValue = psTarget->pvValue;
+        /*the target's reference to its successor passes to *ppsLeaf*/
+        *ppsLeaf = psTarget->psNext;
+        free(psTarget->pcKey);
+        free(psTarget);
+        return 1;
+    }
+
+    psBranch = (struct Branch*)psNode;
+    uDigit = SymTable_digit(uHash, uShift);
+    uIndex = SymTable_childIndex(psBranch->ulBitmap, uDigit);
+    if (!SymTable_delete(&psBranch->ppsChildren[uIndex], pcKey, uHash,
+        uShift + BITS_PER_LEVEL, ppvValue))
+        return 0;
+
+    uCount = SymTable_popCount(psBranch->ulBitmap);
+    if (psBranch->ppsChildren[uIndex] == NULL){
+        memmove(psBranch->ppsChildren + uIndex,
+            psBranch->ppsChildren + uIndex + 1,
+            (uCount - uIndex - 1) * sizeof(struct Node*));
+        psBranch->ulBitmap &= ~(1UL << uDigit);
+        uCount--;
+    }
+    if (uCount == 0){
+        free(psBranch);
+        *ppsNode = NULL;
+    }
+    else if (uCount == 1 && !psBranch->ppsChildren[0]->iIsBranch){
+        *ppsNode = psBranch->ppsChildren[0];
+        free(psBranch);
+    }
+    return 1;
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTable_T SymTable_new(void){
+    SymTable_T oSymTable;
+    oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
+    if (oSymTable==NULL){
+        return NULL;
+    }
+    oSymTable->psRoot = NULL;
+    oSymTable->len = 0;
+    return oSymTable;
+}
+
+SymTable_T SymTable_snapshot(SymTable_T oSymTable){
+    SymTable_T oSnapshot;
+
+    assert(oSymTable != NULL);
+
+    oSnapshot = (SymTable_T)malloc(sizeof(struct SymTable));
+    if (oSnapshot == NULL) return NULL;
+    SymTable_retain(oSymTable->psRoot);
+    oSnapshot->psRoot = oSymTable->psRoot;
+    oSnapshot->len = oSymTable->len;
+    return oSnapshot;
+}
+
+SymTable_T SymTable_clone(SymTable_T oSymTable){
+    /*tables share structure, so a clone is just a snapshot*/
+    return SymTable_snapshot(oSymTable);
+}
+
+void SymTable_free(SymTable_T oSymTable){
+    assert(oSymTable != NULL);
+    SymTable_release(oSymTable->psRoot);
+    free(oSymTable);
+}
+
+size_t SymTable_getLength(SymTable_T oSymTable){
+    assert(oSymTable!=NULL);
+    return oSymTable->len;
+}
+
+int SymTable_put(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue){
+    struct Leaf *psLeaf;
+    size_t uHash;
+
+    assert(oSymTable != NULL);
+    assert(pcKey!=NULL);
+
+    uHash = SymTable_hash(pcKey);
+    if (SymTable_find(oSymTable->psRoot, pcKey, uHash) != NULL) return 0;
+
+    psLeaf = SymTable_newLeaf(pcKey, uHash, pvValue);
+    if (psLeaf == NULL) return 0;
+    if (!SymTable_insert(&oSymTable->psRoot, psLeaf, 0)){
+        free(psLeaf->pcKey);
+        free(psLeaf);
+        return 0;
+    }
+    oSymTable->len++;
+    return 1;
+}
+
+void *SymTable_replace(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue){
+    const void *oldVal;
+    struct Leaf *psLeaf;
+    size_t uHash;
+
+    assert(oSymTable!=NULL);
+    assert(pcKey!=NULL);
+
+    uHash = SymTable_hash(pcKey);
+    psLeaf = SymTable_find(oSymTable->psRoot, pcKey, uHash);
+    if (psLeaf == NULL) return NULL;
+    /*any node on the path may be shared with a snapshot*/
+    psLeaf = SymTable_ownPath(&oSymTable->psRoot, pcKey, uHash, 0);
+    if (psLeaf == NULL) return NULL;
+
+    oldVal = psLeaf->pvValue;
+    psLeaf->pvValue = pvValue;
+    return (void*)oldVal;
+}
+
+int SymTable_contains(SymTable_T oSymTable, const char *pcKey){
+    assert(oSymTable!=NULL);
+    assert(pcKey!=NULL);
+
+    return SymTable_find(oSymTable->psRoot, pcKey, SymTable_hash(pcKey))
+        != NULL;
+}
+
+void *SymTable_get(SymTable_T oSymTable, const char *pcKey){
+    struct Leaf *psLeaf;
+
+    assert(oSymTable!=NULL);
+    assert(pcKey!=NULL);
+
+    psLeaf = SymTable_find(oSymTable->psRoot, pcKey, SymTable_hash(pcKey));
+    if (psLeaf == NULL) return NULL;
+    return (void*)psLeaf->pvValue;
+}
+
+void *SymTable_remove(SymTable_T oSymTable, const char *pcKey){
+    const void *val;
+    size_t uHash;
+
+    assert(oSymTable != NULL);
+    assert(pcKey!=NULL);
+
+    uHash = SymTable_hash(pcKey);
+    if (SymTable_find(oSymTable->psRoot, pcKey, uHash) == NULL) return NULL;
+    if (!SymTable_delete(&oSymTable->psRoot, pcKey, uHash, 0, &val))
+        return NULL;
+    oSymTable->len--;
+    return (void*)val;
+}
+
+/*helper: apply pfApply to every binding in the subtrie psNode*/
+static void SymTable_mapNode(struct Node *psNode,
+     void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+     const void *pvExtra){
+    struct Branch *psBranch;
+    struct Leaf *psLeaf;
+    unsigned int i;
+
+    if (psNode == NULL) return;
+    if (psNode->iIsBranch){
+        psBranch = (struct Branch*)psNode;
+        for (i = 0; i < SymTable_popCount(psBranch->ulBitmap); i++)
+            SymTable_mapNode(psBranch->ppsChildren[i], pfApply, pvExtra);
+        return;
+    }
+    for (psLeaf = (struct Leaf*)psNode; psLeaf != NULL;
+        psLeaf = psLeaf->psNext)
+        (*pfApply)(psLeaf->pcKey, (void*)psLeaf->pvValue, (void*)pvExtra);
+}
+
+void SymTable_map(SymTable_T oSymTable,
+     void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+     const void *pvExtra)
+{
+    assert(oSymTable != NULL);
+    assert(pfApply!=NULL);
+
+    SymTable_mapNode(oSymTable->psRoot, pfApply, pvExtra);
+}
+
+/*--------------------------------------------------------------------*/
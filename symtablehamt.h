@@ -0,0 +1,24 @@
+/*--------------------------------------------------------------------*/
+/* symtablehamt.h                                                     */
+/* Author: Tara Shukla                                                */
+/*--------------------------------------------------------------------*/
+#ifndef SYMTABLEHAMT_INCLUDED
+#define SYMTABLEHAMT_INCLUDED
+#include "symtable.h"
+
+/* symtablehamt.c implements symtable.h as a persistent hash array
+   mapped trie. Tables share structure: an update copies only the
+   nodes on the path it changes, so any number of snapshots of a table
+   can live alongside it. Snapshots are ordinary SymTable_T objects and
+   are freed with SymTable_free. Reference counts are updated
+   atomically, so a snapshot may be read and freed by another thread
+   while the original table keeps changing; any one table must still
+   be modified by only one thread at a time. */
+
+/*return a new SymTable object holding the same bindings as oSymTable
+  at this moment, in O(1) time, or NULL if insufficient memory is
+  available. Later changes to either table do not affect the other.*/
+SymTable_T SymTable_snapshot(SymTable_T oSymTable);
+
+/*--------------------------------------------------------------------*/
+#endif
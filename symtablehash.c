@@ -4,25 +4,127 @@
 /*--------------------------------------------------------------------*/
 
 #include "symtable.h"
+#include "symtableintern.h"
 #include <assert.h>
+#include <limits.h>
+#include <stdint.h>
+#ifdef SYMTABLE_STATS
+#include <time.h>
+#endif
 
 
 /*stores list of bucket counts*/
-static const size_t auBucketCounts[] = {509, 1021, 2039, 4093, 8191, 16381, 32749, 65521}; 
+static const size_t auBucketCounts[] = {509, 1021, 2039, 4093, 8191, 16381, 32749, 65521,
+    131071, 262139, 524287, 1048573, 2097143, 4194301, 8388593, 16777213,
+    33554393, 67108859, 134217689, 268435399, 536870909, 1073741789}; 
 /*stores number of bucket counts*/
 static const size_t numBucketCounts = sizeof(auBucketCounts)/sizeof(auBucketCounts[0]);
 
+/*levels of an expiring table's hierarchical timer wheel, each of
+  WHEEL_SLOTS slots spanning WHEEL_SLOTS times the time of a slot of the
+  level below, enough levels to span every unsigned long*/
+enum {WHEEL_BITS = 6, WHEEL_SLOTS = 1 << WHEEL_BITS,
+    WHEEL_LEVELS = (sizeof(unsigned long) * CHAR_BIT + WHEEL_BITS - 1) / WHEEL_BITS};
+
+/*32-bit words in a block of the negative-lookup filter; a key sets one
+  bit in each word of one block*/
+enum {FILTER_WORDS = 8};
+/*buckets per filter block, giving the filter 16 bits per bucket*/
+enum {FILTER_BUCKETS_PER_BLOCK = 16};
+
+/*node flags: node and key live in a table-owned block, not own mallocs;
+  binding was used since the clock hand last passed it (bounded tables);
+  key is the caller's, put with SymTable_putBorrowed, and never freed;
+  node (but not key) lives in a block preallocated by SymTable_newSized;
+  key is held by the table's intern pool (SymTable_newInterned)*/
+enum {NODE_IN_BLOCK = 0x1, NODE_REFERENCED = 0x2, NODE_BORROWED = 0x4,
+    NODE_POOLED = 0x8, NODE_INTERNED = 0x10};
+
 /*Nodes for linked list imp of symboltable*/
 struct Node {
    /* The binding key */
     char *pcKey;
     /*the matching value*/
     const void *pvValue;
+    /*full hash code of pcKey, before reduction to a bucket*/
+    size_t uHash;
+    /*NODE_ flags*/
+    unsigned int uFlags;
+    /*pending expiry of a binding put with SymTable_putWithTTL, or NULL*/
+    struct Timer *psTimer;
+    /*ring of the bindings sharing this value, while the table has a
+      reverse index*/
+    struct Node *psSamePrev;
+    struct Node *psSameNext;
 
    /* The address of the next StackNode. */
    struct Node *next;
 };
 
+/*pending expiry, linked into one slot of the table's timer wheel*/
+struct Timer {
+    /*the binding that expires*/
+    struct Node *psNode;
+    /*time at which the binding expires*/
+    unsigned long ulExpiry;
+    /*wheel slot the timer is linked into, counting across the levels*/
+    size_t uSlot;
+    /*neighbours in the wheel slot*/
+    struct Timer *psPrev;
+    struct Timer *psNext;
+};
+
+/*expiry state of a table created with SymTable_newExpiring*/
+struct Wheel {
+    /*timers, level by level (see SymTable_linkTimer)*/
+    struct Timer *apsSlots[WHEEL_LEVELS * WHEEL_SLOTS];
+    /*the table's current time, as last passed to SymTable_expire*/
+    unsigned long ulNow;
+    /*last time whose slot has been fully swept*/
+    unsigned long ulSwept;
+    /*called with each binding reclaimed after expiring (may be NULL)*/
+    void (*pfExpire)(const char *pcKey, void *pvValue, void *pvExtra);
+    /*extra argument passed to pfExpire*/
+    const void *pvExpireExtra;
+    /*timers freed by SymTable_clear, linked through psNext, for reuse*/
+    struct Timer *psFree;
+};
+
+/*negative-lookup filter added with SymTable_addFilter: a blocked Bloom
+  filter over the full hash codes of the table's keys*/
+struct Filter {
+    /*uBlockCount blocks of FILTER_WORDS words*/
+    uint32_t *puWords;
+    size_t uBlockCount;
+    /*keys removed since the filter was built, whose bits are still set*/
+    size_t uStale;
+};
+
+/*reverse index added with SymTable_addReverseIndex: open addressing
+  (linear probing) keyed by value pointer, one slot per distinct value
+  holding any node with that value; the rest of the nodes with it hang
+  off that one in a ring. Nodes never move when the buckets are
+  rehashed, so expansion leaves it be.*/
+struct Reverse {
+    /*uSlotCount slots (a power of 2), at most half of them used*/
+    struct Node **ppsSlots;
+    size_t uSlotCount;
+    size_t uUsed;
+    /*64 less the bits of uSlotCount, to take a slot from a product*/
+    unsigned int uShift;
+};
+
+/*bulk allocation holding many nodes and keys, or a resource handed
+  over with SymTable_adopt; released with the table*/
+struct Block {
+    /*next block owned by the same table*/
+    struct Block *psNext;
+    /*releases pvResource, or NULL if the data follows the struct*/
+    void (*pfRelease)(void *pvResource);
+    /*the adopted resource*/
+    void *pvResource;
+};
+
 /*stores SymTable struct*/
 struct SymTable{
     /*pointer to array of node pointer linked lists (storing bindings)*/
@@ -31,11 +133,51 @@ struct SymTable{
     size_t len;
     /*number of buckets that bindings can hash to*/
     size_t bucketCount;
+    /*blocks of nodes and keys allocated in bulk (by SymTable_clone)*/
+    struct Block *psBlocks;
+    /*unused nodes of a block preallocated by SymTable_newSized*/
+    struct Node *psPool;
+    size_t uPoolLeft;
+    /*nodes freed by SymTable_clear, linked through next, for reuse*/
+    struct Node *psFree;
+    /*most bindings a bounded table holds, or 0 if unbounded*/
+    size_t uMaxBindings;
+    /*called with each binding a bounded table evicts (may be NULL)*/
+    void (*pfEvict)(const char *pcKey, void *pvValue, void *pvExtra);
+    /*extra argument passed to pfEvict*/
+    const void *pvEvictExtra;
+    /*bucket the eviction clock hand points at*/
+    size_t uHand;
+    /*timer wheel of an expiring table, or NULL*/
+    struct Wheel *psWheel;
+    /*negative-lookup filter, or NULL*/
+    struct Filter *psFilter;
+    /*value-to-node index, or NULL*/
+    struct Reverse *psReverse;
+    /*1 if a lookup moves the node it finds to the head of its chain*/
+    int iMoveToFront;
+    /*pool holding the keys of a table made by SymTable_newInterned, or
+      NULL if the table copies its own*/
+    SymTableInterns_T oInterns;
+#ifdef SYMTABLE_STATS
+    /*lookups that found / did not find their key, and nodes compared*/
+    size_t uHits;
+    size_t uHitProbes;
+    size_t uMisses;
+    size_t uMissProbes;
+    /*number of expansions and CPU time spent in them*/
+    size_t uExpansions;
+    clock_t iExpandClocks;
+    /*misses answered by the filter, and misses it let through*/
+    size_t uFilterRejects;
+    size_t uFilterPasses;
+#endif
 };
 
-/* Return a hash code for pcKey that is between 0 and uBucketCount-1,
-   inclusive. */
-static size_t SymTable_hash(const char *pcKey, size_t uBucketCount)
+/* Return a hash code for pcKey. Reduce it modulo the bucket count
+   to get a bucket between 0 and bucketCount-1, inclusive. It is the
+   hash SymTableInterns_hash computes, so interned tables share it. */
+static size_t SymTable_hash(const char *pcKey)
 {
    const size_t HASH_MULTIPLIER = 65599;
    size_t u;
@@ -46,12 +188,379 @@ static size_t SymTable_hash(const char *pcKey, size_t uBucketCount)
    for (u = 0; pcKey[u] != '\0'; u++)
       uHash = uHash * HASH_MULTIPLIER + (size_t)pcKey[u];
 
-   return uHash % uBucketCount;
+   return uHash;
+}
+
+/*helper: return the filter block and word bits for full hash code uHash
+  in psFilter, storing the bit masks in auBits*/
+static uint32_t *SymTable_filterBlock(struct Filter *psFilter, size_t uHash,
+    uint32_t auBits[FILTER_WORDS]){
+    /*odd multipliers spreading one hash over the block's words*/
+    static const uint32_t auSalts[FILTER_WORDS] = {0x47b6137bU, 0x44974d91U,
+        0x8824ad5bU, 0xa2b7289dU, 0x705495c7U, 0x2df1424bU, 0x9efc4947U,
+        0x5c6bfb31U};
+    uint64_t uMixed = (uint64_t)uHash;
+    size_t i;
+
+    /*the chain hash is weak in its high bits: mix it first*/
+    uMixed ^= uMixed >> 33;
+    uMixed *= UINT64_C(0xff51afd7ed558ccd);
+    uMixed ^= uMixed >> 33;
+    for (i = 0; i < FILTER_WORDS; i++)
+        auBits[i] = (uint32_t)1 << ((uint32_t)uMixed * auSalts[i] >> 27);
+    /*the high half picks the block, the low half the bits*/
+    return psFilter->puWords + (size_t)(((uMixed >> 32)
+        * (uint64_t)psFilter->uBlockCount) >> 32) * FILTER_WORDS;
+}
+
+/*helper: add full hash code uHash to psFilter*/
+static void SymTable_filterAdd(struct Filter *psFilter, size_t uHash){
+    uint32_t auBits[FILTER_WORDS];
+    uint32_t *puBlock = SymTable_filterBlock(psFilter, uHash, auBits);
+    size_t i;
+
+    for (i = 0; i < FILTER_WORDS; i++) puBlock[i] |= auBits[i];
+}
+
+/*helper: return 0 if no key with full hash code uHash was added to
+  psFilter, else 1*/
+static int SymTable_filterMayContain(struct Filter *psFilter, size_t uHash){
+    uint32_t auBits[FILTER_WORDS];
+    uint32_t *puBlock = SymTable_filterBlock(psFilter, uHash, auBits);
+    uint32_t uMissing = 0;
+    size_t i;
+
+    for (i = 0; i < FILTER_WORDS; i++) uMissing |= auBits[i] & ~puBlock[i];
+    return uMissing == 0;
+}
+
+/*helper: rebuild oSymTable's filter from its keys, sized for its
+  bucket count. Return 1, or 0 if insufficient memory is available, in
+  which case the old filter (still correct) stays.*/
+static int SymTable_buildFilter(SymTable_T oSymTable){
+    struct Filter *psFilter = oSymTable->psFilter;
+    struct Node *current;
+    uint32_t *puOldWords = psFilter->puWords;
+    size_t uOldBlockCount = psFilter->uBlockCount;
+    size_t i;
+
+    psFilter->uBlockCount = (oSymTable->bucketCount + FILTER_BUCKETS_PER_BLOCK - 1)
+        / FILTER_BUCKETS_PER_BLOCK;
+    psFilter->puWords = (uint32_t*)calloc(psFilter->uBlockCount * FILTER_WORDS,
+        sizeof(uint32_t));
+    if (psFilter->puWords == NULL){
+        psFilter->puWords = puOldWords;
+        psFilter->uBlockCount = uOldBlockCount;
+        return 0;
+    }
+    for (i = 0; i < oSymTable->bucketCount; i++)
+        for (current = oSymTable->hashVals[i]; current != NULL; current = current->next)
+            SymTable_filterAdd(psFilter, current->uHash);
+    psFilter->uStale = 0;
+    free(puOldWords);
+    return 1;
+}
+
+/*helper: note that a binding left oSymTable. Its bits stay in the
+  filter, so once stale keys fill half of it the filter is rebuilt.*/
+static void SymTable_filterForget(SymTable_T oSymTable){
+    if (oSymTable->psFilter != NULL
+        && ++oSymTable->psFilter->uStale > oSymTable->bucketCount / 2)
+        SymTable_buildFilter(oSymTable);
+}
+
+/*helper: free node psNode of oSymTable and its key unless they live
+  in a block; a borrowed key is left to its owner, an interned key to
+  the pool and a pooled node to its block*/
+static void SymTable_freeNode(SymTable_T oSymTable, struct Node *psNode){
+    if (psNode->uFlags & NODE_INTERNED)
+        SymTableInterns_release(oSymTable->oInterns, psNode->pcKey);
+    if (psNode->uFlags & NODE_IN_BLOCK) return;
+    if (!(psNode->uFlags & (NODE_BORROWED | NODE_INTERNED))) free(psNode->pcKey);
+    if (!(psNode->uFlags & NODE_POOLED)) free(psNode);
+}
+
+/*helper: return the bits of ulTime above those that select its slot
+  on level uLevel of a timer wheel*/
+static unsigned long SymTable_wheelAbove(unsigned long ulTime, unsigned int uLevel){
+    unsigned int uShift = (uLevel + 1) * WHEEL_BITS;
+
+    return uShift >= sizeof(unsigned long) * CHAR_BIT ? 0 : ulTime >> uShift;
+}
+
+/*helper: return the slot of ulTime on level uLevel of a timer wheel*/
+static size_t SymTable_wheelDigit(unsigned long ulTime, unsigned int uLevel){
+    return (size_t)(ulTime >> (uLevel * WHEEL_BITS)) & (WHEEL_SLOTS - 1);
+}
+
+/*helper: link psTimer into oSymTable's wheel. Time ulSwept + 1, the
+  next the sweep will reach, is the wheel's base. The timer goes on the
+  lowest level whose slots, taken with the base's bits above them, can
+  name its expiry (or the base, if that time has passed): level 0 for
+  the base's block of WHEEL_SLOTS times, level 1 for its block of
+  WHEEL_SLOTS of those, and so on. A slot above level 0 is cascaded to
+  the levels below once the sweep reaches the start of its span.*/
+static void SymTable_linkTimer(SymTable_T oSymTable, struct Timer *psTimer){
+    struct Wheel *psWheel = oSymTable->psWheel;
+    unsigned long ulBase = psWheel->ulSwept + 1;
+    unsigned long ulTick = psTimer->ulExpiry;
+    unsigned int uLevel = 0;
+    struct Timer **ppsSlot;
+
+    if (ulTick < ulBase) ulTick = ulBase;
+    while (uLevel < WHEEL_LEVELS - 1
+        && SymTable_wheelAbove(ulTick, uLevel) != SymTable_wheelAbove(ulBase, uLevel))
+        uLevel++;
+    psTimer->uSlot = uLevel * WHEEL_SLOTS + SymTable_wheelDigit(ulTick, uLevel);
+    ppsSlot = &psWheel->apsSlots[psTimer->uSlot];
+    psTimer->psPrev = NULL;
+    psTimer->psNext = *ppsSlot;
+    if (*ppsSlot != NULL) (*ppsSlot)->psPrev = psTimer;
+    *ppsSlot = psTimer;
+}
+
+/*helper: set *pulTick to the first time after psWheel's ulSwept at
+  which the sweep has work to do: a slot of level 0 to reclaim, or a
+  slot above to cascade. Return 0 if the wheel holds no timers. Every
+  slot is looked at most once, whatever the time elapsed.*/
+static int SymTable_nextTick(struct Wheel *psWheel, unsigned long *pulTick){
+    unsigned long ulBase = psWheel->ulSwept + 1;
+    unsigned long ulBlock;
+    unsigned int uLevel;
+    size_t uDigit;
+
+    /*a slot cascaded right at the base comes first*/
+    for (uLevel = 1; uLevel < WHEEL_LEVELS
+        && (ulBase & ((1UL << (uLevel * WHEEL_BITS)) - 1)) == 0; uLevel++)
+        if (psWheel->apsSlots[uLevel * WHEEL_SLOTS
+            + SymTable_wheelDigit(ulBase, uLevel)] != NULL){
+            *pulTick = ulBase;
+            return 1;
+        }
+    /*then the slots after the base's, level by level: a later slot on
+      one level comes before any slot after the base's on the next*/
+    for (uLevel = 0; uLevel < WHEEL_LEVELS; uLevel++){
+        uDigit = SymTable_wheelDigit(ulBase, uLevel);
+        if (uLevel > 0) uDigit++;
+        for (; uDigit < WHEEL_SLOTS; uDigit++){
+            if (psWheel->apsSlots[uLevel * WHEEL_SLOTS + uDigit] == NULL) continue;
+            ulBlock = SymTable_wheelAbove(ulBase, uLevel);
+            *pulTick = (uLevel == WHEEL_LEVELS - 1 ? 0
+                : ulBlock << ((uLevel + 1) * WHEEL_BITS))
+                | (unsigned long)uDigit << (uLevel * WHEEL_BITS);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/*helper: unlink and free the timer of psNode in oSymTable, if any*/
+static void SymTable_cancelTimer(SymTable_T oSymTable, struct Node *psNode){
+    struct Timer *psTimer = psNode->psTimer;
+
+    if (psTimer == NULL) return;
+    if (psTimer->psPrev != NULL) psTimer->psPrev->psNext = psTimer->psNext;
+    else oSymTable->psWheel->apsSlots[psTimer->uSlot] = psTimer->psNext;
+    if (psTimer->psNext != NULL) psTimer->psNext->psPrev = psTimer->psPrev;
+    free(psTimer);
+    psNode->psTimer = NULL;
+}
+
+/*helper: return a timer for oSymTable, reusing one freed by
+  SymTable_clear if there is one, or NULL if insufficient memory is
+  available*/
+static struct Timer *SymTable_newTimer(SymTable_T oSymTable){
+    struct Timer *psTimer = oSymTable->psWheel->psFree;
+
+    if (psTimer == NULL) return (struct Timer*)malloc(sizeof(struct Timer));
+    oSymTable->psWheel->psFree = psTimer->psNext;
+    return psTimer;
+}
+
+/*helper: put psTimer, no longer linked into the wheel, on oSymTable's
+  list of timers for reuse*/
+static void SymTable_recycleTimer(SymTable_T oSymTable, struct Timer *psTimer){
+    psTimer->psNext = oSymTable->psWheel->psFree;
+    oSymTable->psWheel->psFree = psTimer;
+}
+
+/*helper: return the home slot of value pointer pvValue in psReverse*/
+static size_t SymTable_reverseHome(struct Reverse *psReverse, const void *pvValue){
+    return (size_t)(((uint64_t)(uintptr_t)pvValue * UINT64_C(0x9e3779b97f4a7c15))
+        >> psReverse->uShift);
+}
+
+/*helper: return the slot of psReverse holding the nodes with value
+  pvValue, or the empty slot that would hold them*/
+static size_t SymTable_reverseFind(struct Reverse *psReverse, const void *pvValue){
+    size_t uMask = psReverse->uSlotCount - 1;
+    size_t i = SymTable_reverseHome(psReverse, pvValue);
+
+    while (psReverse->ppsSlots[i] != NULL && psReverse->ppsSlots[i]->pvValue != pvValue)
+        i = (i + 1) & uMask;
+    return i;
+}
+
+/*helper: enter psNode in psReverse, joining the ring of its value if
+  it has one, or taking a free slot, of which psReverse has one*/
+static void SymTable_reversePlace(struct Reverse *psReverse, struct Node *psNode){
+    size_t i = SymTable_reverseFind(psReverse, psNode->pvValue);
+    struct Node *psFirst = psReverse->ppsSlots[i];
+
+    if (psFirst == NULL){
+        psNode->psSamePrev = psNode;
+        psNode->psSameNext = psNode;
+        psReverse->ppsSlots[i] = psNode;
+        psReverse->uUsed++;
+        return;
+    }
+    psNode->psSamePrev = psFirst;
+    psNode->psSameNext = psFirst->psSameNext;
+    psFirst->psSameNext->psSamePrev = psNode;
+    psFirst->psSameNext = psNode;
 }
 
-/*helper function to rehash all values in oSymTableand expand the hash function*/
+/*helper: give psReverse uSlotCount slots (a power of 2, at least 2)
+  and move the rings of its old slots over. Return 1, or 0 if
+  insufficient memory is available, leaving psReverse unchanged.*/
+static int SymTable_reverseResize(struct Reverse *psReverse, size_t uSlotCount){
+    struct Node **ppsOld = psReverse->ppsSlots;
+    size_t uOldCount = psReverse->uSlotCount;
+    unsigned int uShift = 64;
+    size_t i;
+
+    psReverse->ppsSlots = (struct Node**)calloc(uSlotCount, sizeof(struct Node*));
+    if (psReverse->ppsSlots == NULL){
+        psReverse->ppsSlots = ppsOld;
+        return 0;
+    }
+    for (i = uSlotCount; i > 1; i >>= 1) uShift--;
+    psReverse->uSlotCount = uSlotCount;
+    psReverse->uShift = uShift;
+    for (i = 0; i < uOldCount; i++)
+        if (ppsOld[i] != NULL)
+            psReverse->ppsSlots[SymTable_reverseFind(psReverse, ppsOld[i]->pvValue)]
+                = ppsOld[i];
+    free(ppsOld);
+    return 1;
+}
+
+/*helper: free the reverse index of oSymTable, if any*/
+static void SymTable_dropReverse(SymTable_T oSymTable){
+    if (oSymTable->psReverse == NULL) return;
+    free(oSymTable->psReverse->ppsSlots);
+    free(oSymTable->psReverse);
+    oSymTable->psReverse = NULL;
+}
+
+/*helper: take every node out of the reverse index of oSymTable, if any*/
+static void SymTable_emptyReverse(SymTable_T oSymTable){
+    if (oSymTable->psReverse == NULL) return;
+    memset(oSymTable->psReverse->ppsSlots, 0,
+        oSymTable->psReverse->uSlotCount * sizeof(struct Node*));
+    oSymTable->psReverse->uUsed = 0;
+}
+
+/*helper: enter psNode, just given its value, in oSymTable's reverse
+  index, growing it first if a new value would leave it over half
+  full. If there is not the memory to grow, the index is dropped:
+  lookups by value then scan the table, as if it had never been
+  added.*/
+static void SymTable_reverseAdd(SymTable_T oSymTable, struct Node *psNode){
+    struct Reverse *psReverse = oSymTable->psReverse;
+
+    if (psReverse->ppsSlots[SymTable_reverseFind(psReverse, psNode->pvValue)] == NULL
+        && (psReverse->uUsed + 1) * 2 > psReverse->uSlotCount
+        && !SymTable_reverseResize(psReverse, psReverse->uSlotCount * 2)){
+        SymTable_dropReverse(oSymTable);
+        return;
+    }
+    SymTable_reversePlace(psReverse, psNode);
+}
 
-static void SymTable_expandHash(SymTable_T oSymTable){
+/*helper: take psNode out of oSymTable's reverse index, before its
+  value changes or it is freed. A node leaving a ring of others just
+  unlinks; the last one empties its slot, and later slots of the run
+  slide back into the gap, so the index never needs tombstones.*/
+static void SymTable_reverseRemove(SymTable_T oSymTable, struct Node *psNode){
+    struct Reverse *psReverse = oSymTable->psReverse;
+    struct Node **ppsSlots = psReverse->ppsSlots;
+    size_t uMask = psReverse->uSlotCount - 1;
+    size_t i = SymTable_reverseFind(psReverse, psNode->pvValue);
+    size_t j;
+    size_t uHome;
+
+    assert(ppsSlots[i] != NULL);
+    if (psNode->psSameNext != psNode){
+        psNode->psSamePrev->psSameNext = psNode->psSameNext;
+        psNode->psSameNext->psSamePrev = psNode->psSamePrev;
+        if (ppsSlots[i] == psNode) ppsSlots[i] = psNode->psSameNext;
+        return;
+    }
+    assert(ppsSlots[i] == psNode);
+    for (j = (i + 1) & uMask; ppsSlots[j] != NULL; j = (j + 1) & uMask){
+        /*a value may fill the gap unless its home lies after the gap,
+          up to and including its own slot*/
+        uHome = SymTable_reverseHome(psReverse, ppsSlots[j]->pvValue);
+        if (((j - uHome) & uMask) >= ((j - i) & uMask)){
+            ppsSlots[i] = ppsSlots[j];
+            i = j;
+        }
+    }
+    ppsSlots[i] = NULL;
+    psReverse->uUsed--;
+}
+
+/*helper: set the value of oSymTable's node psNode to pvValue, keeping
+  the reverse index, if any, up to date*/
+static void SymTable_setValue(SymTable_T oSymTable, struct Node *psNode,
+    const void *pvValue){
+    if (oSymTable->psReverse == NULL || psNode->pvValue == pvValue){
+        psNode->pvValue = pvValue;
+        return;
+    }
+    SymTable_reverseRemove(oSymTable, psNode);
+    psNode->pvValue = pvValue;
+    SymTable_reverseAdd(oSymTable, psNode);
+}
+
+/*helper: free unlinked node psNode of oSymTable, and its timer*/
+static void SymTable_releaseNode(SymTable_T oSymTable, struct Node *psNode){
+    if (oSymTable->psReverse != NULL) SymTable_reverseRemove(oSymTable, psNode);
+    SymTable_cancelTimer(oSymTable, psNode);
+    SymTable_freeNode(oSymTable, psNode);
+}
+
+/*helper: return the time ulTTL units after ulNow, saturating at
+  ULONG_MAX rather than wrapping round to an early expiry*/
+static unsigned long SymTable_deadline(unsigned long ulNow, unsigned long ulTTL){
+    return ulTTL > ULONG_MAX - ulNow ? ULONG_MAX : ulNow + ulTTL;
+}
+
+/*helper: return 1 if psNode of oSymTable has expired, else 0*/
+static int SymTable_isExpired(SymTable_T oSymTable, struct Node *psNode){
+    return psNode->psTimer != NULL
+        && psNode->psTimer->ulExpiry <= oSymTable->psWheel->ulNow;
+}
+
+/*helper: unlink the expired node that *ppsLink points to from
+  oSymTable, hand it to the table's expiry callback and free it*/
+static void SymTable_reclaim(SymTable_T oSymTable, struct Node **ppsLink){
+    struct Node *psNode = *ppsLink;
+
+    *ppsLink = psNode->next;
+    oSymTable->len--;
+    SymTable_filterForget(oSymTable);
+    if (oSymTable->psWheel->pfExpire != NULL)
+        (*oSymTable->psWheel->pfExpire)(psNode->pcKey, (void*)psNode->pvValue,
+            (void*)oSymTable->psWheel->pvExpireExtra);
+    SymTable_releaseNode(oSymTable, psNode);
+}
+
+/*helper function to rehash all values in oSymTableand expand the hash function
+  to the smallest bucket count of at least uMinBuckets, in one pass*/
+
+static void SymTable_expandHash(SymTable_T oSymTable, size_t uMinBuckets){
     
     struct Node** oldTable;
     struct Node* current;
@@ -59,6 +568,9 @@ static void SymTable_expandHash(SymTable_T oSymTable){
     size_t i = 0;
     size_t oldBucketCount = oSymTable->bucketCount;
     size_t newBucketCount =0;
+#ifdef SYMTABLE_STATS
+    clock_t iStart = clock();
+#endif
 
 
     assert(oSymTable!=NULL);
@@ -66,12 +578,11 @@ static void SymTable_expandHash(SymTable_T oSymTable){
     /*get newBucketCount, or return if the count is the highest bucket count*/
     if(oSymTable->bucketCount == auBucketCounts[numBucketCounts-1]) return;
     for ( i = 0; i<numBucketCounts-1;i++){
-        if (oSymTable->bucketCount == auBucketCounts[i]){
-            i++;
-            newBucketCount=auBucketCounts[i];
-            break; 
-        }
+        if (auBucketCounts[i] > oSymTable->bucketCount && auBucketCounts[i] >= uMinBuckets)
+            break;
     }
+    newBucketCount=auBucketCounts[i];
+    if (newBucketCount <= oldBucketCount) return;
     oSymTable->bucketCount = newBucketCount;
    
     oldTable = oSymTable->hashVals;
@@ -82,9 +593,9 @@ static void SymTable_expandHash(SymTable_T oSymTable){
         return;
     }
 
-    /*iterate through all buckets, all nodes of the old hash table. rehash and put into new one*/
+    /*iterate through all buckets, all nodes of the old hash table.
+      relink each node into the new table using its cached hash*/
     i = 0;
-    oSymTable->len = 0;
     while(i<oldBucketCount){
         
         for (current = oldTable[i];
@@ -92,56 +603,378 @@ static void SymTable_expandHash(SymTable_T oSymTable){
             current = next)
         {
             next = current->next;
-            SymTable_put(oSymTable,current->pcKey,current->pvValue);
-            free(current->pcKey);
-            free(current);
+            current->next = oSymTable->hashVals[current->uHash % newBucketCount];
+            oSymTable->hashVals[current->uHash % newBucketCount] = current;
         }
 
         i++;
     }
 
     free(oldTable);
+    /*a filter sized for the old buckets would fill up: rebuild it*/
+    if (oSymTable->psFilter != NULL) SymTable_buildFilter(oSymTable);
+#ifdef SYMTABLE_STATS
+    oSymTable->uExpansions++;
+    oSymTable->iExpandClocks += clock() - iStart;
+#endif
 }
 
 SymTable_T SymTable_new(void){
+    return SymTable_newSized(0);
+}
+
+SymTable_T SymTable_newSized(size_t uExpected){
     SymTable_T oSymTable;
+    size_t i = 0;
     oSymTable = (SymTable_T)malloc(sizeof(struct SymTable));
     if (oSymTable==NULL){
         return NULL;
     }
-    oSymTable->bucketCount = auBucketCounts[0]; /*start at 509 buckets*/
+    /*start at 509 buckets, or enough that uExpected bindings never expand*/
+    while (i < numBucketCounts - 1 && auBucketCounts[i] < uExpected) i++;
+    oSymTable->bucketCount = auBucketCounts[i];
 
     /*allocate space for all the nodes representing hash values in the hash table*/
     oSymTable->hashVals = (struct Node**)calloc(oSymTable->bucketCount,sizeof(struct Node*));
-    if (oSymTable->hashVals==NULL) return NULL;
+    if (oSymTable->hashVals==NULL) {
+        free(oSymTable);
+        return NULL;
+    }
 
     oSymTable->len = 0;
+    oSymTable->psBlocks = NULL;
+    oSymTable->psPool = NULL;
+    oSymTable->uPoolLeft = 0;
+    oSymTable->psFree = NULL;
+    oSymTable->uMaxBindings = 0;
+    oSymTable->pfEvict = NULL;
+    oSymTable->pvEvictExtra = NULL;
+    oSymTable->uHand = 0;
+    oSymTable->psWheel = NULL;
+    oSymTable->psFilter = NULL;
+    oSymTable->psReverse = NULL;
+    oSymTable->iMoveToFront = 0;
+    oSymTable->oInterns = NULL;
+#ifdef SYMTABLE_STATS
+    oSymTable->uHits = oSymTable->uHitProbes = 0;
+    oSymTable->uMisses = oSymTable->uMissProbes = 0;
+    oSymTable->uExpansions = 0;
+    oSymTable->iExpandClocks = 0;
+    oSymTable->uFilterRejects = oSymTable->uFilterPasses = 0;
+#endif
+
+    /*preallocate the expected nodes in one block; without it, nodes
+      are simply malloc'd one at a time*/
+    if (uExpected > 0){
+        struct Block *psBlock = (struct Block*)malloc(sizeof(struct Block)
+            + uExpected * sizeof(struct Node));
+        if (psBlock != NULL){
+            psBlock->psNext = NULL;
+            psBlock->pfRelease = NULL;
+            oSymTable->psBlocks = psBlock;
+            oSymTable->psPool = (struct Node*)(psBlock + 1);
+            oSymTable->uPoolLeft = uExpected;
+        }
+    }
     
     return oSymTable;
 }
 
-/*helper func: given pcKey that hashes to hashVal*/
-/*return pointer to node if it exists in oSymTable, NULL otherwise*/
-static struct Node * SymTable_exists(SymTable_T oSymTable,const char *pcKey, size_t hashVal){
+int SymTable_adopt(SymTable_T oSymTable, void *pvResource,
+    void (*pfRelease)(void *pvResource)){
+    struct Block *psBlock;
+
+    assert(oSymTable != NULL);
+    assert(pfRelease != NULL);
+
+    psBlock = (struct Block*)malloc(sizeof(struct Block));
+    if (psBlock == NULL) return 0;
+    psBlock->pfRelease = pfRelease;
+    psBlock->pvResource = pvResource;
+    psBlock->psNext = oSymTable->psBlocks;
+    oSymTable->psBlocks = psBlock;
+    return 1;
+}
+
+int SymTable_addFilter(SymTable_T oSymTable){
+    assert(oSymTable != NULL);
+
+    if (oSymTable->psFilter != NULL) return 1;
+    oSymTable->psFilter = (struct Filter*)calloc(1, sizeof(struct Filter));
+    if (oSymTable->psFilter == NULL) return 0;
+    if (!SymTable_buildFilter(oSymTable)){
+        free(oSymTable->psFilter);
+        oSymTable->psFilter = NULL;
+        return 0;
+    }
+    return 1;
+}
+
+void SymTable_setMoveToFront(SymTable_T oSymTable, int iEnable){
+    assert(oSymTable != NULL);
+    oSymTable->iMoveToFront = iEnable != 0;
+}
+
+int SymTable_addReverseIndex(SymTable_T oSymTable){
+    struct Node *current;
+    size_t uSlotCount = 16;
+    size_t i;
+
+    assert(oSymTable != NULL);
+
+    if (oSymTable->psReverse != NULL) return 1;
+    oSymTable->psReverse = (struct Reverse*)calloc(1, sizeof(struct Reverse));
+    if (oSymTable->psReverse == NULL) return 0;
+    while (uSlotCount < oSymTable->len * 2) uSlotCount *= 2;
+    if (!SymTable_reverseResize(oSymTable->psReverse, uSlotCount)){
+        free(oSymTable->psReverse);
+        oSymTable->psReverse = NULL;
+        return 0;
+    }
+    for (i = 0; i < oSymTable->bucketCount; i++)
+        for (current = oSymTable->hashVals[i]; current != NULL; current = current->next)
+            SymTable_reversePlace(oSymTable->psReverse, current);
+    return 1;
+}
+
+const char *SymTable_findKeyByValue(SymTable_T oSymTable, const void *pvValue){
+    struct Reverse *psReverse;
+    struct Node *psFirst;
+    struct Node *current;
+    size_t i;
+
+    assert(oSymTable != NULL);
+
+    psReverse = oSymTable->psReverse;
+    if (psReverse == NULL){
+        /*no index: scan the buckets*/
+        for (i = 0; i < oSymTable->bucketCount; i++)
+            for (current = oSymTable->hashVals[i]; current != NULL; current = current->next)
+                if (current->pvValue == pvValue
+                    && !(current->psTimer != NULL && SymTable_isExpired(oSymTable, current)))
+                    return current->pcKey;
+        return NULL;
+    }
+    psFirst = psReverse->ppsSlots[SymTable_reverseFind(psReverse, pvValue)];
+    if (psFirst == NULL) return NULL;
+    current = psFirst;
+    do {
+        if (!(current->psTimer != NULL && SymTable_isExpired(oSymTable, current)))
+            return current->pcKey;
+        current = current->psSameNext;
+    } while (current != psFirst);
+    return NULL;
+}
+
+SymTable_T SymTable_newInterned(SymTableInterns_T oInterns){
+    SymTable_T oSymTable;
+
+    assert(oInterns != NULL);
+
+    oSymTable = SymTable_new();
+    if (oSymTable == NULL) return NULL;
+    oSymTable->oInterns = oInterns;
+    return oSymTable;
+}
+
+SymTable_T SymTable_newBounded(size_t uMaxBindings,
+    void (*pfEvict)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra){
+    SymTable_T oSymTable;
+    struct Node **ppsBuckets;
+
+    assert(uMaxBindings > 0);
+
+    oSymTable = SymTable_new();
+    if (oSymTable == NULL) return NULL;
+    /*the clock hand sweeps buckets, so a bound below the smallest bucket
+      count gets one bucket per binding: a full table never expands, and
+      an eviction passes no more buckets than bindings. Larger bounds
+      need nothing, since buckets only grow with the bindings.*/
+    if (uMaxBindings < oSymTable->bucketCount){
+        ppsBuckets = (struct Node**)calloc(uMaxBindings, sizeof(struct Node*));
+        if (ppsBuckets == NULL){
+            SymTable_free(oSymTable);
+            return NULL;
+        }
+        free(oSymTable->hashVals);
+        oSymTable->hashVals = ppsBuckets;
+        oSymTable->bucketCount = uMaxBindings;
+    }
+    oSymTable->uMaxBindings = uMaxBindings;
+    oSymTable->pfEvict = pfEvict;
+    oSymTable->pvEvictExtra = pvExtra;
+    return oSymTable;
+}
+
+SymTable_T SymTable_newExpiring(
+    void (*pfExpire)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra){
+    SymTable_T oSymTable;
+
+    oSymTable = SymTable_new();
+    if (oSymTable == NULL) return NULL;
+    oSymTable->psWheel = (struct Wheel*)calloc(1, sizeof(struct Wheel));
+    if (oSymTable->psWheel == NULL){
+        SymTable_free(oSymTable);
+        return NULL;
+    }
+    oSymTable->psWheel->pfExpire = pfExpire;
+    oSymTable->psWheel->pvExpireExtra = pvExtra;
+    return oSymTable;
+}
+
+/*helper: evict one binding from bounded oSymTable using the CLOCK
+  algorithm. The hand sweeps the buckets, clearing each referenced
+  binding's bit and evicting the first binding whose bit is clear.
+  There are at most about twice as many buckets as bindings (see
+  SymTable_newBounded), so a sweep costs O(1) per eviction amortized.*/
+static void SymTable_evict(SymTable_T oSymTable){
+    struct Node **ppsLink;
+    struct Node *current;
+
+    assert(oSymTable != NULL);
+    assert(oSymTable->len > 0);
+
+    for (;;){
+        ppsLink = &oSymTable->hashVals[oSymTable->uHand];
+        while ((current = *ppsLink) != NULL){
+            if (current->uFlags & NODE_REFERENCED){
+                current->uFlags &= ~(unsigned int)NODE_REFERENCED;
+                ppsLink = &current->next;
+                continue;
+            }
+            *ppsLink = current->next;
+            oSymTable->len--;
+            SymTable_filterForget(oSymTable);
+            if (oSymTable->pfEvict != NULL)
+                (*oSymTable->pfEvict)(current->pcKey, (void*)current->pvValue,
+                    (void*)oSymTable->pvEvictExtra);
+            SymTable_releaseNode(oSymTable, current);
+            return;
+        }
+        oSymTable->uHand = (oSymTable->uHand + 1) % oSymTable->bucketCount;
+    }
+}
+
+/*helper: note that bounded oSymTable's binding psNode was just used;
+  the bit is only stored when it changes, so repeated hits stay reads*/
+static void SymTable_touch(SymTable_T oSymTable, struct Node *psNode){
+    if (oSymTable->uMaxBindings != 0 && !(psNode->uFlags & NODE_REFERENCED))
+        psNode->uFlags |= NODE_REFERENCED;
+}
+
+/*helper func: given pcKey whose full hash code is uHash*/
+/*return the address of the link to its node if it exists in oSymTable, NULL otherwise*/
+/*a binding found expired is reclaimed on the spot and treated as absent,
+  and one found in a move-to-front table is first moved to the head.
+  An interned table looks pcKey up in its pool once and then compares
+  keys by address only.*/
+static struct Node ** SymTable_findLink(SymTable_T oSymTable,const char *pcKey, size_t uHash){
+    struct Node **ppsHead;
+    struct Node **ppsLink;
     struct Node *current;
+#ifdef SYMTABLE_STATS
+    size_t uProbes = 0;
+#endif
     
     assert(oSymTable != NULL);
     assert(pcKey!=NULL);
 
-    current = oSymTable->hashVals[hashVal];
-    while(current!=NULL){
-        if (strcmp((current->pcKey), pcKey)==0){
-            return current;
+    /*most misses end here, without touching the chain*/
+    if (oSymTable->psFilter != NULL
+        && !SymTable_filterMayContain(oSymTable->psFilter, uHash)){
+#ifdef SYMTABLE_STATS
+        oSymTable->uMisses++;
+        oSymTable->uFilterRejects++;
+#endif
+        return NULL;
+    }
+    /*a key the pool lacks is in no table made against it*/
+    if (oSymTable->oInterns != NULL){
+        pcKey = SymTableInterns_find(oSymTable->oInterns, pcKey, uHash);
+        if (pcKey == NULL){
+#ifdef SYMTABLE_STATS
+            oSymTable->uMisses++;
+#endif
+            return NULL;
+        }
+    }
+
+    ppsHead = &oSymTable->hashVals[uHash % oSymTable->bucketCount];
+    ppsLink = ppsHead;
+    while((current = *ppsLink)!=NULL){
+#ifdef SYMTABLE_STATS
+        uProbes++;
+#endif
+        if (current->uHash == uHash && (current->pcKey == pcKey
+            || (oSymTable->oInterns == NULL && strcmp((current->pcKey), pcKey)==0))){
+            if (current->psTimer != NULL && SymTable_isExpired(oSymTable, current)){
+                SymTable_reclaim(oSymTable, ppsLink);
+                break;
+            }
+#ifdef SYMTABLE_STATS
+            oSymTable->uHits++;
+            oSymTable->uHitProbes += uProbes;
+#endif
+            if (oSymTable->iMoveToFront && ppsLink != ppsHead){
+                *ppsLink = current->next;
+                current->next = *ppsHead;
+                *ppsHead = current;
+                ppsLink = ppsHead;
+            }
+            return ppsLink;
         }
-        current = current->next;
+        ppsLink = &current->next;
     }
 
+#ifdef SYMTABLE_STATS
+    oSymTable->uMisses++;
+    oSymTable->uMissProbes += uProbes;
+    if (oSymTable->psFilter != NULL) oSymTable->uFilterPasses++;
+#endif
+    return NULL;
+}
+
+/*helper func: given pcKey whose full hash code is uHash*/
+/*return pointer to node if it exists in oSymTable, NULL otherwise*/
+static struct Node * SymTable_exists(SymTable_T oSymTable,const char *pcKey, size_t uHash){
+    struct Node **ppsLink = SymTable_findLink(oSymTable, pcKey, uHash);
+    return ppsLink == NULL ? NULL : *ppsLink;
+}
+
+/*helper func: as SymTable_exists, but without side effects: an expired
+  binding counts as absent but stays, nothing moves to the front and no
+  statistics are kept, so the table is only read*/
+static struct Node *SymTable_peek(SymTable_T oSymTable, const char *pcKey,
+    size_t uHash){
+    struct Node *current;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    if (oSymTable->psFilter != NULL
+        && !SymTable_filterMayContain(oSymTable->psFilter, uHash))
+        return NULL;
+    if (oSymTable->oInterns != NULL){
+        pcKey = SymTableInterns_find(oSymTable->oInterns, pcKey, uHash);
+        if (pcKey == NULL) return NULL;
+    }
+    for (current = oSymTable->hashVals[uHash % oSymTable->bucketCount];
+        current != NULL; current = current->next){
+        if (current->uHash == uHash && (current->pcKey == pcKey
+            || (oSymTable->oInterns == NULL && strcmp(current->pcKey, pcKey) == 0)))
+            return current->psTimer != NULL && SymTable_isExpired(oSymTable, current)
+                ? NULL : current;
+    }
     return NULL;
 }
 
 void SymTable_free(SymTable_T oSymTable){
     struct Node *current;
     struct Node*next;
+    struct Block *psBlock;
+    struct Timer *psTimer;
     size_t i = 0;
     
     assert(oSymTable != NULL);
@@ -153,68 +986,338 @@ void SymTable_free(SymTable_T oSymTable){
         current = next)
     {
             next = current->next;
-            free(current->pcKey);
-            free(current);
+            free(current->psTimer);
+            SymTable_freeNode(oSymTable, current);
     }
         i++;
     }
+    while (oSymTable->psFree != NULL){
+        current = oSymTable->psFree;
+        oSymTable->psFree = current->next;
+        free(current->pcKey);
+        if (!(current->uFlags & NODE_POOLED)) free(current);
+    }
+    if (oSymTable->psWheel != NULL){
+        while (oSymTable->psWheel->psFree != NULL){
+            psTimer = oSymTable->psWheel->psFree;
+            oSymTable->psWheel->psFree = psTimer->psNext;
+            free(psTimer);
+        }
+        free(oSymTable->psWheel);
+    }
+    if (oSymTable->psFilter != NULL){
+        free(oSymTable->psFilter->puWords);
+        free(oSymTable->psFilter);
+    }
+    SymTable_dropReverse(oSymTable);
+    while (oSymTable->psBlocks != NULL){
+        psBlock = oSymTable->psBlocks;
+        oSymTable->psBlocks = psBlock->psNext;
+        if (psBlock->pfRelease != NULL) (*psBlock->pfRelease)(psBlock->pvResource);
+        free(psBlock);
+    }
     free(oSymTable->hashVals);
     free(oSymTable);
 }
 
+/*helper: put node psNode of cleared oSymTable, and its timer, on the
+  table's free lists, keeping its key buffer if the table owns one; the
+  buffer still holds its old key, which tells its room when it is
+  reused. Nodes living in a block are left there.*/
+static void SymTable_recycle(SymTable_T oSymTable, struct Node *psNode){
+    if (psNode->psTimer != NULL){
+        SymTable_recycleTimer(oSymTable, psNode->psTimer);
+        psNode->psTimer = NULL;
+    }
+    if (psNode->uFlags & NODE_INTERNED)
+        SymTableInterns_release(oSymTable->oInterns, psNode->pcKey);
+    if (psNode->uFlags & NODE_IN_BLOCK) return;
+    if (psNode->uFlags & (NODE_BORROWED | NODE_INTERNED)) psNode->pcKey = NULL;
+    psNode->uFlags &= NODE_POOLED;
+    psNode->next = oSymTable->psFree;
+    oSymTable->psFree = psNode;
+}
+
+void SymTable_clear(SymTable_T oSymTable){
+    struct Node *current;
+    struct Node *next;
+    size_t uLeft;
+    size_t i;
+
+    assert(oSymTable != NULL);
+
+    /*stop after the bucket holding the last binding*/
+    uLeft = oSymTable->len;
+    for (i = 0; uLeft > 0; i++){
+        for (current = oSymTable->hashVals[i]; current != NULL; current = next){
+            next = current->next;
+            SymTable_recycle(oSymTable, current);
+            uLeft--;
+        }
+        oSymTable->hashVals[i] = NULL;
+    }
+    oSymTable->len = 0;
+    oSymTable->uHand = 0;
+    SymTable_emptyReverse(oSymTable);
+    if (oSymTable->psWheel != NULL)
+        memset(oSymTable->psWheel->apsSlots, 0, sizeof(oSymTable->psWheel->apsSlots));
+    if (oSymTable->psFilter != NULL){
+        memset(oSymTable->psFilter->puWords, 0,
+            oSymTable->psFilter->uBlockCount * FILTER_WORDS * sizeof(uint32_t));
+        oSymTable->psFilter->uStale = 0;
+    }
+}
+
 size_t SymTable_getLength(SymTable_T oSymTable){
     assert(oSymTable!=NULL);
     return oSymTable->len;
 }
 
+/*helper: fill in psNode, whose key is set, as the binding of that key
+  (whose full hash code is uHash) to pvValue with node flags uFlags, and
+  link it into oSymTable. Return psNode.*/
+static struct Node *SymTable_link(SymTable_T oSymTable, struct Node *psNode,
+    size_t uHash, const void *pvValue, unsigned int uFlags){
+    size_t hashVal;
+
+    /*a full bounded table makes room first*/
+    if (oSymTable->uMaxBindings != 0 && oSymTable->len >= oSymTable->uMaxBindings)
+        SymTable_evict(oSymTable);
+
+    /*check if binding count exceeds bucket count, and if so adjust bucket count*/
+    if (oSymTable->len == (oSymTable->bucketCount)){
+        SymTable_expandHash(oSymTable, oSymTable->len + 1);
+    }
+    hashVal = uHash % oSymTable->bucketCount;
+
+    psNode->pvValue = pvValue;
+    psNode->uHash = uHash;
+    psNode->uFlags = uFlags;
+    psNode->psTimer = NULL;
+
+    /*set newnode-> next to current first node*/
+    psNode->next = oSymTable->hashVals[hashVal];
+
+    /*set newnode as first val in the list of the hashval*/
+    oSymTable->hashVals[hashVal] = psNode;
+    if (oSymTable->psFilter != NULL) SymTable_filterAdd(oSymTable->psFilter, uHash);
+    if (oSymTable->psReverse != NULL) SymTable_reverseAdd(oSymTable, psNode);
+
+    oSymTable->len ++;
+    return psNode;
+}
+
+/*helper: add a binding of a copy of pcKey (whose full hash code is
+  uHash and which must be absent) to pvValue in oSymTable, with node
+  flags uFlags; if they include NODE_BORROWED, pcKey itself is stored.
+  An interned table stores the pool's copy instead, borrowed or not.
+  Return the new node, or NULL if insufficient memory is available.*/
+static struct Node *SymTable_insert(SymTable_T oSymTable,
+    const char *pcKey, size_t uHash, const void *pvValue,
+    unsigned int uFlags){
+    struct Node *newNode;
+    char *pcKeyCopy;
+    /*key buffer of a recycled node*/
+    char *pcSpare = NULL;
+    int iRecycled = 0;
+    size_t uLength;
+
+    /*reuse a node freed by SymTable_clear, then a preallocated one*/
+    if (oSymTable->psFree != NULL){
+        newNode = oSymTable->psFree;
+        oSymTable->psFree = newNode->next;
+        pcSpare = newNode->pcKey;
+        uFlags |= newNode->uFlags & NODE_POOLED;
+        iRecycled = 1;
+    }
+    else if (oSymTable->uPoolLeft > 0){
+        newNode = oSymTable->psPool++;
+        oSymTable->uPoolLeft--;
+        uFlags |= NODE_POOLED;
+    }
+    else {
+        newNode = (struct Node*)malloc(sizeof(struct Node));
+        if (newNode == NULL) return NULL;
+    }
+
+    if (oSymTable->oInterns != NULL){
+        uFlags = (uFlags & ~(unsigned int)NODE_BORROWED) | NODE_INTERNED;
+        pcKeyCopy = (char*)SymTableInterns_acquire(oSymTable->oInterns, pcKey, uHash);
+    }
+    else if (uFlags & NODE_BORROWED) pcKeyCopy = (char*)pcKey;
+    else {
+        uLength = strlen(pcKey) + 1;
+        if (pcSpare != NULL && strlen(pcSpare) + 1 >= uLength){
+            pcKeyCopy = pcSpare;
+            pcSpare = NULL;
+        }
+        else pcKeyCopy = (char*)malloc(sizeof(char) * uLength);
+        if (pcKeyCopy != NULL) memcpy(pcKeyCopy, pcKey, uLength);
+    }
+    if (pcKeyCopy==NULL) {
+        /*put the node back where it came from, untouched*/
+        if (iRecycled){
+            newNode->next = oSymTable->psFree;
+            oSymTable->psFree = newNode;
+        }
+        else if (uFlags & NODE_POOLED){
+            oSymTable->psPool--;
+            oSymTable->uPoolLeft++;
+        }
+        else free(newNode);
+        return NULL;
+    }
+    /*a spare buffer too small, or not needed, goes*/
+    free(pcSpare);
+    newNode->pcKey = pcKeyCopy;
+    return SymTable_link(oSymTable, newNode, uHash, pvValue, uFlags);
+}
+
 int SymTable_put(SymTable_T oSymTable,
     const char *pcKey, const void *pvValue)
 {
-
-    struct Node *newNode;
     struct Node* present;
-    char *pcKeyCopy;
-    size_t hashVal; 
+    size_t uHash;
 
     assert(oSymTable != NULL);
     assert(pcKey!=NULL);
 
-    hashVal = SymTable_hash(pcKey,oSymTable->bucketCount);
+    uHash = SymTable_hash(pcKey);
 
-    present = SymTable_exists(oSymTable, pcKey,hashVal);
+    present = SymTable_exists(oSymTable, pcKey,uHash);
     /*if the node is present, can't put: return 0*/
     if (present!=NULL) return 0;
     /*else put*/
-    else {
-        newNode = (struct Node*)malloc(sizeof(struct Node));
-        if (newNode == NULL) return 0;
+    return SymTable_insert(oSymTable, pcKey, uHash, pvValue, 0) != NULL;
+}
 
-   
-        /*check if binding count exceeds bucket count, and if so adjust bucket count*/
-        if (oSymTable->len == (oSymTable->bucketCount)){
-            SymTable_expandHash(oSymTable);
-            /*rehash this new node*/
-            hashVal = SymTable_hash(pcKey,oSymTable->bucketCount);
-        }
+int SymTable_putBorrowed(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue){
+    size_t uHash;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uHash = SymTable_hash(pcKey);
+    if (SymTable_exists(oSymTable, pcKey, uHash) != NULL) return 0;
+    return SymTable_insert(oSymTable, pcKey, uHash, pvValue,
+        NODE_BORROWED) != NULL;
+}
+
+int SymTable_putBorrowedBatch(SymTable_T oSymTable,
+    const char *const *ppcKeys, const void *const *ppvValues, size_t uCount){
+    /*keys hashed (and buckets prefetched) ahead of their inserts*/
+    enum {BATCH_AHEAD = 16};
+    size_t auHashes[BATCH_AHEAD];
+    size_t uDone;
+    size_t uChunk;
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(ppcKeys != NULL);
+    assert(ppvValues != NULL);
 
-        pcKeyCopy = (char*)malloc(sizeof(char)* (strlen(pcKey)+1));
-        if (pcKeyCopy==NULL) {
-            free(newNode); 
-            return 0;
+    for (uDone = 0; uDone < uCount; uDone += uChunk){
+        uChunk = uCount - uDone < BATCH_AHEAD ? uCount - uDone : BATCH_AHEAD;
+        /*start the bucket loads of the whole chunk before touching any,
+          so their cache misses overlap instead of queueing*/
+        for (i = 0; i < uChunk; i++){
+            auHashes[i] = SymTable_hash(ppcKeys[uDone + i]);
+#ifdef __GNUC__
+            __builtin_prefetch(&oSymTable->hashVals[auHashes[i] % oSymTable->bucketCount]);
+#endif
         }
-        strcpy(pcKeyCopy,pcKey);
-        newNode->pcKey = pcKeyCopy;
-        newNode->pvValue = pvValue;
+        for (i = 0; i < uChunk; i++){
+            if (SymTable_exists(oSymTable, ppcKeys[uDone + i], auHashes[i]) != NULL)
+                continue;
+            if (SymTable_insert(oSymTable, ppcKeys[uDone + i], auHashes[i],
+                ppvValues[uDone + i], NODE_BORROWED) == NULL)
+                return 0;
+        }
+    }
+    return 1;
+}
 
-        /*set newnode-> next to current first node*/
-        newNode->next = oSymTable->hashVals[hashVal];
-    
-        /*set newnode as first val in the list of the hashval*/
-        oSymTable->hashVals[hashVal] = newNode;
+int SymTable_putWithTTL(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue, unsigned long ulTTL){
+    struct Node *newNode;
+    struct Timer *psTimer;
+    size_t uHash;
+
+    assert(oSymTable != NULL);
+    assert(oSymTable->psWheel != NULL);
+    assert(pcKey != NULL);
+
+    uHash = SymTable_hash(pcKey);
+    if (SymTable_exists(oSymTable, pcKey, uHash) != NULL) return 0;
+
+    psTimer = SymTable_newTimer(oSymTable);
+    if (psTimer == NULL) return 0;
+    newNode = SymTable_insert(oSymTable, pcKey, uHash, pvValue, 0);
+    if (newNode == NULL){
+        SymTable_recycleTimer(oSymTable, psTimer);
+        return 0;
+    }
+    psTimer->psNode = newNode;
+    psTimer->ulExpiry = SymTable_deadline(oSymTable->psWheel->ulNow, ulTTL);
+    SymTable_linkTimer(oSymTable, psTimer);
+    newNode->psTimer = psTimer;
+    return 1;
+}
 
-        oSymTable->len ++;
-        return 1;
+size_t SymTable_expire(SymTable_T oSymTable, unsigned long ulNow,
+    size_t uMaxReclaim){
+    struct Wheel *psWheel;
+    struct Timer *psTimer;
+    struct Timer *psNext;
+    struct Timer **ppsSlot;
+    struct Node **ppsLink;
+    unsigned long ulTick;
+    unsigned int uLevel;
+    size_t uReclaimed = 0;
+
+    assert(oSymTable != NULL);
+    assert(oSymTable->psWheel != NULL);
+
+    psWheel = oSymTable->psWheel;
+    if (ulNow > psWheel->ulNow) psWheel->ulNow = ulNow;
+
+    while (psWheel->ulSwept != psWheel->ulNow){
+        /*skip straight over times with nothing due*/
+        if (!SymTable_nextTick(psWheel, &ulTick) || ulTick > psWheel->ulNow){
+            psWheel->ulSwept = psWheel->ulNow;
+            break;
+        }
+        psWheel->ulSwept = ulTick - 1;
+        /*cascade the slots whose span starts at ulTick, highest first,
+          so their timers fall to the levels below*/
+        for (uLevel = WHEEL_LEVELS - 1; uLevel > 0; uLevel--){
+            if ((ulTick & ((1UL << (uLevel * WHEEL_BITS)) - 1)) != 0) continue;
+            ppsSlot = &psWheel->apsSlots[uLevel * WHEEL_SLOTS
+                + SymTable_wheelDigit(ulTick, uLevel)];
+            psTimer = *ppsSlot;
+            *ppsSlot = NULL;
+            for (; psTimer != NULL; psTimer = psNext){
+                psNext = psTimer->psNext;
+                SymTable_linkTimer(oSymTable, psTimer);
+            }
+        }
+        /*every timer left in level 0's slot is due*/
+        for (psTimer = psWheel->apsSlots[SymTable_wheelDigit(ulTick, 0)];
+            psTimer != NULL; psTimer = psNext){
+            /*pfExpire may not change the table (see symtable.h), so
+              psNext outlives the reclaim below*/
+            psNext = psTimer->psNext;
+            if (uReclaimed == uMaxReclaim) return uReclaimed;
+            ppsLink = &oSymTable->hashVals[
+                psTimer->psNode->uHash % oSymTable->bucketCount];
+            while (*ppsLink != psTimer->psNode) ppsLink = &(*ppsLink)->next;
+            SymTable_reclaim(oSymTable, ppsLink);
+            uReclaimed++;
+        }
+        psWheel->ulSwept = ulTick;
     }
+    return uReclaimed;
 }
 
 void *SymTable_replace(SymTable_T oSymTable,
@@ -222,86 +1325,176 @@ void *SymTable_replace(SymTable_T oSymTable,
 
     const void * oldVal;
     struct Node *present; 
-    size_t hashVal = SymTable_hash(pcKey, oSymTable->bucketCount);
     assert (oSymTable!=NULL);
      assert(pcKey!=NULL);
 
 
-    present = SymTable_exists(oSymTable, pcKey, hashVal);
+    present = SymTable_exists(oSymTable, pcKey, SymTable_hash(pcKey));
     if (present == NULL) return NULL;
+    SymTable_touch(oSymTable, present);
 
     oldVal = present->pvValue;
-    present->pvValue = pvValue;
+    SymTable_setValue(oSymTable, present, pvValue);
     return (void*)oldVal;
     
 }
 
 int SymTable_contains(SymTable_T oSymTable, const char *pcKey){
     struct Node *present; 
-    size_t hashVal = SymTable_hash(pcKey, oSymTable->bucketCount);
 
     assert(oSymTable!=NULL);
     assert(pcKey!=NULL);
 
     
-    present = SymTable_exists(oSymTable, pcKey, hashVal);
+    present = SymTable_exists(oSymTable, pcKey, SymTable_hash(pcKey));
     if (present==NULL) return 0;
+    SymTable_touch(oSymTable, present);
     return 1;
 }
 
 void *SymTable_get(SymTable_T oSymTable, const char *pcKey){
     struct Node *present; 
-    size_t hashVal = SymTable_hash(pcKey, oSymTable->bucketCount);
 
     assert(oSymTable!=NULL);
     assert(pcKey!=NULL);
 
-    present = SymTable_exists(oSymTable, pcKey,hashVal);
+    present = SymTable_exists(oSymTable, pcKey, SymTable_hash(pcKey));
     if (present==NULL) return NULL;
+    SymTable_touch(oSymTable, present);
     return (void*)(present->pvValue);
 }
 
 void *SymTable_remove(SymTable_T oSymTable, const char *pcKey){
-   struct Node *current;
-    struct Node *prev;
-    struct Node *target;
+    struct Node **ppsLink;
+    struct Node *current;
     const void *val;
-    size_t hashVal = SymTable_hash(pcKey, oSymTable->bucketCount);
 
-    
     assert(oSymTable != NULL);
     assert(pcKey!=NULL);
 
-    target = SymTable_exists(oSymTable,pcKey, hashVal);
-    if (target==NULL){
-        return NULL;
-    }
-
+    /*the link found by the lookup is the one to cut, so one walk suffices*/
+    ppsLink = SymTable_findLink(oSymTable, pcKey, SymTable_hash(pcKey));
+    if (ppsLink == NULL) return NULL;
 
-    current = oSymTable->hashVals[hashVal];
-    prev = NULL;
-    while(current!=target&&current!=NULL){
-        prev = current;
-        current = current->next;
-    }
-
-    if (current == NULL) return NULL; 
+    current = *ppsLink;
+    *ppsLink = current->next;
     oSymTable->len--;
+    SymTable_filterForget(oSymTable);
     val = current->pvValue;
+    SymTable_releaseNode(oSymTable, current);
+    return (void*)val;
+}
 
-    /*check if target was first*/
-    if (current==oSymTable->hashVals[hashVal]){
-        oSymTable->hashVals[hashVal] = current->next;
-    }
-    else {
-        if (prev!=NULL){
-            prev->next = current->next;
-        }
+/*helper: return the node of the binding in oSymTable with key pcKey,
+  adding a binding of pcKey to pvValue first if there is none, with one
+  hash and one chain walk. Set *piAdded to 1 if the binding was added,
+  else 0. Return NULL if insufficient memory is available.*/
+static struct Node *SymTable_findOrInsert(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue, int *piAdded){
+    struct Node *present;
+    size_t uHash;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uHash = SymTable_hash(pcKey);
+    present = SymTable_exists(oSymTable, pcKey, uHash);
+    if (present != NULL){
+        SymTable_touch(oSymTable, present);
+        *piAdded = 0;
+        return present;
     }
+    *piAdded = 1;
+    return SymTable_insert(oSymTable, pcKey, uHash, pvValue, 0);
+}
 
-    free(current->pcKey);
-    free(current);
-    return (void*)val;
+int SymTable_upsert(SymTable_T oSymTable, const char *pcKey,
+    const void *pvValue, void **ppvOldValue){
+    struct Node *psNode;
+    int iAdded;
+
+    psNode = SymTable_findOrInsert(oSymTable, pcKey, pvValue, &iAdded);
+    if (psNode == NULL) return 0;
+    if (ppvOldValue != NULL)
+        *ppvOldValue = iAdded ? NULL : (void*)psNode->pvValue;
+    SymTable_setValue(oSymTable, psNode, pvValue);
+    return 1;
+}
+
+void *SymTable_getOrPut(SymTable_T oSymTable, const char *pcKey,
+    const void *pvValue){
+    struct Node *psNode;
+    int iAdded;
+
+    psNode = SymTable_findOrInsert(oSymTable, pcKey, pvValue, &iAdded);
+    if (psNode == NULL) return NULL;
+    return (void*)psNode->pvValue;
+}
+
+void **SymTable_slot(SymTable_T oSymTable, const char *pcKey){
+    struct Node *psNode;
+    int iAdded;
+
+    psNode = SymTable_findOrInsert(oSymTable, pcKey, NULL, &iAdded);
+    if (psNode == NULL) return NULL;
+    /*the caller stores values behind the index's back*/
+    SymTable_dropReverse(oSymTable);
+    return (void**)&psNode->pvValue;
+}
+
+int SymTable_increment(SymTable_T oSymTable, const char *pcKey,
+    long lDelta){
+    struct Node *psNode;
+    int iAdded;
+
+    psNode = SymTable_findOrInsert(oSymTable, pcKey, NULL, &iAdded);
+    if (psNode == NULL) return 0;
+    SymTable_setValue(oSymTable, psNode,
+        (const void*)((intptr_t)psNode->pvValue + lDelta));
+    return 1;
+}
+
+int SymTable_incrementAtomic(SymTable_T oSymTable, const char *pcKey,
+    long lDelta){
+    struct Node *psNode;
+    int iAdded;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    /*the count would change behind the index's back, and dropping the
+      index here would race with other callers*/
+    assert(oSymTable->psReverse == NULL);
+
+    /*a present key is found without side effects, so that concurrent
+      callers only read the table; adding one needs exclusive access*/
+    psNode = SymTable_peek(oSymTable, pcKey, SymTable_hash(pcKey));
+    if (psNode == NULL)
+        psNode = SymTable_findOrInsert(oSymTable, pcKey, NULL, &iAdded);
+    if (psNode == NULL) return 0;
+#ifdef __GNUC__
+    /*adds to a pointer operand are not scaled, as if it were a uintptr_t*/
+    __atomic_add_fetch(&psNode->pvValue, lDelta, __ATOMIC_RELAXED);
+#else
+    psNode->pvValue = (const void*)((intptr_t)psNode->pvValue + lDelta);
+#endif
+    return 1;
+}
+
+long SymTable_getCount(SymTable_T oSymTable, const char *pcKey){
+    struct Node *psNode;
+    const void *pvValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    psNode = SymTable_exists(oSymTable, pcKey, SymTable_hash(pcKey));
+    if (psNode == NULL) return 0;
+#ifdef __GNUC__
+    pvValue = __atomic_load_n(&psNode->pvValue, __ATOMIC_RELAXED);
+#else
+    pvValue = psNode->pvValue;
+#endif
+    return (long)(intptr_t)pvValue;
 }
 
 void SymTable_map(SymTable_T oSymTable,
@@ -317,6 +1510,11 @@ void SymTable_map(SymTable_T oSymTable,
     while(i<oSymTable->bucketCount){
         current = oSymTable->hashVals[i];
         while(current!=NULL){
+            /*expired bindings not yet reclaimed are already gone*/
+            if (current->psTimer != NULL && SymTable_isExpired(oSymTable, current)){
+                current = current->next;
+                continue;
+            }
             (*pfApply)((char*)current->pcKey, (void*)current->pvValue, (void*)pvExtra);
             current = current->next;
         }
@@ -325,4 +1523,447 @@ void SymTable_map(SymTable_T oSymTable,
     
 }
 
+size_t SymTable_removeIf(SymTable_T oSymTable,
+    int (*pfTest)(const char *pcKey, void *pvValue, void *pvExtra),
+    void (*pfRemoved)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra){
+    struct Node **ppsLink;
+    struct Node *current;
+    size_t uRemoved = 0;
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(pfTest != NULL);
+
+    /*ppsLink trails the node under test, so a match is cut on the spot*/
+    for (i = 0; i < oSymTable->bucketCount; i++){
+        ppsLink = &oSymTable->hashVals[i];
+        while ((current = *ppsLink) != NULL){
+            if (current->psTimer != NULL && SymTable_isExpired(oSymTable, current)){
+                SymTable_reclaim(oSymTable, ppsLink);
+                continue;
+            }
+            if (!(*pfTest)(current->pcKey, (void*)current->pvValue, (void*)pvExtra)){
+                ppsLink = &current->next;
+                continue;
+            }
+            *ppsLink = current->next;
+            oSymTable->len--;
+            uRemoved++;
+            if (pfRemoved != NULL)
+                (*pfRemoved)(current->pcKey, (void*)current->pvValue, (void*)pvExtra);
+            SymTable_releaseNode(oSymTable, current);
+        }
+    }
+
+    /*the filter is rebuilt at most once, after the sweep*/
+    if (oSymTable->psFilter != NULL){
+        oSymTable->psFilter->uStale += uRemoved;
+        if (oSymTable->psFilter->uStale > oSymTable->bucketCount / 2)
+            SymTable_buildFilter(oSymTable);
+    }
+    return uRemoved;
+}
+
+size_t SymTable_merge(SymTable_T oDst, SymTable_T oSrc, int iPolicy,
+    void (*pfDropped)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra){
+    struct Node **ppsLink;
+    struct Node *current;
+    struct Node *next;
+    struct Block *psBlock;
+    unsigned long ulLeft = 0;
+    size_t uConflicts = 0;
+    size_t uWanted;
+    size_t hashVal;
+    size_t i;
+
+    assert(oDst != NULL);
+    assert(oSrc != NULL);
+    assert(oDst != oSrc);
+    assert(oDst->oInterns == oSrc->oInterns);
+
+    /*expired bindings are reclaimed as SymTable_expire would, calling
+      oSrc's pfExpire, while oSrc's reverse index still holds them*/
+    if (oSrc->psWheel != NULL) SymTable_expire(oSrc, oSrc->psWheel->ulNow, SIZE_MAX);
+
+    /*moved keys may live in oSrc's blocks or adopted resources*/
+    while (oSrc->psBlocks != NULL){
+        psBlock = oSrc->psBlocks;
+        oSrc->psBlocks = psBlock->psNext;
+        psBlock->psNext = oDst->psBlocks;
+        oDst->psBlocks = psBlock;
+    }
+    if (oDst->uPoolLeft == 0){
+        oDst->psPool = oSrc->psPool;
+        oDst->uPoolLeft = oSrc->uPoolLeft;
+    }
+    oSrc->psPool = NULL;
+    oSrc->uPoolLeft = 0;
+    while (oSrc->psFree != NULL){
+        current = oSrc->psFree;
+        oSrc->psFree = current->next;
+        current->next = oDst->psFree;
+        oDst->psFree = current;
+    }
+
+    /*one expansion for every binding, instead of one per doubling; a
+      bounded oDst is only sized for what it keeps*/
+    uWanted = oDst->len + oSrc->len;
+    if (oDst->uMaxBindings != 0 && uWanted > oDst->uMaxBindings)
+        uWanted = oDst->uMaxBindings;
+    if (uWanted > oDst->bucketCount) SymTable_expandHash(oDst, uWanted);
+
+    for (i = 0; i < oSrc->bucketCount; i++){
+        for (current = oSrc->hashVals[i]; current != NULL; current = next){
+            next = current->next;
+            /*an expiry keeps the time it had left, on oDst's clock*/
+            if (current->psTimer != NULL){
+                assert(oDst->psWheel != NULL);
+                ulLeft = current->psTimer->ulExpiry - oSrc->psWheel->ulNow;
+            }
+            ppsLink = SymTable_findLink(oDst, current->pcKey, current->uHash);
+            if (ppsLink != NULL){
+                uConflicts++;
+                if (iPolicy == SYMTABLE_MERGE_REPLACE){
+                    if (pfDropped != NULL)
+                        (*pfDropped)((*ppsLink)->pcKey, (void*)(*ppsLink)->pvValue,
+                            (void*)pvExtra);
+                    SymTable_setValue(oDst, *ppsLink, current->pvValue);
+                }
+                else if (pfDropped != NULL)
+                    (*pfDropped)(current->pcKey, (void*)current->pvValue, (void*)pvExtra);
+                free(current->psTimer);
+                current->psTimer = NULL;
+                SymTable_freeNode(oSrc, current);
+                continue;
+            }
+            if (current->psTimer != NULL){
+                current->psTimer->ulExpiry = SymTable_deadline(oDst->psWheel->ulNow, ulLeft);
+                SymTable_linkTimer(oDst, current->psTimer);
+            }
+            hashVal = current->uHash % oDst->bucketCount;
+            current->next = oDst->hashVals[hashVal];
+            oDst->hashVals[hashVal] = current;
+            if (oDst->psFilter != NULL) SymTable_filterAdd(oDst->psFilter, current->uHash);
+            if (oDst->psReverse != NULL) SymTable_reverseAdd(oDst, current);
+            oDst->len++;
+        }
+        oSrc->hashVals[i] = NULL;
+    }
+
+    /*oSrc is left as SymTable_clear leaves it*/
+    oSrc->len = 0;
+    oSrc->uHand = 0;
+    SymTable_emptyReverse(oSrc);
+    if (oSrc->psWheel != NULL)
+        memset(oSrc->psWheel->apsSlots, 0, sizeof(oSrc->psWheel->apsSlots));
+    if (oSrc->psFilter != NULL){
+        memset(oSrc->psFilter->puWords, 0,
+            oSrc->psFilter->uBlockCount * FILTER_WORDS * sizeof(uint32_t));
+        oSrc->psFilter->uStale = 0;
+    }
+
+    /*a bounded oDst sheds what it cannot hold*/
+    while (oDst->uMaxBindings != 0 && oDst->len > oDst->uMaxBindings)
+        SymTable_evict(oDst);
+    return uConflicts;
+}
+
+/*helper: return the node in oSymTable bound to the key of psNode, a
+  node of another table, or NULL if there is none (or it has expired).
+  The cached hash is reused: if both tables have the same bucket count,
+  psNode's bucket index is the same in oSymTable and its chain is
+  walked directly, else the key is peeked at with its cached hash.
+  Either way no key is hashed again, and oSymTable is only read.*/
+static struct Node *SymTable_counterpart(SymTable_T oSymTable, SymTable_T oOther,
+    struct Node *psNode, size_t uBucket){
+    struct Node *current;
+    /*tables sharing an intern pool share key addresses too*/
+    int iSharedPool = oSymTable->oInterns != NULL
+        && oSymTable->oInterns == oOther->oInterns;
+
+    if (oSymTable->bucketCount != oOther->bucketCount)
+        return SymTable_peek(oSymTable, psNode->pcKey, psNode->uHash);
+    for (current = oSymTable->hashVals[uBucket]; current != NULL; current = current->next){
+        if (current->uHash != psNode->uHash) continue;
+        if (iSharedPool ? current->pcKey != psNode->pcKey
+            : strcmp(current->pcKey, psNode->pcKey) != 0) continue;
+        if (current->psTimer != NULL && SymTable_isExpired(oSymTable, current))
+            return NULL;
+        return current;
+    }
+    return NULL;
+}
+
+void SymTable_diff(SymTable_T oA, SymTable_T oB,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra){
+    struct Node *current;
+    size_t i;
+
+    assert(oA != NULL);
+    assert(oB != NULL);
+    assert(pfApply != NULL);
+
+    for (i = 0; i < oA->bucketCount; i++){
+        for (current = oA->hashVals[i]; current != NULL; current = current->next){
+            if (current->psTimer != NULL && SymTable_isExpired(oA, current)) continue;
+            if (SymTable_counterpart(oB, oA, current, i) == NULL)
+                (*pfApply)(current->pcKey, (void*)current->pvValue, (void*)pvExtra);
+        }
+    }
+}
+
+void SymTable_intersectMap(SymTable_T oA, SymTable_T oB,
+    void (*pfApply)(const char *pcKey, void *pvValueA, void *pvValueB,
+        void *pvExtra),
+    const void *pvExtra){
+    struct Node *current;
+    struct Node *psOther;
+    size_t i;
+
+    assert(oA != NULL);
+    assert(oB != NULL);
+    assert(pfApply != NULL);
+
+    for (i = 0; i < oA->bucketCount; i++){
+        for (current = oA->hashVals[i]; current != NULL; current = current->next){
+            if (current->psTimer != NULL && SymTable_isExpired(oA, current)) continue;
+            psOther = SymTable_counterpart(oB, oA, current, i);
+            if (psOther != NULL)
+                (*pfApply)(current->pcKey, (void*)current->pvValue,
+                    (void*)psOther->pvValue, (void*)pvExtra);
+        }
+    }
+}
+
+/*helper: reclaim the binding of pcKey (whose full hash code is uHash)
+  in oSymTable if it has expired, as a lookup would before the key is
+  added again, but without moving or counting anything*/
+static void SymTable_reclaimExpired(SymTable_T oSymTable, const char *pcKey,
+    size_t uHash){
+    struct Node **ppsLink;
+
+    if (oSymTable->psWheel == NULL) return;
+    for (ppsLink = &oSymTable->hashVals[uHash % oSymTable->bucketCount];
+        *ppsLink != NULL; ppsLink = &(*ppsLink)->next){
+        if ((*ppsLink)->uHash != uHash || strcmp((*ppsLink)->pcKey, pcKey) != 0)
+            continue;
+        if ((*ppsLink)->psTimer != NULL && SymTable_isExpired(oSymTable, *ppsLink))
+            SymTable_reclaim(oSymTable, ppsLink);
+        return;
+    }
+}
+
+int SymTable_unionInto(SymTable_T oDst, SymTable_T oSrc){
+    struct Node *current;
+    size_t i;
+
+    assert(oDst != NULL);
+    assert(oSrc != NULL);
+    assert(oDst != oSrc);
+
+    /*inserts may expand oDst, so the lockstep test is made per key*/
+    for (i = 0; i < oSrc->bucketCount; i++){
+        for (current = oSrc->hashVals[i]; current != NULL; current = current->next){
+            if (current->psTimer != NULL && SymTable_isExpired(oSrc, current)) continue;
+            if (SymTable_counterpart(oDst, oSrc, current, i) != NULL) continue;
+            SymTable_reclaimExpired(oDst, current->pcKey, current->uHash);
+            if (SymTable_insert(oDst, current->pcKey, current->uHash,
+                current->pvValue, 0) == NULL)
+                return 0;
+        }
+    }
+    return 1;
+}
+
+/*helper: give oClone, a finished clone of oSymTable, a reverse index
+  if oSymTable has one. Return oClone, or NULL (having freed it) if
+  insufficient memory is available.*/
+static SymTable_T SymTable_cloneReverse(SymTable_T oSymTable, SymTable_T oClone){
+    if (oSymTable->psReverse != NULL && !SymTable_addReverseIndex(oClone)){
+        SymTable_free(oClone);
+        return NULL;
+    }
+    return oClone;
+}
+
+SymTable_T SymTable_clone(SymTable_T oSymTable){
+    SymTable_T oClone;
+    struct Block *psBlock;
+    struct Node *psNodes;
+    struct Node *current;
+    struct Node **ppsTail;
+    struct Timer *psTimer;
+    char *pcKeys;
+    size_t uKeyBytes = 0;
+    size_t uLength;
+    size_t i;
+    size_t n = 0;
+
+    assert(oSymTable != NULL);
+
+    oClone = (SymTable_T)malloc(sizeof(struct SymTable));
+    if (oClone == NULL) return NULL;
+    /*same bucket count as the source, so no expansion is ever needed*/
+    oClone->bucketCount = oSymTable->bucketCount;
+    oClone->hashVals = (struct Node**)calloc(oClone->bucketCount,sizeof(struct Node*));
+    if (oClone->hashVals == NULL){
+        free(oClone);
+        return NULL;
+    }
+    oClone->len = oSymTable->len;
+    oClone->psBlocks = NULL;
+    oClone->psPool = NULL;
+    oClone->uPoolLeft = 0;
+    oClone->psFree = NULL;
+    oClone->uMaxBindings = oSymTable->uMaxBindings;
+    oClone->pfEvict = oSymTable->pfEvict;
+    oClone->pvEvictExtra = oSymTable->pvEvictExtra;
+    oClone->uHand = 0;
+    oClone->psWheel = NULL;
+    oClone->psFilter = NULL;
+    oClone->psReverse = NULL;
+    oClone->iMoveToFront = oSymTable->iMoveToFront;
+    oClone->oInterns = oSymTable->oInterns;
+#ifdef SYMTABLE_STATS
+    oClone->uHits = oClone->uHitProbes = 0;
+    oClone->uMisses = oClone->uMissProbes = 0;
+    oClone->uExpansions = 0;
+    oClone->iExpandClocks = 0;
+    oClone->uFilterRejects = oClone->uFilterPasses = 0;
+#endif
+    if (oSymTable->psWheel != NULL){
+        oClone->psWheel = (struct Wheel*)calloc(1, sizeof(struct Wheel));
+        if (oClone->psWheel == NULL){
+            SymTable_free(oClone);
+            return NULL;
+        }
+        oClone->psWheel->ulNow = oSymTable->psWheel->ulNow;
+        oClone->psWheel->ulSwept = oSymTable->psWheel->ulSwept;
+        oClone->psWheel->pfExpire = oSymTable->psWheel->pfExpire;
+        oClone->psWheel->pvExpireExtra = oSymTable->psWheel->pvExpireExtra;
+    }
+    /*the keys are the same, so the filter's bits can be copied*/
+    if (oSymTable->psFilter != NULL){
+        oClone->psFilter = (struct Filter*)malloc(sizeof(struct Filter));
+        if (oClone->psFilter == NULL){
+            SymTable_free(oClone);
+            return NULL;
+        }
+        *oClone->psFilter = *oSymTable->psFilter;
+        oClone->psFilter->puWords = (uint32_t*)malloc(
+            oSymTable->psFilter->uBlockCount * FILTER_WORDS * sizeof(uint32_t));
+        if (oClone->psFilter->puWords == NULL){
+            free(oClone->psFilter);
+            oClone->psFilter = NULL;
+            SymTable_free(oClone);
+            return NULL;
+        }
+        memcpy(oClone->psFilter->puWords, oSymTable->psFilter->puWords,
+            oSymTable->psFilter->uBlockCount * FILTER_WORDS * sizeof(uint32_t));
+    }
+    if (oSymTable->len == 0) return SymTable_cloneReverse(oSymTable, oClone);
+
+    /*size one block for every node and every key; interned keys are
+      shared with the source instead*/
+    for (i = 0; i < oSymTable->bucketCount; i++)
+        for (current = oSymTable->hashVals[i]; current != NULL; current = current->next)
+            if (!(current->uFlags & NODE_INTERNED))
+                uKeyBytes += strlen(current->pcKey) + 1;
+    psBlock = (struct Block*)malloc(sizeof(struct Block)
+        + oSymTable->len * sizeof(struct Node) + uKeyBytes);
+    if (psBlock == NULL){
+        SymTable_free(oClone);
+        return NULL;
+    }
+    psBlock->psNext = NULL;
+    psBlock->pfRelease = NULL;
+    oClone->psBlocks = psBlock;
+    psNodes = (struct Node*)(psBlock + 1);
+    pcKeys = (char*)(psNodes + oSymTable->len);
+
+    /*copy each chain in order, reusing the cached hashes*/
+    for (i = 0; i < oSymTable->bucketCount; i++){
+        ppsTail = &oClone->hashVals[i];
+        for (current = oSymTable->hashVals[i]; current != NULL; current = current->next){
+            if (current->uFlags & NODE_INTERNED){
+                SymTableInterns_retain(oClone->oInterns, current->pcKey);
+                psNodes[n].pcKey = current->pcKey;
+            }
+            else {
+                uLength = strlen(current->pcKey) + 1;
+                memcpy(pcKeys, current->pcKey, uLength);
+                psNodes[n].pcKey = pcKeys;
+                pcKeys += uLength;
+            }
+            psNodes[n].pvValue = current->pvValue;
+            psNodes[n].uHash = current->uHash;
+            psNodes[n].uFlags = NODE_IN_BLOCK
+                | (current->uFlags & (NODE_REFERENCED | NODE_INTERNED));
+            psNodes[n].psTimer = NULL;
+            *ppsTail = &psNodes[n];
+            ppsTail = &psNodes[n].next;
+            /*a pending expiry gets its own timer in the clone's wheel*/
+            if (current->psTimer != NULL){
+                psTimer = (struct Timer*)malloc(sizeof(struct Timer));
+                if (psTimer == NULL){
+                    *ppsTail = NULL;
+                    SymTable_free(oClone);
+                    return NULL;
+                }
+                psTimer->psNode = &psNodes[n];
+                psTimer->ulExpiry = current->psTimer->ulExpiry;
+                SymTable_linkTimer(oClone, psTimer);
+                psNodes[n].psTimer = psTimer;
+            }
+            n++;
+        }
+        *ppsTail = NULL;
+    }
+    return SymTable_cloneReverse(oSymTable, oClone);
+}
+
+#ifdef SYMTABLE_STATS
+void SymTable_getStats(SymTable_T oSymTable, struct SymTableStats *psStats){
+    struct Node *current;
+    size_t uChain;
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(psStats != NULL);
+
+    memset(psStats, 0, sizeof(struct SymTableStats));
+    psStats->uBucketCount = oSymTable->bucketCount;
+    psStats->dLoadFactor = (double)oSymTable->len / (double)oSymTable->bucketCount;
+    for (i = 0; i < oSymTable->bucketCount; i++){
+        uChain = 0;
+        for (current = oSymTable->hashVals[i]; current != NULL; current = current->next){
+            uChain++;
+            if (!(current->uFlags & (NODE_BORROWED | NODE_INTERNED)))
+                psStats->uKeyBytes += strlen(current->pcKey) + 1;
+        }
+        if (uChain > psStats->uMaxChain) psStats->uMaxChain = uChain;
+        if (uChain >= SYMTABLE_STATS_HISTOGRAM) uChain = SYMTABLE_STATS_HISTOGRAM - 1;
+        psStats->auChainHistogram[uChain]++;
+    }
+    if (oSymTable->uHits > 0)
+        psStats->dAvgProbesHit = (double)oSymTable->uHitProbes / (double)oSymTable->uHits;
+    if (oSymTable->uMisses > 0)
+        psStats->dAvgProbesMiss = (double)oSymTable->uMissProbes / (double)oSymTable->uMisses;
+    psStats->uExpansions = oSymTable->uExpansions;
+    psStats->dExpandSeconds = (double)oSymTable->iExpandClocks / CLOCKS_PER_SEC;
+    psStats->uNodeBytes = oSymTable->len * sizeof(struct Node);
+    psStats->uBucketBytes = oSymTable->bucketCount * sizeof(struct Node*);
+    if (oSymTable->psFilter != NULL){
+        psStats->uFilterBytes = sizeof(struct Filter)
+            + oSymTable->psFilter->uBlockCount * FILTER_WORDS * sizeof(uint32_t);
+        if (oSymTable->uFilterRejects + oSymTable->uFilterPasses > 0)
+            psStats->dFilterFalsePositiveRate = (double)oSymTable->uFilterPasses
+                / (double)(oSymTable->uFilterRejects + oSymTable->uFilterPasses);
+    }
+}
+#endif
+
 /*--------------------------------------------------------------------*/
\ No newline at end of file
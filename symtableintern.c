@@ -0,0 +1,194 @@
+/*--------------------------------------------------------------------*/
+/* symtableintern.c                                                   */
+/* Author: Tara Shukla                                                */
+/*--------------------------------------------------------------------*/
+
+#include "symtableintern.h"
+#include <assert.h>
+#include <stddef.h>
+
+/*buckets a pool starts with; always a power of 2*/
+enum {MIN_BUCKETS = 64};
+
+/*one interned key; the characters follow the struct*/
+struct Intern {
+    /*number of bindings, in any table, whose key this is*/
+    size_t uRefs;
+    /*hash code of the key*/
+    size_t uHash;
+    /*next key in the same bucket*/
+    struct Intern *psNext;
+    /* The key itself */
+    char acKey[1];
+};
+
+/*stores SymTableInterns struct*/
+struct SymTableInterns {
+    /*array of uBucketCount chains (a power of 2)*/
+    struct Intern **ppsBuckets;
+    size_t uBucketCount;
+    /*number of distinct keys held*/
+    size_t len;
+};
+
+/*helper: return the Intern whose characters are at pcInterned*/
+static struct Intern *SymTableInterns_of(const char *pcInterned){
+    return (struct Intern*)(void*)(pcInterned - offsetof(struct Intern, acKey));
+}
+
+/*helper: return the bucket of hash code uHash in oInterns*/
+static struct Intern **SymTableInterns_bucket(SymTableInterns_T oInterns,
+    size_t uHash){
+    /*the low bits of the hash are weak: fold the high ones in*/
+    return &oInterns->ppsBuckets[(uHash ^ uHash >> 15) & (oInterns->uBucketCount - 1)];
+}
+
+/*helper: double the buckets of oInterns; on failure keep them as they
+  are, since longer chains are still correct*/
+static void SymTableInterns_grow(SymTableInterns_T oInterns){
+    struct Intern **ppsOld = oInterns->ppsBuckets;
+    size_t uOldCount = oInterns->uBucketCount;
+    struct Intern *current;
+    struct Intern *next;
+    struct Intern **ppsBucket;
+    size_t i;
+
+    oInterns->ppsBuckets = (struct Intern**)calloc(uOldCount * 2,
+        sizeof(struct Intern*));
+    if (oInterns->ppsBuckets == NULL){
+        oInterns->ppsBuckets = ppsOld;
+        return;
+    }
+    oInterns->uBucketCount = uOldCount * 2;
+    for (i = 0; i < uOldCount; i++){
+        for (current = ppsOld[i]; current != NULL; current = next){
+            next = current->psNext;
+            ppsBucket = SymTableInterns_bucket(oInterns, current->uHash);
+            current->psNext = *ppsBucket;
+            *ppsBucket = current;
+        }
+    }
+    free(ppsOld);
+}
+
+size_t SymTableInterns_hash(const char *pcKey)
+{
+   const size_t HASH_MULTIPLIER = 65599;
+   size_t u;
+   size_t uHash = 0;
+
+   assert(pcKey != NULL);
+
+   for (u = 0; pcKey[u] != '\0'; u++)
+      uHash = uHash * HASH_MULTIPLIER + (size_t)pcKey[u];
+
+   return uHash;
+}
+
+SymTableInterns_T SymTableInterns_new(void){
+    SymTableInterns_T oInterns;
+
+    oInterns = (SymTableInterns_T)malloc(sizeof(struct SymTableInterns));
+    if (oInterns == NULL) return NULL;
+    oInterns->ppsBuckets = (struct Intern**)calloc(MIN_BUCKETS,
+        sizeof(struct Intern*));
+    if (oInterns->ppsBuckets == NULL){
+        free(oInterns);
+        return NULL;
+    }
+    oInterns->uBucketCount = MIN_BUCKETS;
+    oInterns->len = 0;
+    return oInterns;
+}
+
+void SymTableInterns_free(SymTableInterns_T oInterns){
+    struct Intern *current;
+    struct Intern *next;
+    size_t i;
+
+    assert(oInterns != NULL);
+
+    for (i = 0; i < oInterns->uBucketCount; i++){
+        for (current = oInterns->ppsBuckets[i]; current != NULL; current = next){
+            next = current->psNext;
+            free(current);
+        }
+    }
+    free(oInterns->ppsBuckets);
+    free(oInterns);
+}
+
+size_t SymTableInterns_getLength(SymTableInterns_T oInterns){
+    assert(oInterns != NULL);
+    return oInterns->len;
+}
+
+const char *SymTableInterns_find(SymTableInterns_T oInterns,
+    const char *pcKey, size_t uHash){
+    struct Intern *current;
+
+    assert(oInterns != NULL);
+    assert(pcKey != NULL);
+
+    for (current = *SymTableInterns_bucket(oInterns, uHash); current != NULL;
+        current = current->psNext)
+        if (current->uHash == uHash && strcmp(current->acKey, pcKey) == 0)
+            return current->acKey;
+    return NULL;
+}
+
+const char *SymTableInterns_acquire(SymTableInterns_T oInterns,
+    const char *pcKey, size_t uHash){
+    const char *pcInterned;
+    struct Intern *psIntern;
+    struct Intern **ppsBucket;
+    size_t uLength;
+
+    pcInterned = SymTableInterns_find(oInterns, pcKey, uHash);
+    if (pcInterned != NULL){
+        SymTableInterns_of(pcInterned)->uRefs++;
+        return pcInterned;
+    }
+
+    if (oInterns->len == oInterns->uBucketCount) SymTableInterns_grow(oInterns);
+    uLength = strlen(pcKey);
+    psIntern = (struct Intern*)malloc(sizeof(struct Intern) + uLength);
+    if (psIntern == NULL) return NULL;
+    memcpy(psIntern->acKey, pcKey, uLength + 1);
+    psIntern->uRefs = 1;
+    psIntern->uHash = uHash;
+    ppsBucket = SymTableInterns_bucket(oInterns, uHash);
+    psIntern->psNext = *ppsBucket;
+    *ppsBucket = psIntern;
+    oInterns->len++;
+    return psIntern->acKey;
+}
+
+void SymTableInterns_retain(SymTableInterns_T oInterns,
+    const char *pcInterned){
+    assert(oInterns != NULL);
+    assert(pcInterned != NULL);
+    SymTableInterns_of(pcInterned)->uRefs++;
+}
+
+void SymTableInterns_release(SymTableInterns_T oInterns,
+    const char *pcInterned){
+    struct Intern *psIntern;
+    struct Intern **ppsLink;
+
+    assert(oInterns != NULL);
+    assert(pcInterned != NULL);
+
+    psIntern = SymTableInterns_of(pcInterned);
+    assert(psIntern->uRefs > 0);
+    if (--psIntern->uRefs > 0) return;
+
+    for (ppsLink = SymTableInterns_bucket(oInterns, psIntern->uHash);
+        *ppsLink != psIntern; ppsLink = &(*ppsLink)->psNext)
+        assert(*ppsLink != NULL);
+    *ppsLink = psIntern->psNext;
+    oInterns->len--;
+    free(psIntern);
+}
+
+/*--------------------------------------------------------------------*/
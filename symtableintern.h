@@ -0,0 +1,41 @@
+/*--------------------------------------------------------------------*/
+/* symtableintern.h                                                   */
+/* Author: Tara Shukla                                                */
+/*--------------------------------------------------------------------*/
+#ifndef SYMTABLEINTERN_INCLUDED
+#define SYMTABLEINTERN_INCLUDED
+#include "symtable.h"
+
+/* symtableintern.c holds the keys of the tables made against an intern
+   pool with SymTable_newInterned: one reference-counted copy of each
+   distinct key, however many tables bind it. Every table made against
+   a pool therefore stores the same pointer for the same key, and
+   compares keys by pointer once a lookup has found the pool's copy.
+   The functions below serve the SymTable implementations. */
+
+/*return the hash code the pool uses for pcKey (the multiplicative
+  hash of the assignment specification, over the full size_t)*/
+size_t SymTableInterns_hash(const char *pcKey);
+
+/*return oInterns' copy of pcKey, whose hash code is uHash, or NULL if
+  no table made against oInterns binds pcKey*/
+const char *SymTableInterns_find(SymTableInterns_T oInterns,
+    const char *pcKey, size_t uHash);
+
+/*return oInterns' copy of pcKey, whose hash code is uHash, adding one
+  if there is none, and count one more reference to it. Return NULL if
+  insufficient memory is available.*/
+const char *SymTableInterns_acquire(SymTableInterns_T oInterns,
+    const char *pcKey, size_t uHash);
+
+/*count one more reference to pcInterned, a copy held by oInterns*/
+void SymTableInterns_retain(SymTableInterns_T oInterns,
+    const char *pcInterned);
+
+/*drop one reference to pcInterned, a copy held by oInterns, freeing it
+  when none remain*/
+void SymTableInterns_release(SymTableInterns_T oInterns,
+    const char *pcInterned);
+
+/*--------------------------------------------------------------------*/
+#endif
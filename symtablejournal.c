@@ -0,0 +1,534 @@
+/*--------------------------------------------------------------------*/
+/* symtablejournal.c                                                  */
+/* Author: Tara Shukla                                                */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "symtablejournal.h"
+#include "symtable.h"
+#include <assert.h>
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/* The log is a sequence of records:
+     1 byte    RECORD_SET or RECORD_REMOVE
+     4 bytes   key length k (little-endian)
+     4 bytes   value length v (little-endian, 0 for RECORD_REMOVE)
+     k bytes   key, without its NUL
+     v bytes   value
+     4 bytes   FNV-1a checksum of all the bytes above
+   A SET record stands for both put and replace: replay only needs the
+   latest value of each key. */
+
+/*record types*/
+enum {RECORD_SET = 1, RECORD_REMOVE = 2};
+/*bytes in a record before the key, and after the value*/
+enum {RECORD_HEADER = 9, RECORD_TRAILER = 4};
+/*bytes of records buffered before they are written*/
+enum {BUFFER_SIZE = 65536};
+/*records between fsyncs unless set otherwise*/
+enum {DEFAULT_SYNC_INTERVAL = 256};
+
+/*a value held by the table; its bytes follow the struct*/
+struct Value {
+    /*number of bytes*/
+    size_t uLength;
+};
+
+/*stores SymTableJournal struct*/
+struct SymTableJournal {
+    /*the live bindings; values are struct Value*/
+    SymTable_T oTable;
+    /*name of the log file*/
+    char *pcPath;
+    /*log file, open for appending*/
+    int iFd;
+    /*records not yet written to iFd*/
+    unsigned char *pucBuffer;
+    size_t uBuffered;
+    /*records written since the last fsync, and how many to allow*/
+    size_t uUnsynced;
+    size_t uSyncInterval;
+    /*1 once a write or fsync has failed; the log may then end in a
+      partial or lost record, so nothing more may be appended after it*/
+    int iFailed;
+    /*checksum of the record being emitted*/
+    uint32_t uChecksum;
+};
+
+/*helper: return uChecksum updated with the uLength bytes at pvBytes*/
+static uint32_t SymTableJournal_checksum(uint32_t uChecksum,
+    const void *pvBytes, size_t uLength){
+    const unsigned char *pucBytes = (const unsigned char*)pvBytes;
+    size_t i;
+
+    for (i = 0; i < uLength; i++){
+        uChecksum ^= pucBytes[i];
+        uChecksum *= UINT32_C(16777619);
+    }
+    return uChecksum;
+}
+
+/*helper: store uValue at pucBytes as 4 little-endian bytes*/
+static void SymTableJournal_putU32(unsigned char *pucBytes, uint32_t uValue){
+    pucBytes[0] = (unsigned char)uValue;
+    pucBytes[1] = (unsigned char)(uValue >> 8);
+    pucBytes[2] = (unsigned char)(uValue >> 16);
+    pucBytes[3] = (unsigned char)(uValue >> 24);
+}
+
+/*helper: return the 4 little-endian bytes at pucBytes*/
+static uint32_t SymTableJournal_getU32(const unsigned char *pucBytes){
+    return (uint32_t)pucBytes[0] | (uint32_t)pucBytes[1] << 8
+        | (uint32_t)pucBytes[2] << 16 | (uint32_t)pucBytes[3] << 24;
+}
+
+/*helper: write all uLength bytes at pvBytes to iFd; return 1, or 0 on failure*/
+static int SymTableJournal_writeAll(int iFd, const void *pvBytes, size_t uLength){
+    const unsigned char *pucBytes = (const unsigned char*)pvBytes;
+    ssize_t iWritten;
+
+    while (uLength > 0){
+        iWritten = write(iFd, pucBytes, uLength);
+        if (iWritten < 0){
+            if (errno == EINTR) continue;
+            return 0;
+        }
+        pucBytes += iWritten;
+        uLength -= (size_t)iWritten;
+    }
+    return 1;
+}
+
+/*helper: write oJournal's buffered records to its log; return 1, or 0 on failure*/
+static int SymTableJournal_flush(SymTableJournal_T oJournal){
+    if (oJournal->uBuffered == 0) return 1;
+    if (!SymTableJournal_writeAll(oJournal->iFd, oJournal->pucBuffer,
+        oJournal->uBuffered)){
+        oJournal->iFailed = 1;
+        return 0;
+    }
+    oJournal->uBuffered = 0;
+    return 1;
+}
+
+/*helper: append the uLength bytes at pvBytes to the record oJournal is
+  emitting; return 1, or 0 on failure*/
+static int SymTableJournal_emit(SymTableJournal_T oJournal,
+    const void *pvBytes, size_t uLength){
+    if (uLength == 0) return 1;
+    oJournal->uChecksum = SymTableJournal_checksum(oJournal->uChecksum,
+        pvBytes, uLength);
+    if (oJournal->uBuffered + uLength > BUFFER_SIZE){
+        if (!SymTableJournal_flush(oJournal)) return 0;
+        /*too big to buffer at all: write it straight through*/
+        if (uLength > BUFFER_SIZE){
+            if (SymTableJournal_writeAll(oJournal->iFd, pvBytes, uLength)) return 1;
+            oJournal->iFailed = 1;
+            return 0;
+        }
+    }
+    memcpy(oJournal->pucBuffer + oJournal->uBuffered, pvBytes, uLength);
+    oJournal->uBuffered += uLength;
+    return 1;
+}
+
+/*helper: append a record of type iType for pcKey and the uLength bytes
+  at pvValue to oJournal's log, without syncing; return 1, or 0 on failure*/
+static int SymTableJournal_record(SymTableJournal_T oJournal, int iType,
+    const char *pcKey, const void *pvValue, size_t uLength){
+    unsigned char aucHeader[RECORD_HEADER];
+    unsigned char aucTrailer[RECORD_TRAILER];
+    size_t uKeyLength = strlen(pcKey);
+
+    assert(uKeyLength <= UINT32_MAX && uLength <= UINT32_MAX);
+
+    aucHeader[0] = (unsigned char)iType;
+    SymTableJournal_putU32(aucHeader + 1, (uint32_t)uKeyLength);
+    SymTableJournal_putU32(aucHeader + 5, (uint32_t)uLength);
+    oJournal->uChecksum = UINT32_C(2166136261);
+    if (!SymTableJournal_emit(oJournal, aucHeader, RECORD_HEADER)
+        || !SymTableJournal_emit(oJournal, pcKey, uKeyLength)
+        || !SymTableJournal_emit(oJournal, pvValue, uLength))
+        return 0;
+    SymTableJournal_putU32(aucTrailer, oJournal->uChecksum);
+    return SymTableJournal_emit(oJournal, aucTrailer, RECORD_TRAILER);
+}
+
+/*helper: log a change to oJournal as SymTableJournal_record does, then
+  fsync if enough records have gone unsynced. Return 1 if the record
+  was written, or 0 if it was not, in which case the caller undoes the
+  change. A failed fsync after a written record still returns 1: the
+  change stays, and iFailed makes later changes, syncs and the close
+  fail instead.*/
+static int SymTableJournal_log(SymTableJournal_T oJournal, int iType,
+    const char *pcKey, const void *pvValue, size_t uLength){
+    if (oJournal->iFailed) return 0;
+    if (!SymTableJournal_record(oJournal, iType, pcKey, pvValue, uLength))
+        return 0;
+    if (++oJournal->uUnsynced >= oJournal->uSyncInterval){
+        if (!SymTableJournal_flush(oJournal)) return 0;
+        SymTableJournal_sync(oJournal);
+    }
+    return 1;
+}
+
+/*helper: return a new struct Value holding a copy of the uLength bytes
+  at pvValue, or NULL if insufficient memory is available*/
+static struct Value *SymTableJournal_newValue(const void *pvValue, size_t uLength){
+    struct Value *psValue;
+
+    psValue = (struct Value*)malloc(sizeof(struct Value) + uLength);
+    if (psValue == NULL) return NULL;
+    psValue->uLength = uLength;
+    if (uLength > 0) memcpy(psValue + 1, pvValue, uLength);
+    return psValue;
+}
+
+/*map function: free the value pvValue*/
+static void SymTableJournal_freeValue(const char *pcKey, void *pvValue,
+    void *pvExtra){
+    (void)pcKey;
+    (void)pvExtra;
+    free(pvValue);
+}
+
+/*--------------------------------------------------------------------*/
+
+/*helper: return the length of the valid record at pucRecord, of which
+  uLeft bytes remain in the log, or 0 if it is cut short or corrupt*/
+static size_t SymTableJournal_checkRecord(const unsigned char *pucRecord,
+    size_t uLeft){
+    size_t uKeyLength;
+    size_t uLength;
+    size_t uBody;
+
+    if (uLeft < RECORD_HEADER + RECORD_TRAILER) return 0;
+    if (pucRecord[0] != RECORD_SET && pucRecord[0] != RECORD_REMOVE) return 0;
+    uKeyLength = SymTableJournal_getU32(pucRecord + 1);
+    uLength = SymTableJournal_getU32(pucRecord + 5);
+    if (uKeyLength > uLeft || uLength > uLeft) return 0;
+    uBody = RECORD_HEADER + uKeyLength + uLength;
+    if (uBody + RECORD_TRAILER > uLeft) return 0;
+    if (SymTableJournal_getU32(pucRecord + uBody)
+        != SymTableJournal_checksum(UINT32_C(2166136261), pucRecord, uBody))
+        return 0;
+    return uBody + RECORD_TRAILER;
+}
+
+/*helper: apply the valid record at pucRecord to oJournal's table,
+  using *ppcKey (of *puKeySize bytes, grown as needed) to hold its key.
+  Return 1, or 0 if insufficient memory is available.*/
+static int SymTableJournal_replay(SymTableJournal_T oJournal,
+    const unsigned char *pucRecord, char **ppcKey, size_t *puKeySize){
+    size_t uKeyLength = SymTableJournal_getU32(pucRecord + 1);
+    size_t uLength = SymTableJournal_getU32(pucRecord + 5);
+    struct Value *psValue;
+    void *pvOldValue;
+    char *pcKey;
+
+    if (uKeyLength + 1 > *puKeySize){
+        pcKey = (char*)realloc(*ppcKey, uKeyLength + 1);
+        if (pcKey == NULL) return 0;
+        *ppcKey = pcKey;
+        *puKeySize = uKeyLength + 1;
+    }
+    memcpy(*ppcKey, pucRecord + RECORD_HEADER, uKeyLength);
+    (*ppcKey)[uKeyLength] = '\0';
+
+    if (pucRecord[0] == RECORD_REMOVE){
+        free(SymTable_remove(oJournal->oTable, *ppcKey));
+        return 1;
+    }
+    psValue = SymTableJournal_newValue(pucRecord + RECORD_HEADER + uKeyLength,
+        uLength);
+    if (psValue == NULL) return 0;
+    if (!SymTable_upsert(oJournal->oTable, *ppcKey, psValue, &pvOldValue)){
+        free(psValue);
+        return 0;
+    }
+    free(pvOldValue);
+    return 1;
+}
+
+/*helper: rebuild oJournal's table from the uSize-byte log at pucLog.
+  Return the length of the valid prefix of the log, or (size_t)-1 if
+  insufficient memory is available.*/
+static size_t SymTableJournal_recover(SymTableJournal_T oJournal,
+    const unsigned char *pucLog, size_t uSize){
+    size_t uOffset = 0;
+    size_t uRecord;
+    size_t uSets = 0;
+    size_t uKeySize = 0;
+    char *pcKey = NULL;
+
+    /*find where the valid records end, counting sets to size the table*/
+    while ((uRecord = SymTableJournal_checkRecord(pucLog + uOffset,
+        uSize - uOffset)) != 0){
+        if (pucLog[uOffset] == RECORD_SET) uSets++;
+        uOffset += uRecord;
+    }
+    oJournal->oTable = SymTable_newSized(uSets);
+    if (oJournal->oTable == NULL) return (size_t)-1;
+
+    uSize = uOffset;
+    for (uOffset = 0; uOffset < uSize; uOffset += uRecord){
+        uRecord = SymTableJournal_checkRecord(pucLog + uOffset, uSize - uOffset);
+        if (!SymTableJournal_replay(oJournal, pucLog + uOffset, &pcKey, &uKeySize)){
+            free(pcKey);
+            return (size_t)-1;
+        }
+    }
+    free(pcKey);
+    return uSize;
+}
+
+SymTableJournal_T SymTable_openJournaled(const char *pcPath){
+    SymTableJournal_T oJournal;
+    struct stat sStat;
+    unsigned char *pucLog = NULL;
+    size_t uValid = 0;
+
+    assert(pcPath != NULL);
+
+    oJournal = (SymTableJournal_T)calloc(1, sizeof(struct SymTableJournal));
+    if (oJournal == NULL) return NULL;
+    oJournal->uSyncInterval = DEFAULT_SYNC_INTERVAL;
+    oJournal->pcPath = (char*)malloc(strlen(pcPath) + 1);
+    oJournal->pucBuffer = (unsigned char*)malloc(BUFFER_SIZE);
+    oJournal->iFd = open(pcPath, O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (oJournal->pcPath == NULL || oJournal->pucBuffer == NULL
+        || oJournal->iFd < 0 || fstat(oJournal->iFd, &sStat) != 0)
+        goto fail;
+    strcpy(oJournal->pcPath, pcPath);
+
+    if (sStat.st_size > 0){
+        pucLog = (unsigned char*)mmap(NULL, (size_t)sStat.st_size, PROT_READ,
+            MAP_PRIVATE, oJournal->iFd, 0);
+        if (pucLog == (unsigned char*)MAP_FAILED) goto fail;
+        uValid = SymTableJournal_recover(oJournal, pucLog, (size_t)sStat.st_size);
+        munmap(pucLog, (size_t)sStat.st_size);
+        if (uValid == (size_t)-1) goto fail;
+        /*drop a torn tail so that new records follow valid ones*/
+        if (uValid < (size_t)sStat.st_size
+            && (ftruncate(oJournal->iFd, (off_t)uValid) != 0
+                || fsync(oJournal->iFd) != 0))
+            goto fail;
+    }
+    else {
+        oJournal->oTable = SymTable_new();
+        if (oJournal->oTable == NULL) goto fail;
+    }
+    return oJournal;
+
+fail:
+    if (oJournal->oTable != NULL){
+        SymTable_map(oJournal->oTable, SymTableJournal_freeValue, NULL);
+        SymTable_free(oJournal->oTable);
+    }
+    if (oJournal->iFd >= 0) close(oJournal->iFd);
+    free(oJournal->pucBuffer);
+    free(oJournal->pcPath);
+    free(oJournal);
+    return NULL;
+}
+
+int SymTableJournal_close(SymTableJournal_T oJournal){
+    int iSuccessful;
+
+    assert(oJournal != NULL);
+
+    iSuccessful = SymTableJournal_sync(oJournal);
+    if (close(oJournal->iFd) != 0) iSuccessful = 0;
+    SymTable_map(oJournal->oTable, SymTableJournal_freeValue, NULL);
+    SymTable_free(oJournal->oTable);
+    free(oJournal->pucBuffer);
+    free(oJournal->pcPath);
+    free(oJournal);
+    return iSuccessful;
+}
+
+void SymTableJournal_setSyncInterval(SymTableJournal_T oJournal,
+    size_t uRecords){
+    assert(oJournal != NULL);
+    assert(uRecords > 0);
+    oJournal->uSyncInterval = uRecords;
+}
+
+int SymTableJournal_sync(SymTableJournal_T oJournal){
+    assert(oJournal != NULL);
+
+    if (oJournal->iFailed || !SymTableJournal_flush(oJournal)) return 0;
+    if (fsync(oJournal->iFd) != 0){
+        oJournal->iFailed = 1;
+        return 0;
+    }
+    oJournal->uUnsynced = 0;
+    return 1;
+}
+
+/*map function: append a SET record for binding pcKey/pvValue to the
+  journal whose iFailed flag tells whether one has failed*/
+static void SymTableJournal_recordBinding(const char *pcKey, void *pvValue,
+    void *pvExtra){
+    SymTableJournal_T oJournal = (SymTableJournal_T)pvExtra;
+    struct Value *psValue = (struct Value*)pvValue;
+
+    if (oJournal->iFailed) return;
+    SymTableJournal_record(oJournal, RECORD_SET, pcKey, psValue + 1,
+        psValue->uLength);
+}
+
+/*helper: fsync the directory holding pcPath, so that a rename in it is
+  durable; return 1, or 0 on failure*/
+static int SymTableJournal_syncDirectory(const char *pcPath){
+    const char *pcSlash = strrchr(pcPath, '/');
+    char *pcDirectory;
+    int iFd;
+    int iSuccessful;
+
+    if (pcSlash == NULL) iFd = open(".", O_RDONLY);
+    else {
+        pcDirectory = (char*)malloc((size_t)(pcSlash - pcPath) + 2);
+        if (pcDirectory == NULL) return 0;
+        /*keep the slash itself when the directory is the root*/
+        memcpy(pcDirectory, pcPath, (size_t)(pcSlash - pcPath) + 1);
+        pcDirectory[pcSlash == pcPath ? 1 : pcSlash - pcPath] = '\0';
+        iFd = open(pcDirectory, O_RDONLY);
+        free(pcDirectory);
+    }
+    if (iFd < 0) return 0;
+    iSuccessful = fsync(iFd) == 0;
+    close(iFd);
+    return iSuccessful;
+}
+
+int SymTableJournal_compact(SymTableJournal_T oJournal){
+    char *pcTemp;
+    int iOldFd;
+    int iSuccessful;
+
+    assert(oJournal != NULL);
+
+    /*buffered records go to the old log first, in case this fails*/
+    if (oJournal->iFailed || !SymTableJournal_flush(oJournal)) return 0;
+
+    pcTemp = (char*)malloc(strlen(oJournal->pcPath) + sizeof(".compact"));
+    if (pcTemp == NULL) return 0;
+    strcpy(pcTemp, oJournal->pcPath);
+    strcat(pcTemp, ".compact");
+
+    iOldFd = oJournal->iFd;
+    oJournal->iFd = open(pcTemp, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+    if (oJournal->iFd < 0){
+        oJournal->iFd = iOldFd;
+        free(pcTemp);
+        return 0;
+    }
+
+    SymTable_map(oJournal->oTable, SymTableJournal_recordBinding, oJournal);
+    if (oJournal->iFailed || !SymTableJournal_flush(oJournal)
+        || fsync(oJournal->iFd) != 0
+        || rename(pcTemp, oJournal->pcPath) != 0){
+        /*the old log is still complete: go back to it*/
+        close(oJournal->iFd);
+        unlink(pcTemp);
+        oJournal->iFd = iOldFd;
+        oJournal->uBuffered = 0;
+        oJournal->iFailed = 0;
+        free(pcTemp);
+        return 0;
+    }
+
+    /*once renamed, the old log is unlinked and the new one is the log,
+      even if the rename itself may not yet survive a crash*/
+    close(iOldFd);
+    oJournal->uUnsynced = 0;
+    iSuccessful = SymTableJournal_syncDirectory(oJournal->pcPath);
+    free(pcTemp);
+    return iSuccessful;
+}
+
+size_t SymTableJournal_getLength(SymTableJournal_T oJournal){
+    assert(oJournal != NULL);
+    return SymTable_getLength(oJournal->oTable);
+}
+
+int SymTableJournal_put(SymTableJournal_T oJournal, const char *pcKey,
+    const void *pvValue, size_t uLength){
+    struct Value *psValue;
+
+    assert(oJournal != NULL);
+    assert(pcKey != NULL);
+    assert(pvValue != NULL || uLength == 0);
+
+    if (SymTable_contains(oJournal->oTable, pcKey)) return 0;
+    psValue = SymTableJournal_newValue(pvValue, uLength);
+    if (psValue == NULL) return 0;
+    if (!SymTable_put(oJournal->oTable, pcKey, psValue)){
+        free(psValue);
+        return 0;
+    }
+    if (!SymTableJournal_log(oJournal, RECORD_SET, pcKey, pvValue, uLength)){
+        SymTable_remove(oJournal->oTable, pcKey);
+        free(psValue);
+        return 0;
+    }
+    return 1;
+}
+
+int SymTableJournal_replace(SymTableJournal_T oJournal, const char *pcKey,
+    const void *pvValue, size_t uLength){
+    struct Value *psValue;
+
+    assert(oJournal != NULL);
+    assert(pcKey != NULL);
+    assert(pvValue != NULL || uLength == 0);
+
+    if (!SymTable_contains(oJournal->oTable, pcKey)) return 0;
+    psValue = SymTableJournal_newValue(pvValue, uLength);
+    if (psValue == NULL) return 0;
+    if (!SymTableJournal_log(oJournal, RECORD_SET, pcKey, pvValue, uLength)){
+        free(psValue);
+        return 0;
+    }
+    free(SymTable_replace(oJournal->oTable, pcKey, psValue));
+    return 1;
+}
+
+int SymTableJournal_contains(SymTableJournal_T oJournal, const char *pcKey){
+    assert(oJournal != NULL);
+    assert(pcKey != NULL);
+    return SymTable_contains(oJournal->oTable, pcKey);
+}
+
+const void *SymTableJournal_get(SymTableJournal_T oJournal,
+    const char *pcKey, size_t *puLength){
+    struct Value *psValue;
+
+    assert(oJournal != NULL);
+    assert(pcKey != NULL);
+
+    psValue = (struct Value*)SymTable_get(oJournal->oTable, pcKey);
+    if (psValue == NULL) return NULL;
+    if (puLength != NULL) *puLength = psValue->uLength;
+    return psValue + 1;
+}
+
+int SymTableJournal_remove(SymTableJournal_T oJournal, const char *pcKey){
+    assert(oJournal != NULL);
+    assert(pcKey != NULL);
+
+    if (!SymTable_contains(oJournal->oTable, pcKey)) return 0;
+    if (!SymTableJournal_log(oJournal, RECORD_REMOVE, pcKey, NULL, 0)) return 0;
+    free(SymTable_remove(oJournal->oTable, pcKey));
+    return 1;
+}
+
+/*--------------------------------------------------------------------*/
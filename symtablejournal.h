@@ -0,0 +1,85 @@
+/*--------------------------------------------------------------------*/
+/* symtablejournal.h                                                  */
+/* Author: Tara Shukla                                                */
+/*--------------------------------------------------------------------*/
+#ifndef SYMTABLEJOURNAL_INCLUDED
+#define SYMTABLEJOURNAL_INCLUDED
+#include <stddef.h>
+
+/* symtablejournal.c keeps a SymTable durable by appending a short
+   record for each put, replace and remove to a log file, so the I/O
+   per change is proportional to the change, not to the table. Values
+   are byte strings copied into the table. Records are buffered and
+   the log is fsync'd once every so many records (see
+   SymTableJournal_setSyncInterval) or on SymTableJournal_sync and
+   SymTableJournal_close; a crash loses at most the changes since the
+   last sync. SymTableJournal_compact rewrites the log from the live
+   bindings when it has grown long with superseded records. */
+
+/*struct storing a journaled table*/
+struct SymTableJournal;
+/*SymTableJournal_T stores pointer to a journaled table*/
+typedef struct SymTableJournal *SymTableJournal_T;
+
+/*open the journaled table whose log is the file pcPath, creating an
+  empty one if there is none, and return it, or NULL if the log cannot
+  be read or written or insufficient memory is available. The table is
+  rebuilt by replaying the log; a record cut short by a crash, and
+  anything after it, is dropped from the log.*/
+SymTableJournal_T SymTable_openJournaled(const char *pcPath);
+
+/*write and fsync any buffered records, close oJournal's log and free
+  all memory occupied by oJournal. Return 1, or 0 if the final write
+  failed (the table is freed regardless).*/
+int SymTableJournal_close(SymTableJournal_T oJournal);
+
+/*fsync the log after every uRecords records (1 makes every change
+  durable before it returns, or its fsync's failure reported by the
+  next sync or close); the default is 256*/
+void SymTableJournal_setSyncInterval(SymTableJournal_T oJournal,
+    size_t uRecords);
+
+/*write and fsync any buffered records. Return 1, or 0 on failure.*/
+int SymTableJournal_sync(SymTableJournal_T oJournal);
+
+/*rewrite oJournal's log to hold one record per live binding, replacing
+  the old log atomically. Return 1, or 0 on failure. If the new log
+  could not be written or put in place, the old log stays in use; if
+  only the fsync of the directory holding it failed, the new log is in
+  use, but a crash may bring back the old one.*/
+int SymTableJournal_compact(SymTableJournal_T oJournal);
+
+/*return size_t the number of bindings in oJournal*/
+size_t SymTableJournal_getLength(SymTableJournal_T oJournal);
+
+/*add a binding of pcKey to a copy of the uLength bytes at pvValue to
+  oJournal, log it and return 1 (TRUE); if pcKey already exists, or if
+  insufficient memory is available or the log cannot be written, leave
+  oJournal unchanged and return 0 (FALSE). If the record is written but
+  the fsync due after it fails, the change is kept and 1 returned, but
+  oJournal then refuses further changes, and SymTableJournal_sync and
+  SymTableJournal_close return 0.*/
+int SymTableJournal_put(SymTableJournal_T oJournal, const char *pcKey,
+    const void *pvValue, size_t uLength);
+
+/*if a binding w key pcKey exists in oJournal, replace its value w a
+  copy of the uLength bytes at pvValue, log it and return 1; else (or
+  on failure, as for SymTableJournal_put) leave it unchanged, return 0*/
+int SymTableJournal_replace(SymTableJournal_T oJournal, const char *pcKey,
+    const void *pvValue, size_t uLength);
+
+/*return 1 (TRUE) if oJournal contains a binding whose key is pcKey, else 0 (FALSE)*/
+int SymTableJournal_contains(SymTableJournal_T oJournal, const char *pcKey);
+
+/*return the address of the value in oJournal w key pcKey, storing its
+  length in *puLength unless puLength is NULL, or NULL if no such
+  binding exists. The bytes are valid until the binding next changes.*/
+const void *SymTableJournal_get(SymTableJournal_T oJournal,
+    const char *pcKey, size_t *puLength);
+
+/*remove the binding w key pcKey from oJournal, log it and return 1;
+  if nonexistent (or on failure, as for SymTableJournal_put), return 0*/
+int SymTableJournal_remove(SymTableJournal_T oJournal, const char *pcKey);
+
+/*--------------------------------------------------------------------*/
+#endif
@@ -4,27 +4,170 @@
 /*--------------------------------------------------------------------*/
 
 #include "symtable.h"
+#include "symtableintern.h"
 #include <assert.h>
+#include <limits.h>
+#include <stdint.h>
 
-/*Nodes for linked list imp of symboltable*/
-struct Node {
+/*entry flags: key lives in a table-owned block, not its own malloc;
+  binding was used since the clock hand last passed it (bounded tables);
+  binding expires at ulExpiry (put with SymTable_putWithTTL);
+  key is the caller's, put with SymTable_putBorrowed, and never freed;
+  key is held by the table's intern pool (SymTable_newInterned)*/
+enum {ENTRY_IN_BLOCK = 0x1, ENTRY_REFERENCED = 0x2, ENTRY_EXPIRES = 0x4,
+    ENTRY_BORROWED = 0x8, ENTRY_INTERNED = 0x10};
+
+/*slots a table first allocates; capacities stay multiples of 8, so
+  the tag array can always be read a whole word at a time*/
+enum {MIN_CAPACITY = 16};
+
+/*index returned by SymTable_find for a key that is absent*/
+#define NOT_FOUND ((size_t)-1)
+
+/*each byte of a word set to 0x01, and to 0x80*/
+static const uint64_t uOnes = UINT64_C(0x0101010101010101);
+static const uint64_t uHighs = UINT64_C(0x8080808080808080);
+
+/*one binding; entries are kept oldest first in one array*/
+struct Entry {
    /* The binding key */
     char *pcKey;
     /*the matching value*/
     const void *pvValue;
+    /*ENTRY_ flags*/
+    unsigned int uFlags;
+    /*time at which the binding expires, if ENTRY_EXPIRES is set*/
+    unsigned long ulExpiry;
+};
 
-   /* The address of the next StackNode. */
-   struct Node *next;
+/*bulk allocation holding many keys, or a resource handed over with
+  SymTable_adopt; released with the table*/
+struct Block {
+    /*next block owned by the same table*/
+    struct Block *psNext;
+    /*releases pvResource, or NULL if the data follows the struct*/
+    void (*pfRelease)(void *pvResource);
+    /*the adopted resource*/
+    void *pvResource;
 };
 
 /*stores SymTable struct*/
 struct SymTable{
-    /*address of first node*/
-    struct Node *first;
+    /*array of uCapacity entries, of which the first len are bindings*/
+    struct Entry *psEntries;
+    /*one-byte hash tag of each entry's key, in a parallel array, so a
+      lookup scans 8 tags per word and compares only keys whose tag
+      matches*/
+    unsigned char *pucTags;
+    size_t uCapacity;
     /*len = number of bindings in symboltable*/
     size_t len;
+    /*1 if a lookup moves the binding it finds to the front, else 0*/
+    int iMoveToFront;
+    /*pool holding the keys of a table made by SymTable_newInterned, or
+      NULL if the table copies its own*/
+    SymTableInterns_T oInterns;
+    /*blocks of keys allocated in bulk (by SymTable_clone)*/
+    struct Block *psBlocks;
+    /*most bindings a bounded table holds, or 0 if unbounded*/
+    size_t uMaxBindings;
+    /*called with each binding a bounded table evicts (may be NULL)*/
+    void (*pfEvict)(const char *pcKey, void *pvValue, void *pvExtra);
+    /*extra argument passed to pfEvict*/
+    const void *pvEvictExtra;
+    /*index of the entry the eviction clock hand points at; it wraps to
+      0 when it reaches len*/
+    size_t uHand;
+    /*1 if made by SymTable_newExpiring, else 0*/
+    int iExpiring;
+    /*the table's current time, as last passed to SymTable_expire*/
+    unsigned long ulNow;
+    /*called with each binding reclaimed after expiring (may be NULL)*/
+    void (*pfExpire)(const char *pcKey, void *pvValue, void *pvExtra);
+    /*extra argument passed to pfExpire*/
+    const void *pvExpireExtra;
+#ifdef SYMTABLE_STATS
+    /*lookups that found / did not find their key, and keys compared*/
+    size_t uHits;
+    size_t uHitProbes;
+    size_t uMisses;
+    size_t uMissProbes;
+#endif
 };
 
+/* Return the one-byte tag of pcKey: the high byte of a 32-bit
+   multiplicative hash, which depends on every character. */
+static unsigned char SymTable_tag(const char *pcKey)
+{
+   uint32_t uHash = 0;
+   size_t u;
+
+   assert(pcKey != NULL);
+
+   for (u = 0; pcKey[u] != '\0'; u++)
+      uHash = uHash * 65599U + (unsigned char)pcKey[u];
+
+   return (unsigned char)((uHash * UINT32_C(0x9e3779b9)) >> 24);
+}
+
+/*helper: return nonzero if some byte of uWord is zero*/
+static uint64_t SymTable_hasZeroByte(uint64_t uWord){
+    return (uWord - uOnes) & ~uWord & uHighs;
+}
+
+/*helper: free the key of oSymTable's entry psEntry unless it lives in
+  a block or is borrowed; an interned key is released to the pool*/
+static void SymTable_freeKey(SymTable_T oSymTable, struct Entry *psEntry){
+    if (psEntry->uFlags & ENTRY_INTERNED)
+        SymTableInterns_release(oSymTable->oInterns, psEntry->pcKey);
+    else if (!(psEntry->uFlags & (ENTRY_IN_BLOCK | ENTRY_BORROWED)))
+        free(psEntry->pcKey);
+}
+
+/*helper: make room in oSymTable for uCapacity entries (a multiple of
+  8). Return 1, or 0 if insufficient memory is available, leaving
+  oSymTable unchanged.*/
+static int SymTable_reserve(SymTable_T oSymTable, size_t uCapacity){
+    struct Entry *psEntries;
+    unsigned char *pucTags;
+
+    assert(uCapacity % 8 == 0);
+
+    if (uCapacity <= oSymTable->uCapacity) return 1;
+    psEntries = (struct Entry*)realloc(oSymTable->psEntries,
+        uCapacity * sizeof(struct Entry));
+    if (psEntries == NULL) return 0;
+    oSymTable->psEntries = psEntries;
+    pucTags = (unsigned char*)realloc(oSymTable->pucTags, uCapacity);
+    if (pucTags == NULL) return 0;
+    /*tags past len are read, though never matched against keys*/
+    memset(pucTags + oSymTable->uCapacity, 0, uCapacity - oSymTable->uCapacity);
+    oSymTable->pucTags = pucTags;
+    oSymTable->uCapacity = uCapacity;
+    return 1;
+}
+
+/*helper: remove the entry at index i from oSymTable, keeping the
+  others in order, without freeing its key*/
+static void SymTable_cut(SymTable_T oSymTable, size_t i){
+    size_t uAfter = oSymTable->len - i - 1;
+
+    memmove(&oSymTable->psEntries[i], &oSymTable->psEntries[i + 1],
+        uAfter * sizeof(struct Entry));
+    memmove(&oSymTable->pucTags[i], &oSymTable->pucTags[i + 1], uAfter);
+    oSymTable->len--;
+    /*the hand stays on the entry it pointed at*/
+    if (i < oSymTable->uHand) oSymTable->uHand--;
+}
+
+SymTable_T SymTable_newSized(size_t uExpected){
+    SymTable_T oSymTable = SymTable_new();
+
+    if (oSymTable == NULL) return NULL;
+    /*without the room, entries are simply allocated as they come*/
+    if (uExpected > 0) SymTable_reserve(oSymTable, (uExpected + 7) / 8 * 8);
+    return oSymTable;
+}
 
 SymTable_T SymTable_new(void){
     SymTable_T oSymTable;
@@ -32,84 +175,443 @@ SymTable_T SymTable_new(void){
     if (oSymTable==NULL){
         return NULL;
     }
-    oSymTable->first = NULL;
+    /*the arrays are allocated by the first put*/
+    oSymTable->psEntries = NULL;
+    oSymTable->pucTags = NULL;
+    oSymTable->uCapacity = 0;
     oSymTable->len = 0;
+    oSymTable->iMoveToFront = 0;
+    oSymTable->oInterns = NULL;
+    oSymTable->psBlocks = NULL;
+    oSymTable->uMaxBindings = 0;
+    oSymTable->pfEvict = NULL;
+    oSymTable->pvEvictExtra = NULL;
+    oSymTable->uHand = 0;
+    oSymTable->iExpiring = 0;
+    oSymTable->ulNow = 0;
+    oSymTable->pfExpire = NULL;
+    oSymTable->pvExpireExtra = NULL;
+#ifdef SYMTABLE_STATS
+    oSymTable->uHits = oSymTable->uHitProbes = 0;
+    oSymTable->uMisses = oSymTable->uMissProbes = 0;
+#endif
    return oSymTable;
 }
 
-/*helper func: given pcKey, return pointer to node if it exists in oSymTable, NULL otherwise*/
-static struct Node * SymTable_exists(SymTable_T oSymTable,const char *pcKey){
-    struct Node *current;
-    struct Node *next;
-    
+int SymTable_adopt(SymTable_T oSymTable, void *pvResource,
+    void (*pfRelease)(void *pvResource)){
+    struct Block *psBlock;
+
+    assert(oSymTable != NULL);
+    assert(pfRelease != NULL);
+
+    psBlock = (struct Block*)malloc(sizeof(struct Block));
+    if (psBlock == NULL) return 0;
+    psBlock->pfRelease = pfRelease;
+    psBlock->pvResource = pvResource;
+    psBlock->psNext = oSymTable->psBlocks;
+    oSymTable->psBlocks = psBlock;
+    return 1;
+}
+
+int SymTable_addFilter(SymTable_T oSymTable){
+    /*the tags already answer most misses without comparing keys*/
+    assert(oSymTable != NULL);
+    return 1;
+}
+
+void SymTable_setMoveToFront(SymTable_T oSymTable, int iEnable){
+    assert(oSymTable != NULL);
+    oSymTable->iMoveToFront = iEnable != 0;
+}
+
+SymTable_T SymTable_newInterned(SymTableInterns_T oInterns){
+    SymTable_T oSymTable;
+
+    assert(oInterns != NULL);
+
+    oSymTable = SymTable_new();
+    if (oSymTable == NULL) return NULL;
+    oSymTable->oInterns = oInterns;
+    return oSymTable;
+}
+
+SymTable_T SymTable_newBounded(size_t uMaxBindings,
+    void (*pfEvict)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra){
+    SymTable_T oSymTable;
+
+    assert(uMaxBindings > 0);
+
+    oSymTable = SymTable_new();
+    if (oSymTable == NULL) return NULL;
+    oSymTable->uMaxBindings = uMaxBindings;
+    oSymTable->pfEvict = pfEvict;
+    oSymTable->pvEvictExtra = pvExtra;
+    return oSymTable;
+}
+
+SymTable_T SymTable_newExpiring(
+    void (*pfExpire)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra){
+    SymTable_T oSymTable;
+
+    oSymTable = SymTable_new();
+    if (oSymTable == NULL) return NULL;
+    oSymTable->iExpiring = 1;
+    oSymTable->pfExpire = pfExpire;
+    oSymTable->pvExpireExtra = pvExtra;
+    return oSymTable;
+}
+
+/*helper: return the time ulTTL units after ulNow, saturating at
+  ULONG_MAX rather than wrapping round to an early expiry*/
+static unsigned long SymTable_deadline(unsigned long ulNow, unsigned long ulTTL){
+    return ulTTL > ULONG_MAX - ulNow ? ULONG_MAX : ulNow + ulTTL;
+}
+
+/*helper: return 1 if psEntry of oSymTable has expired, else 0*/
+static int SymTable_isExpired(SymTable_T oSymTable, struct Entry *psEntry){
+    return (psEntry->uFlags & ENTRY_EXPIRES) && psEntry->ulExpiry <= oSymTable->ulNow;
+}
+
+/*helper: hand psEntry, an expired binding already out of oSymTable,
+  to the table's expiry callback and free its key*/
+static void SymTable_retire(SymTable_T oSymTable, struct Entry *psEntry){
+    if (oSymTable->pfExpire != NULL)
+        (*oSymTable->pfExpire)(psEntry->pcKey, (void*)psEntry->pvValue,
+            (void*)oSymTable->pvExpireExtra);
+    SymTable_freeKey(oSymTable, psEntry);
+}
+
+/*helper: remove the expired entry at index i from oSymTable, hand it
+  to the table's expiry callback and free its key*/
+static void SymTable_reclaim(SymTable_T oSymTable, size_t i){
+    struct Entry sEntry = oSymTable->psEntries[i];
+
+    SymTable_cut(oSymTable, i);
+    SymTable_retire(oSymTable, &sEntry);
+}
+
+/*helper: evict one binding from bounded oSymTable using the CLOCK
+  algorithm. The hand goes round the array from where it last stopped,
+  clearing each referenced binding's bit and evicting the first binding
+  whose bit is clear; it then points at the binding after the victim.
+  Every bit it passes is cleared, so it stops within one revolution.*/
+static void SymTable_evict(SymTable_T oSymTable){
+    struct Entry sEntry;
+    size_t uVictim;
+
+    assert(oSymTable != NULL);
+    assert(oSymTable->len > 0);
+
+    for (;;){
+        if (oSymTable->uHand >= oSymTable->len) oSymTable->uHand = 0;
+        if (!(oSymTable->psEntries[oSymTable->uHand].uFlags & ENTRY_REFERENCED))
+            break;
+        oSymTable->psEntries[oSymTable->uHand].uFlags &= ~(unsigned int)ENTRY_REFERENCED;
+        oSymTable->uHand++;
+    }
+    uVictim = oSymTable->uHand;
+
+    sEntry = oSymTable->psEntries[uVictim];
+    SymTable_cut(oSymTable, uVictim);
+    if (oSymTable->pfEvict != NULL)
+        (*oSymTable->pfEvict)(sEntry.pcKey, (void*)sEntry.pvValue,
+            (void*)oSymTable->pvEvictExtra);
+    SymTable_freeKey(oSymTable, &sEntry);
+}
+
+/*helper: note that bounded oSymTable's binding psEntry was just used;
+  the bit is only stored when it changes, so repeated hits stay reads*/
+static void SymTable_touch(SymTable_T oSymTable, struct Entry *psEntry){
+    if (oSymTable->uMaxBindings != 0 && !(psEntry->uFlags & ENTRY_REFERENCED))
+        psEntry->uFlags |= ENTRY_REFERENCED;
+}
+
+int SymTable_addReverseIndex(SymTable_T oSymTable){
+    /*SymTable_findKeyByValue scans the array instead*/
+    assert(oSymTable != NULL);
+    return 1;
+}
+
+const char *SymTable_findKeyByValue(SymTable_T oSymTable, const void *pvValue){
+    struct Entry *psEntry;
+    size_t i;
+
+    assert(oSymTable != NULL);
+
+    for (i = oSymTable->len; i-- > 0; ){
+        psEntry = &oSymTable->psEntries[i];
+        if (psEntry->pvValue == pvValue && !SymTable_isExpired(oSymTable, psEntry))
+            return psEntry->pcKey;
+    }
+    return NULL;
+}
+
+/*helper func: given pcKey whose tag is ucTag, return the index of its
+  entry in oSymTable, expired or not, or NOT_FOUND, adding the keys
+  compared to *puProbes. Tags are compared 8 at a time (SWAR). An
+  interned table looks pcKey up in its pool once and then compares keys
+  by address only. Nothing in the table changes.*/
+static size_t SymTable_scan(SymTable_T oSymTable, const char *pcKey,
+    unsigned char ucTag, size_t *puProbes){
+    const uint64_t uTags = uOnes * ucTag;
+    uint64_t uWord;
+    size_t i;
+    size_t j;
+
     assert(oSymTable != NULL);
     assert(pcKey!=NULL);
 
-    for (current = oSymTable->first;
-        current != NULL;
-        current = next)
-    {
-        if (strcmp((current->pcKey), pcKey)==0){
-            return current;
+    /*a key the pool lacks is in no table made against it*/
+    if (oSymTable->oInterns != NULL){
+        pcKey = SymTableInterns_find(oSymTable->oInterns, pcKey,
+            SymTableInterns_hash(pcKey));
+        if (pcKey == NULL) return NOT_FOUND;
+    }
+
+    for (i = 0; i < oSymTable->len; i += 8){
+        memcpy(&uWord, oSymTable->pucTags + i, 8);
+        if (!SymTable_hasZeroByte(uWord ^ uTags)) continue;
+        for (j = i; j < i + 8 && j < oSymTable->len; j++){
+            if (oSymTable->pucTags[j] != ucTag) continue;
+            (*puProbes)++;
+            if (oSymTable->psEntries[j].pcKey == pcKey || (oSymTable->oInterns == NULL
+                && strcmp(oSymTable->psEntries[j].pcKey, pcKey) == 0))
+                return j;
         }
-        next = current->next;
     }
-    return NULL;
+    return NOT_FOUND;
+}
+
+/*helper func: given pcKey whose tag is ucTag, return the index of its
+  entry if it exists in oSymTable, NOT_FOUND otherwise. A binding found
+  expired is reclaimed on the spot and treated as absent, and one found
+  in a move-to-front table is first moved to index 0.*/
+static size_t SymTable_find(SymTable_T oSymTable, const char *pcKey,
+    unsigned char ucTag){
+    struct Entry sEntry;
+    size_t uProbes = 0;
+    size_t j;
+
+    j = SymTable_scan(oSymTable, pcKey, ucTag, &uProbes);
+    if (j != NOT_FOUND && SymTable_isExpired(oSymTable, &oSymTable->psEntries[j])){
+        SymTable_reclaim(oSymTable, j);
+        j = NOT_FOUND;
+    }
+    if (j == NOT_FOUND){
+#ifdef SYMTABLE_STATS
+        oSymTable->uMisses++;
+        oSymTable->uMissProbes += uProbes;
+#endif
+        return NOT_FOUND;
+    }
+#ifdef SYMTABLE_STATS
+    oSymTable->uHits++;
+    oSymTable->uHitProbes += uProbes;
+#endif
+    if (oSymTable->iMoveToFront && j > 0){
+        sEntry = oSymTable->psEntries[j];
+        memmove(&oSymTable->psEntries[1], &oSymTable->psEntries[0],
+            j * sizeof(struct Entry));
+        memmove(&oSymTable->pucTags[1], &oSymTable->pucTags[0], j);
+        oSymTable->psEntries[0] = sEntry;
+        oSymTable->pucTags[0] = ucTag;
+        /*the hand follows the entry it pointed at, or if that was the
+          one moved, goes on to the one after it*/
+        if (oSymTable->uHand <= j) oSymTable->uHand++;
+        j = 0;
+    }
+    return j;
+}
+
+/*helper func: as SymTable_exists, but without side effects: an expired
+  binding counts as absent but stays, nothing moves and no statistics
+  are kept, so the table is only read*/
+static struct Entry *SymTable_peek(SymTable_T oSymTable, const char *pcKey,
+    unsigned char ucTag){
+    size_t uProbes = 0;
+    size_t i = SymTable_scan(oSymTable, pcKey, ucTag, &uProbes);
+
+    if (i == NOT_FOUND || SymTable_isExpired(oSymTable, &oSymTable->psEntries[i]))
+        return NULL;
+    return &oSymTable->psEntries[i];
+}
+
+/*helper func: given pcKey whose tag is ucTag, return pointer to its
+  entry if it exists in oSymTable, NULL otherwise*/
+static struct Entry *SymTable_exists(SymTable_T oSymTable, const char *pcKey,
+    unsigned char ucTag){
+    size_t i = SymTable_find(oSymTable, pcKey, ucTag);
+    return i == NOT_FOUND ? NULL : &oSymTable->psEntries[i];
 }
 
 void SymTable_free(SymTable_T oSymTable){
-    struct Node *current;
-    struct Node *next;
-    
+    struct Block *psBlock;
+    size_t i;
+
     assert(oSymTable != NULL);
 
-   for (current = oSymTable->first;
-        current != NULL;
-        current = next)
-   {
-      next = current->next;
-      free(current->pcKey);
-      free(current);
+   for (i = 0; i < oSymTable->len; i++)
+      SymTable_freeKey(oSymTable, &oSymTable->psEntries[i]);
+   while (oSymTable->psBlocks != NULL){
+      psBlock = oSymTable->psBlocks;
+      oSymTable->psBlocks = psBlock->psNext;
+      if (psBlock->pfRelease != NULL) (*psBlock->pfRelease)(psBlock->pvResource);
+      free(psBlock);
    }
 
+   free(oSymTable->psEntries);
+   free(oSymTable->pucTags);
    free(oSymTable);
 }
 
+/*the arrays stay allocated; only the keys are freed. Their buffers are
+  not kept for reuse: removals move entries down over the slots past
+  len, so those slots cannot hold spare buffers.*/
+void SymTable_clear(SymTable_T oSymTable){
+    size_t i;
+
+    assert(oSymTable != NULL);
+
+    for (i = 0; i < oSymTable->len; i++)
+        SymTable_freeKey(oSymTable, &oSymTable->psEntries[i]);
+    oSymTable->len = 0;
+    oSymTable->uHand = 0;
+}
+
 size_t SymTable_getLength(SymTable_T oSymTable){
     assert(oSymTable!=NULL);
     return oSymTable->len;
 }
 
 
+/*helper: add a binding of a copy of pcKey (whose tag is ucTag and
+  which must be absent) to pvValue at the back of oSymTable, with entry
+  flags uFlags; if they include ENTRY_BORROWED, pcKey itself is stored.
+  An interned table stores the pool's copy instead, borrowed or not.
+  Return the new entry, or NULL if insufficient memory is available.*/
+static struct Entry *SymTable_insert(SymTable_T oSymTable,
+    const char *pcKey, unsigned char ucTag, const void *pvValue,
+    unsigned int uFlags){
+    struct Entry *psEntry;
+    char *pcKeyCopy;
+
+    /*a full bounded table makes room first*/
+    if (oSymTable->uMaxBindings != 0 && oSymTable->len >= oSymTable->uMaxBindings)
+        SymTable_evict(oSymTable);
+
+    if (oSymTable->len == oSymTable->uCapacity
+        && !SymTable_reserve(oSymTable, oSymTable->uCapacity == 0
+            ? MIN_CAPACITY : oSymTable->uCapacity * 2))
+        return NULL;
+
+    if (oSymTable->oInterns != NULL){
+        uFlags = (uFlags & ~(unsigned int)ENTRY_BORROWED) | ENTRY_INTERNED;
+        pcKeyCopy = (char*)SymTableInterns_acquire(oSymTable->oInterns, pcKey,
+            SymTableInterns_hash(pcKey));
+        if (pcKeyCopy == NULL) return NULL;
+    }
+    else if (uFlags & ENTRY_BORROWED) pcKeyCopy = (char*)pcKey;
+    else {
+        pcKeyCopy = malloc(sizeof(char)* (strlen(pcKey)+1));
+        if (pcKeyCopy==NULL) return NULL;
+        strcpy(pcKeyCopy,pcKey);
+    }
+    psEntry = &oSymTable->psEntries[oSymTable->len];
+    psEntry->pcKey = pcKeyCopy;
+    psEntry->pvValue = pvValue;
+    psEntry->uFlags = uFlags;
+    psEntry->ulExpiry = 0;
+    oSymTable->pucTags[oSymTable->len] = ucTag;
+    oSymTable->len ++;
+    return psEntry;
+}
+
 int SymTable_put(SymTable_T oSymTable,
     const char *pcKey, const void *pvValue){
-    struct Node *newNode;
-    struct Node* present;
-    char *pcKeyCopy;
+    unsigned char ucTag;
 
     assert(oSymTable != NULL);
     assert(pcKey!=NULL);
 
-    present = SymTable_exists(oSymTable, pcKey);
-    if (present!=NULL) return 0;
-    else {
-        newNode = (struct Node*)malloc(sizeof(struct Node));
-        if (newNode == NULL)
-            return 0;
+    ucTag = SymTable_tag(pcKey);
+    if (SymTable_exists(oSymTable, pcKey, ucTag) != NULL) return 0;
+    return SymTable_insert(oSymTable, pcKey, ucTag, pvValue, 0) != NULL;
+}
 
-        pcKeyCopy = malloc(sizeof(char)* (strlen(pcKey)+1));
-        if (pcKeyCopy==NULL) {
-            free(newNode);
+int SymTable_putBorrowed(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue){
+    unsigned char ucTag;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    ucTag = SymTable_tag(pcKey);
+    if (SymTable_exists(oSymTable, pcKey, ucTag) != NULL) return 0;
+    return SymTable_insert(oSymTable, pcKey, ucTag, pvValue,
+        ENTRY_BORROWED) != NULL;
+}
+
+int SymTable_putBorrowedBatch(SymTable_T oSymTable,
+    const char *const *ppcKeys, const void *const *ppvValues, size_t uCount){
+    unsigned char ucTag;
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(ppcKeys != NULL);
+    assert(ppvValues != NULL);
+
+    /*one allocation for the whole batch (it may hold duplicates)*/
+    if (oSymTable->uMaxBindings == 0 && oSymTable->len + uCount > oSymTable->uCapacity)
+        SymTable_reserve(oSymTable, (oSymTable->len + uCount + 7) / 8 * 8);
+    for (i = 0; i < uCount; i++){
+        ucTag = SymTable_tag(ppcKeys[i]);
+        if (SymTable_exists(oSymTable, ppcKeys[i], ucTag) != NULL) continue;
+        if (SymTable_insert(oSymTable, ppcKeys[i], ucTag, ppvValues[i],
+            ENTRY_BORROWED) == NULL)
             return 0;
+    }
+    return 1;
+}
+
+int SymTable_putWithTTL(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue, unsigned long ulTTL){
+    struct Entry *psEntry;
+    unsigned char ucTag;
+
+    assert(oSymTable != NULL);
+    assert(oSymTable->iExpiring);
+    assert(pcKey != NULL);
+
+    ucTag = SymTable_tag(pcKey);
+    if (SymTable_exists(oSymTable, pcKey, ucTag) != NULL) return 0;
+    psEntry = SymTable_insert(oSymTable, pcKey, ucTag, pvValue, 0);
+    if (psEntry == NULL) return 0;
+    psEntry->uFlags |= ENTRY_EXPIRES;
+    psEntry->ulExpiry = SymTable_deadline(oSymTable->ulNow, ulTTL);
+    return 1;
+}
+
+/*the list has no timer index, so expiry scans every binding*/
+size_t SymTable_expire(SymTable_T oSymTable, unsigned long ulNow,
+    size_t uMaxReclaim){
+    size_t uReclaimed = 0;
+    size_t i = 0;
+
+    assert(oSymTable != NULL);
+    assert(oSymTable->iExpiring);
+
+    if (ulNow > oSymTable->ulNow) oSymTable->ulNow = ulNow;
+    while (i < oSymTable->len && uReclaimed < uMaxReclaim){
+        if (SymTable_isExpired(oSymTable, &oSymTable->psEntries[i])){
+            SymTable_reclaim(oSymTable, i);
+            uReclaimed++;
         }
-        strcpy(pcKeyCopy,pcKey);
-        newNode->pcKey = pcKeyCopy;
-        newNode->pvValue = pvValue;
-        newNode->next = oSymTable->first;
-        oSymTable->first = newNode;
-        oSymTable->len ++;
-        return 1;
+        else i++;
     }
+    return uReclaimed;
 }
 
 
@@ -117,13 +619,14 @@ void *SymTable_replace(SymTable_T oSymTable,
     const char *pcKey, const void *pvValue){
     
     const void * oldVal;
-    struct Node *present; 
+    struct Entry *present; 
 
     assert (oSymTable!=NULL);
     assert(pcKey!=NULL);
 
-    present = SymTable_exists(oSymTable, pcKey);
+    present = SymTable_exists(oSymTable, pcKey, SymTable_tag(pcKey));
     if (present == NULL) return NULL;
+    SymTable_touch(oSymTable, present);
 
     oldVal = present->pvValue;
     present->pvValue = pvValue;
@@ -131,89 +634,446 @@ void *SymTable_replace(SymTable_T oSymTable,
 }
 
 int SymTable_contains(SymTable_T oSymTable, const char *pcKey){
-    struct Node *present; 
+    struct Entry *present; 
     assert(oSymTable!=NULL);
     assert(pcKey!=NULL);
 
-    present = SymTable_exists(oSymTable, pcKey);
+    present = SymTable_exists(oSymTable, pcKey, SymTable_tag(pcKey));
     if (present==NULL) return 0;
+    SymTable_touch(oSymTable, present);
     return 1;
 }
 
 void *SymTable_get(SymTable_T oSymTable, const char *pcKey){
-    struct Node *present; 
+    struct Entry *present; 
     assert(oSymTable!=NULL);
     assert(pcKey!=NULL);
 
-    present = SymTable_exists(oSymTable, pcKey);
+    present = SymTable_exists(oSymTable, pcKey, SymTable_tag(pcKey));
     if (present==NULL) return NULL;
+    SymTable_touch(oSymTable, present);
     return (void*)(present->pvValue);
 }
 
 void *SymTable_remove(SymTable_T oSymTable, const char *pcKey){
-    struct Node *current;
-    struct Node *prev;
-    struct Node *target;
-    const void *val;
+    struct Entry sEntry;
+    size_t i;
 
-    
     assert(oSymTable != NULL);
     assert(pcKey!=NULL);
 
-    target = SymTable_exists(oSymTable,pcKey);
-    if (target==NULL){
-        return NULL;
-    }
+    /*the index found by the lookup is the one to cut, so one scan suffices*/
+    i = SymTable_find(oSymTable, pcKey, SymTable_tag(pcKey));
+    if (i == NOT_FOUND) return NULL;
 
+    sEntry = oSymTable->psEntries[i];
+    SymTable_cut(oSymTable, i);
+    SymTable_freeKey(oSymTable, &sEntry);
+    return (void*)sEntry.pvValue;
+}
 
-    current = oSymTable->first;
-    prev = NULL;
-    while(current!=target&&current!=NULL){
-        prev = current;
-        current = current->next;
-    }
+/*helper: return the entry of the binding in oSymTable with key pcKey,
+  adding a binding of pcKey to pvValue first if there is none, with one
+  scan of the tags. Set *piAdded to 1 if the binding was added, else 0.
+  Return NULL if insufficient memory is available.*/
+static struct Entry *SymTable_findOrInsert(SymTable_T oSymTable,
+    const char *pcKey, const void *pvValue, int *piAdded){
+    struct Entry *present;
+    unsigned char ucTag;
 
-    if (current == NULL) return NULL; 
-    oSymTable->len--;
-    val = current->pvValue;
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
 
-    /*check if target was first*/
-    if (current==oSymTable->first){
-        oSymTable->first = current->next;
-    }
-    else {
-        if (prev!=NULL){
-            prev->next = current->next;
-        }
-        
+    ucTag = SymTable_tag(pcKey);
+    present = SymTable_exists(oSymTable, pcKey, ucTag);
+    if (present != NULL){
+        SymTable_touch(oSymTable, present);
+        *piAdded = 0;
+        return present;
     }
+    *piAdded = 1;
+    return SymTable_insert(oSymTable, pcKey, ucTag, pvValue, 0);
+}
+
+int SymTable_upsert(SymTable_T oSymTable, const char *pcKey,
+    const void *pvValue, void **ppvOldValue){
+    struct Entry *psEntry;
+    int iAdded;
+
+    psEntry = SymTable_findOrInsert(oSymTable, pcKey, pvValue, &iAdded);
+    if (psEntry == NULL) return 0;
+    if (ppvOldValue != NULL)
+        *ppvOldValue = iAdded ? NULL : (void*)psEntry->pvValue;
+    psEntry->pvValue = pvValue;
+    return 1;
+}
+
+void *SymTable_getOrPut(SymTable_T oSymTable, const char *pcKey,
+    const void *pvValue){
+    struct Entry *psEntry;
+    int iAdded;
+
+    psEntry = SymTable_findOrInsert(oSymTable, pcKey, pvValue, &iAdded);
+    if (psEntry == NULL) return NULL;
+    return (void*)psEntry->pvValue;
+}
+
+void **SymTable_slot(SymTable_T oSymTable, const char *pcKey){
+    struct Entry *psEntry;
+    int iAdded;
 
-    free(current->pcKey);
-    free(current);
-    return (void*)val;
+    psEntry = SymTable_findOrInsert(oSymTable, pcKey, NULL, &iAdded);
+    if (psEntry == NULL) return NULL;
+    return (void**)&psEntry->pvValue;
+}
+
+int SymTable_increment(SymTable_T oSymTable, const char *pcKey,
+    long lDelta){
+    struct Entry *psEntry;
+    int iAdded;
+
+    psEntry = SymTable_findOrInsert(oSymTable, pcKey, NULL, &iAdded);
+    if (psEntry == NULL) return 0;
+    psEntry->pvValue = (const void*)((intptr_t)psEntry->pvValue + lDelta);
+    return 1;
+}
+
+int SymTable_incrementAtomic(SymTable_T oSymTable, const char *pcKey,
+    long lDelta){
+    struct Entry *psEntry;
+    int iAdded;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    /*a present key is found without side effects, so that concurrent
+      callers only read the table; adding one needs exclusive access*/
+    psEntry = SymTable_peek(oSymTable, pcKey, SymTable_tag(pcKey));
+    if (psEntry == NULL)
+        psEntry = SymTable_findOrInsert(oSymTable, pcKey, NULL, &iAdded);
+    if (psEntry == NULL) return 0;
+#ifdef __GNUC__
+    /*adds to a pointer operand are not scaled, as if it were a uintptr_t*/
+    __atomic_add_fetch(&psEntry->pvValue, lDelta, __ATOMIC_RELAXED);
+#else
+    psEntry->pvValue = (const void*)((intptr_t)psEntry->pvValue + lDelta);
+#endif
+    return 1;
+}
+
+long SymTable_getCount(SymTable_T oSymTable, const char *pcKey){
+    struct Entry *psEntry;
+    const void *pvValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    psEntry = SymTable_exists(oSymTable, pcKey, SymTable_tag(pcKey));
+    if (psEntry == NULL) return 0;
+#ifdef __GNUC__
+    pvValue = __atomic_load_n(&psEntry->pvValue, __ATOMIC_RELAXED);
+#else
+    pvValue = psEntry->pvValue;
+#endif
+    return (long)(intptr_t)pvValue;
 }
 
 void SymTable_map(SymTable_T oSymTable,
      void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
      const void *pvExtra)
 {
+    struct Entry *psEntry;
+    size_t i;
 
-    struct Node *current;
-    struct Node *next;
-    
     assert(oSymTable != NULL);
     assert(pfApply!= NULL);
 
-    for (current = oSymTable->first;
-        current != NULL;
-        current = next)
+    /*newest first, as when bindings were pushed on a linked list*/
+    for (i = oSymTable->len; i-- > 0; )
     {
+        psEntry = &oSymTable->psEntries[i];
+        /*expired bindings not yet reclaimed are already gone*/
+        if (SymTable_isExpired(oSymTable, psEntry)) continue;
         
         /*call (*pfApply)(pcKey, pvValue, pvExtra) for each pcKey/pvValue binding in oSymTable.*/
-        (*pfApply)((char*)current->pcKey, (void*)current->pvValue, (void*)pvExtra);
-        next = current->next;
+        (*pfApply)((char*)psEntry->pcKey, (void*)psEntry->pvValue, (void*)pvExtra);
+
+    }
+}
+
+/*survivors slide down over removed entries, so the sweep stays O(n)*/
+size_t SymTable_removeIf(SymTable_T oSymTable,
+    int (*pfTest)(const char *pcKey, void *pvValue, void *pvExtra),
+    void (*pfRemoved)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra){
+    struct Entry *psEntry;
+    size_t uKept = 0;
+    size_t uRemoved = 0;
+    size_t uHand = 0;
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(pfTest != NULL);
+
+    for (i = 0; i < oSymTable->len; i++){
+        /*the hand moves to the first survivor at or after its entry*/
+        if (i == oSymTable->uHand) uHand = uKept;
+        psEntry = &oSymTable->psEntries[i];
+        if (SymTable_isExpired(oSymTable, psEntry)){
+            if (oSymTable->pfExpire != NULL)
+                (*oSymTable->pfExpire)(psEntry->pcKey, (void*)psEntry->pvValue,
+                    (void*)oSymTable->pvExpireExtra);
+            SymTable_freeKey(oSymTable, psEntry);
+            continue;
+        }
+        if ((*pfTest)(psEntry->pcKey, (void*)psEntry->pvValue, (void*)pvExtra)){
+            uRemoved++;
+            if (pfRemoved != NULL)
+                (*pfRemoved)(psEntry->pcKey, (void*)psEntry->pvValue, (void*)pvExtra);
+            SymTable_freeKey(oSymTable, psEntry);
+            continue;
+        }
+        if (uKept != i){
+            oSymTable->psEntries[uKept] = *psEntry;
+            oSymTable->pucTags[uKept] = oSymTable->pucTags[i];
+        }
+        uKept++;
+    }
+    oSymTable->len = uKept;
+    oSymTable->uHand = uHand;
+    return uRemoved;
+}
+
+/*the tags cached in the parallel array stand in for hashing again, and
+  the other table is only peeked at*/
+void SymTable_diff(SymTable_T oA, SymTable_T oB,
+    void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra){
+    struct Entry *psEntry;
+    size_t i;
+
+    assert(oA != NULL);
+    assert(oB != NULL);
+    assert(pfApply != NULL);
+
+    for (i = oA->len; i-- > 0; ){
+        psEntry = &oA->psEntries[i];
+        if (SymTable_isExpired(oA, psEntry)) continue;
+        if (SymTable_peek(oB, psEntry->pcKey, oA->pucTags[i]) == NULL)
+            (*pfApply)(psEntry->pcKey, (void*)psEntry->pvValue, (void*)pvExtra);
+    }
+}
+
+void SymTable_intersectMap(SymTable_T oA, SymTable_T oB,
+    void (*pfApply)(const char *pcKey, void *pvValueA, void *pvValueB,
+        void *pvExtra),
+    const void *pvExtra){
+    struct Entry *psEntry;
+    struct Entry *psOther;
+    size_t i;
+
+    assert(oA != NULL);
+    assert(oB != NULL);
+    assert(pfApply != NULL);
+
+    for (i = oA->len; i-- > 0; ){
+        psEntry = &oA->psEntries[i];
+        if (SymTable_isExpired(oA, psEntry)) continue;
+        psOther = SymTable_peek(oB, psEntry->pcKey, oA->pucTags[i]);
+        if (psOther != NULL)
+            (*pfApply)(psEntry->pcKey, (void*)psEntry->pvValue,
+                (void*)psOther->pvValue, (void*)pvExtra);
+    }
+}
+
+/*helper: reclaim the entry of pcKey (whose tag is ucTag) in oSymTable
+  if it has expired, as a lookup would before the key is added again,
+  but without moving or counting anything*/
+static void SymTable_reclaimExpired(SymTable_T oSymTable, const char *pcKey,
+    unsigned char ucTag){
+    size_t uProbes = 0;
+    size_t j;
+
+    if (!oSymTable->iExpiring) return;
+    j = SymTable_scan(oSymTable, pcKey, ucTag, &uProbes);
+    if (j != NOT_FOUND && SymTable_isExpired(oSymTable, &oSymTable->psEntries[j]))
+        SymTable_reclaim(oSymTable, j);
+}
+
+int SymTable_unionInto(SymTable_T oDst, SymTable_T oSrc){
+    struct Entry *psEntry;
+    size_t i;
+
+    assert(oDst != NULL);
+    assert(oSrc != NULL);
+    assert(oDst != oSrc);
+
+    /*oldest first, so the added bindings keep their order*/
+    for (i = 0; i < oSrc->len; i++){
+        psEntry = &oSrc->psEntries[i];
+        if (SymTable_isExpired(oSrc, psEntry)) continue;
+        if (SymTable_peek(oDst, psEntry->pcKey, oSrc->pucTags[i]) != NULL) continue;
+        SymTable_reclaimExpired(oDst, psEntry->pcKey, oSrc->pucTags[i]);
+        if (SymTable_insert(oDst, psEntry->pcKey, oSrc->pucTags[i],
+            psEntry->pvValue, 0) == NULL)
+            return 0;
+    }
+    return 1;
+}
+
+size_t SymTable_merge(SymTable_T oDst, SymTable_T oSrc, int iPolicy,
+    void (*pfDropped)(const char *pcKey, void *pvValue, void *pvExtra),
+    const void *pvExtra){
+    struct Entry *psEntry;
+    struct Entry *present;
+    struct Block *psBlock;
+    size_t uConflicts = 0;
+    size_t i;
+
+    assert(oDst != NULL);
+    assert(oSrc != NULL);
+    assert(oDst != oSrc);
+    assert(oDst->oInterns == oSrc->oInterns);
+
+    /*room for every binding at once, so that nothing can fail once keys
+      start changing hands; without it, nothing moves*/
+    if (oDst->len + oSrc->len > oDst->uCapacity
+        && !SymTable_reserve(oDst, (oDst->len + oSrc->len + 7) / 8 * 8))
+        return 0;
+
+    /*moved keys may live in oSrc's blocks or adopted resources*/
+    while (oSrc->psBlocks != NULL){
+        psBlock = oSrc->psBlocks;
+        oSrc->psBlocks = psBlock->psNext;
+        psBlock->psNext = oDst->psBlocks;
+        oDst->psBlocks = psBlock;
+    }
+
+    /*oldest first, so the moved bindings keep their order*/
+    for (i = 0; i < oSrc->len; i++){
+        psEntry = &oSrc->psEntries[i];
+        if (SymTable_isExpired(oSrc, psEntry)){
+            SymTable_retire(oSrc, psEntry);
+            continue;
+        }
+        present = SymTable_exists(oDst, psEntry->pcKey, oSrc->pucTags[i]);
+        if (present != NULL){
+            uConflicts++;
+            if (iPolicy == SYMTABLE_MERGE_REPLACE){
+                if (pfDropped != NULL)
+                    (*pfDropped)(present->pcKey, (void*)present->pvValue, (void*)pvExtra);
+                present->pvValue = psEntry->pvValue;
+            }
+            else if (pfDropped != NULL)
+                (*pfDropped)(psEntry->pcKey, (void*)psEntry->pvValue, (void*)pvExtra);
+            SymTable_freeKey(oSrc, psEntry);
+            continue;
+        }
+        /*an expiry keeps the time it had left, on oDst's clock*/
+        if (psEntry->uFlags & ENTRY_EXPIRES){
+            assert(oDst->iExpiring);
+            psEntry->ulExpiry = SymTable_deadline(oDst->ulNow,
+                psEntry->ulExpiry - oSrc->ulNow);
+        }
+        oDst->psEntries[oDst->len] = *psEntry;
+        oDst->pucTags[oDst->len] = oSrc->pucTags[i];
+        oDst->len++;
+    }
+    oSrc->len = 0;
+    oSrc->uHand = 0;
+
+    /*a bounded oDst sheds what it cannot hold*/
+    while (oDst->uMaxBindings != 0 && oDst->len > oDst->uMaxBindings)
+        SymTable_evict(oDst);
+    return uConflicts;
+}
+
+SymTable_T SymTable_clone(SymTable_T oSymTable){
+    SymTable_T oClone;
+    struct Block *psBlock;
+    char *pcKeys;
+    size_t uKeyBytes = 0;
+    size_t uLength;
+    size_t i;
+
+    assert(oSymTable != NULL);
 
+    oClone = SymTable_new();
+    if (oClone == NULL) return NULL;
+    oClone->iMoveToFront = oSymTable->iMoveToFront;
+    oClone->oInterns = oSymTable->oInterns;
+    oClone->uMaxBindings = oSymTable->uMaxBindings;
+    oClone->pfEvict = oSymTable->pfEvict;
+    oClone->pvEvictExtra = oSymTable->pvEvictExtra;
+    oClone->iExpiring = oSymTable->iExpiring;
+    oClone->ulNow = oSymTable->ulNow;
+    oClone->pfExpire = oSymTable->pfExpire;
+    oClone->pvExpireExtra = oSymTable->pvExpireExtra;
+    if (oSymTable->len == 0) return oClone;
+
+    /*the arrays copy as they are; the keys go in one block, except
+      interned ones, which are shared with the source*/
+    for (i = 0; i < oSymTable->len; i++)
+        if (!(oSymTable->psEntries[i].uFlags & ENTRY_INTERNED))
+            uKeyBytes += strlen(oSymTable->psEntries[i].pcKey) + 1;
+    psBlock = (struct Block*)malloc(sizeof(struct Block) + uKeyBytes);
+    if (psBlock == NULL || !SymTable_reserve(oClone, (oSymTable->len + 7) / 8 * 8)){
+        free(psBlock);
+        SymTable_free(oClone);
+        return NULL;
     }
+    psBlock->psNext = NULL;
+    psBlock->pfRelease = NULL;
+    oClone->psBlocks = psBlock;
+    pcKeys = (char*)(psBlock + 1);
+
+    memcpy(oClone->pucTags, oSymTable->pucTags, oSymTable->len);
+    for (i = 0; i < oSymTable->len; i++){
+        if (oSymTable->psEntries[i].uFlags & ENTRY_INTERNED){
+            SymTableInterns_retain(oClone->oInterns, oSymTable->psEntries[i].pcKey);
+            oClone->psEntries[i].pcKey = oSymTable->psEntries[i].pcKey;
+        }
+        else {
+            uLength = strlen(oSymTable->psEntries[i].pcKey) + 1;
+            memcpy(pcKeys, oSymTable->psEntries[i].pcKey, uLength);
+            oClone->psEntries[i].pcKey = pcKeys;
+            pcKeys += uLength;
+        }
+        oClone->psEntries[i].pvValue = oSymTable->psEntries[i].pvValue;
+        oClone->psEntries[i].uFlags = ENTRY_IN_BLOCK | (oSymTable->psEntries[i].uFlags
+            & (ENTRY_REFERENCED | ENTRY_EXPIRES | ENTRY_INTERNED));
+        oClone->psEntries[i].ulExpiry = oSymTable->psEntries[i].ulExpiry;
+    }
+    oClone->len = oSymTable->len;
+    return oClone;
+}
+
+#ifdef SYMTABLE_STATS
+void SymTable_getStats(SymTable_T oSymTable, struct SymTableStats *psStats){
+    size_t uChain;
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(psStats != NULL);
+
+    /*the whole array is one chain*/
+    memset(psStats, 0, sizeof(struct SymTableStats));
+    psStats->uBucketCount = 1;
+    psStats->dLoadFactor = (double)oSymTable->len;
+    for (i = 0; i < oSymTable->len; i++)
+        if (!(oSymTable->psEntries[i].uFlags & (ENTRY_BORROWED | ENTRY_INTERNED)))
+            psStats->uKeyBytes += strlen(oSymTable->psEntries[i].pcKey) + 1;
+    psStats->uMaxChain = oSymTable->len;
+    uChain = oSymTable->len;
+    if (uChain >= SYMTABLE_STATS_HISTOGRAM) uChain = SYMTABLE_STATS_HISTOGRAM - 1;
+    psStats->auChainHistogram[uChain] = 1;
+    if (oSymTable->uHits > 0)
+        psStats->dAvgProbesHit = (double)oSymTable->uHitProbes / (double)oSymTable->uHits;
+    if (oSymTable->uMisses > 0)
+        psStats->dAvgProbesMiss = (double)oSymTable->uMissProbes / (double)oSymTable->uMisses;
+    /*an entry and its tag stand in for a node*/
+    psStats->uNodeBytes = oSymTable->uCapacity * (sizeof(struct Entry) + 1);
 }
+#endif
 
 /*--------------------------------------------------------------------*/
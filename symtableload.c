@@ -0,0 +1,195 @@
+/*--------------------------------------------------------------------*/
+/* symtableload.c                                                     */
+/* Author: Tara Shukla                                                */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "symtableload.h"
+#include <assert.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*a file mapped into memory*/
+struct Mapping {
+    /*start of the mapping*/
+    void *pvAddress;
+    /*length of the mapping in bytes*/
+    size_t uLength;
+};
+
+/*each byte of a word set to 0x01, and to 0x80*/
+static const uint64_t uOnes = UINT64_C(0x0101010101010101);
+static const uint64_t uHighs = UINT64_C(0x8080808080808080);
+
+/*release function for the table: unmap and free the Mapping pvMapping*/
+static void SymTable_unmap(void *pvMapping){
+    struct Mapping *psMapping = (struct Mapping*)pvMapping;
+    munmap(psMapping->pvAddress, psMapping->uLength);
+    free(psMapping);
+}
+
+/*release function for the table: free pv*/
+static void SymTable_release(void *pv){
+    free(pv);
+}
+
+/*helper: return nonzero if some byte of uWord is zero*/
+static uint64_t SymTable_hasZeroByte(uint64_t uWord){
+    return (uWord - uOnes) & ~uWord & uHighs;
+}
+
+/*helper: return the address of the first tab or newline in [pc, pcEnd),
+  or pcEnd if there is none. Eight bytes are tested at a time (SWAR):
+  a byte matches iff it is zero after xor with the repeated target.*/
+static char *SymTable_scan(char *pc, char *pcEnd, int iTabs){
+    const uint64_t uNewlines = uOnes * (unsigned char)'\n';
+    const uint64_t uTabs = uOnes * (unsigned char)'\t';
+    uint64_t uWord;
+
+    while (pcEnd - pc >= 8){
+        memcpy(&uWord, pc, 8);
+        if (SymTable_hasZeroByte(uWord ^ uNewlines)
+            || (iTabs && SymTable_hasZeroByte(uWord ^ uTabs)))
+            break;
+        pc += 8;
+    }
+    while (pc < pcEnd && *pc != '\n' && !(iTabs && *pc == '\t')) pc++;
+    return pc;
+}
+
+/*lines parsed before their bindings are inserted together*/
+enum {LOAD_BATCH = 256};
+
+/*bindings parsed but not yet inserted*/
+struct Batch {
+    const char *apcKeys[LOAD_BATCH];
+    const void *apvValues[LOAD_BATCH];
+    size_t uCount;
+};
+
+/*helper: insert the bindings in *psBatch into oSymTable and empty it.
+  Return 0 if insufficient memory is available, else 1.*/
+static int SymTable_flush(SymTable_T oSymTable, struct Batch *psBatch){
+    int iSuccessful = SymTable_putBorrowedBatch(oSymTable, psBatch->apcKeys,
+        psBatch->apvValues, psBatch->uCount);
+    psBatch->uCount = 0;
+    return iSuccessful;
+}
+
+/*helper: add the binding on line [pcLine, pcEnd) to *psBatch, flushing
+  it into oSymTable when full; *pcEnd may be overwritten with the key's
+  or value's terminating NUL. Return 0 if insufficient memory is
+  available, else 1.*/
+static int SymTable_loadLine(SymTable_T oSymTable, struct Batch *psBatch,
+    char *pcLine, char *pcEnd, enum SymTableFormat eFormat){
+    char *pcTab;
+
+    if (pcEnd > pcLine && pcEnd[-1] == '\r') pcEnd--;
+    *pcEnd = '\0';
+    if (pcEnd == pcLine) return 1;
+
+    psBatch->apcKeys[psBatch->uCount] = pcLine;
+    psBatch->apvValues[psBatch->uCount] = NULL;
+    if (eFormat == SYMTABLE_FORMAT_TSV){
+        pcTab = SymTable_scan(pcLine, pcEnd, 1);
+        if (pcTab < pcEnd) *pcTab++ = '\0';
+        psBatch->apvValues[psBatch->uCount] = pcTab;
+    }
+    if (++psBatch->uCount == LOAD_BATCH) return SymTable_flush(oSymTable, psBatch);
+    return 1;
+}
+
+SymTable_T SymTable_loadFile(const char *pcPath, enum SymTableFormat eFormat){
+    SymTable_T oSymTable;
+    struct Mapping *psMapping;
+    struct Batch sBatch;
+    struct stat sStat;
+    char *pcStart;
+    char *pcEnd;
+    char *pcLine;
+    char *pcNewline;
+    char *pcLast;
+    size_t uLines = 0;
+    size_t uLength;
+    int iFd;
+
+    assert(pcPath != NULL);
+
+    iFd = open(pcPath, O_RDONLY);
+    if (iFd < 0) return NULL;
+    if (fstat(iFd, &sStat) != 0){
+        close(iFd);
+        return NULL;
+    }
+    uLength = (size_t)sStat.st_size;
+    if (uLength == 0){
+        close(iFd);
+        return SymTable_new();
+    }
+
+    /*a private mapping lets separators become NULs in place; only the
+      pages written are copied, and the file itself is never changed*/
+    pcStart = (char*)mmap(NULL, uLength, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE, iFd, 0);
+    close(iFd);
+    if (pcStart == (char*)MAP_FAILED) return NULL;
+    pcEnd = pcStart + uLength;
+    posix_madvise(pcStart, uLength, POSIX_MADV_SEQUENTIAL);
+
+    psMapping = (struct Mapping*)malloc(sizeof(struct Mapping));
+    if (psMapping == NULL){
+        munmap(pcStart, uLength);
+        return NULL;
+    }
+    psMapping->pvAddress = pcStart;
+    psMapping->uLength = uLength;
+
+    /*count lines first so the buckets never have to grow*/
+    for (pcLine = pcStart; (pcNewline = memchr(pcLine, '\n',
+        (size_t)(pcEnd - pcLine))) != NULL; pcLine = pcNewline + 1)
+        uLines++;
+    oSymTable = SymTable_newSized(uLines + 1);
+    if (oSymTable == NULL || !SymTable_adopt(oSymTable, psMapping, SymTable_unmap)){
+        if (oSymTable != NULL) SymTable_free(oSymTable);
+        SymTable_unmap(psMapping);
+        return NULL;
+    }
+
+    sBatch.uCount = 0;
+    for (pcLine = pcStart; ; pcLine = pcNewline + 1){
+        pcNewline = SymTable_scan(pcLine, pcEnd, 0);
+        if (pcNewline == pcEnd) break;
+        if (!SymTable_loadLine(oSymTable, &sBatch, pcLine, pcNewline, eFormat)){
+            SymTable_free(oSymTable);
+            return NULL;
+        }
+    }
+
+    /*a last line with no newline has nowhere in the mapping to put its
+      NUL, so it is copied*/
+    if (pcLine < pcEnd){
+        pcLast = (char*)malloc((size_t)(pcEnd - pcLine) + 1);
+        if (pcLast == NULL || !SymTable_adopt(oSymTable, pcLast, SymTable_release)){
+            free(pcLast);
+            SymTable_free(oSymTable);
+            return NULL;
+        }
+        memcpy(pcLast, pcLine, (size_t)(pcEnd - pcLine));
+        if (!SymTable_loadLine(oSymTable, &sBatch, pcLast,
+            pcLast + (pcEnd - pcLine), eFormat)){
+            SymTable_free(oSymTable);
+            return NULL;
+        }
+    }
+    if (!SymTable_flush(oSymTable, &sBatch)){
+        SymTable_free(oSymTable);
+        return NULL;
+    }
+    return oSymTable;
+}
+
+/*--------------------------------------------------------------------*/
@@ -0,0 +1,28 @@
+/*--------------------------------------------------------------------*/
+/* symtableload.h                                                     */
+/* Author: Tara Shukla                                                */
+/*--------------------------------------------------------------------*/
+#ifndef SYMTABLELOAD_INCLUDED
+#define SYMTABLELOAD_INCLUDED
+#include "symtable.h"
+
+/*layouts of the files SymTable_loadFile reads; one binding per line*/
+enum SymTableFormat {
+    /*key, tab, value; the value is the rest of the line*/
+    SYMTABLE_FORMAT_TSV,
+    /*just a key; every value is NULL*/
+    SYMTABLE_FORMAT_KEYS
+};
+
+/*return a new SymTable object holding a binding for each nonempty line
+  of the file named pcPath, laid out as eFormat, or NULL if the file
+  cannot be read or insufficient memory is available. When a key
+  repeats, its first line wins. A carriage return ending a line is
+  dropped. The file is mapped into memory and the table's keys and
+  values point into the mapping (values are const char *), which is
+  released with the table; clones copy keys but not values, so they
+  must not outlive it.*/
+SymTable_T SymTable_loadFile(const char *pcPath, enum SymTableFormat eFormat);
+
+/*--------------------------------------------------------------------*/
+#endif
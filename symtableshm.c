@@ -0,0 +1,418 @@
+/*--------------------------------------------------------------------*/
+/* symtableshm.c                                                      */
+/* Author: Tara Shukla                                                */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "symtableshm.h"
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+/*marks a region that holds a table ("SYMT")*/
+enum {SHM_MAGIC = 0x53594d54};
+/*expected region bytes per binding, which sets the bucket count*/
+enum {SHM_BYTES_PER_BUCKET = 64};
+
+/* Everything in the region is addressed by its offset from the start
+   of the region; offset 0 (the header) stands for "none". */
+
+/*start of the region*/
+struct Header {
+    /*SHM_MAGIC once the region is ready to use*/
+    uint32_t uMagic;
+    /*log2 of the bucket count*/
+    uint32_t uBucketBits;
+    /*size of the region in bytes*/
+    uint64_t uSize;
+    /*offset of the first byte not yet allocated*/
+    uint64_t uUsed;
+    /*number of bindings*/
+    uint64_t uLength;
+    /*offset of the bucket array: offsets of the first node of each chain*/
+    uint64_t uBuckets;
+};
+
+/*a binding; the key follows the struct*/
+struct Node {
+    /*offset of the next node in the chain*/
+    uint64_t uNext;
+    /*full hash code of the key*/
+    uint64_t uHash;
+    /*offset of the current struct Value*/
+    uint64_t uValue;
+};
+
+/*a value; its bytes follow the struct*/
+struct Value {
+    /*number of bytes*/
+    uint64_t uLength;
+};
+
+/*a process's handle on a mapped table*/
+struct SymTableShm {
+    /*start of the mapping*/
+    unsigned char *pucBase;
+    /*length of the mapping*/
+    size_t uSize;
+    /*1 if mapped for update by SymTableShm_create, else 0*/
+    int iWritable;
+};
+
+/*helper: return the word at puWord, ordered after the store that
+  published it*/
+static uint64_t SymTableShm_load(const uint64_t *puWord){
+#ifdef __GNUC__
+    return __atomic_load_n(puWord, __ATOMIC_ACQUIRE);
+#else
+    return *(const volatile uint64_t*)puWord;
+#endif
+}
+
+/*helper: store uValue at puWord, after every store made before it*/
+static void SymTableShm_store(uint64_t *puWord, uint64_t uValue){
+#ifdef __GNUC__
+    __atomic_store_n(puWord, uValue, __ATOMIC_RELEASE);
+#else
+    *(volatile uint64_t*)puWord = uValue;
+#endif
+}
+
+/*helper: return the header of oSymTable*/
+static struct Header *SymTableShm_header(SymTableShm_T oSymTable){
+    return (struct Header*)oSymTable->pucBase;
+}
+
+/*helper: return the address of offset uOffset in oSymTable*/
+static void *SymTableShm_at(SymTableShm_T oSymTable, uint64_t uOffset){
+    assert(uOffset < oSymTable->uSize);
+    return oSymTable->pucBase + uOffset;
+}
+
+/*helper: return the hash code of pcKey*/
+static uint64_t SymTableShm_hash(const char *pcKey){
+    const uint64_t uHashMultiplier = 65599;
+    uint64_t uHash = 0;
+    size_t i;
+
+    for (i = 0; pcKey[i] != '\0'; i++)
+        uHash = uHash * uHashMultiplier + (uint64_t)(unsigned char)pcKey[i];
+    return uHash;
+}
+
+/*helper: return the address of the bucket of oSymTable for uHash;
+  the top bits of a Fibonacci product spread the weak low bits*/
+static uint64_t *SymTableShm_bucket(SymTableShm_T oSymTable, uint64_t uHash){
+    struct Header *psHeader = SymTableShm_header(oSymTable);
+    uint64_t *puBuckets = (uint64_t*)SymTableShm_at(oSymTable, psHeader->uBuckets);
+    if (psHeader->uBucketBits == 0) return puBuckets;
+    return &puBuckets[(uHash * UINT64_C(0x9e3779b97f4a7c15))
+        >> (64 - psHeader->uBucketBits)];
+}
+
+/*helper: return the address of the link to the node with key pcKey in
+  oSymTable, or NULL if there is none*/
+static uint64_t *SymTableShm_find(SymTableShm_T oSymTable, const char *pcKey){
+    uint64_t uHash = SymTableShm_hash(pcKey);
+    uint64_t *puLink = SymTableShm_bucket(oSymTable, uHash);
+    uint64_t uNode;
+    struct Node *psNode;
+
+    while ((uNode = SymTableShm_load(puLink)) != 0){
+        psNode = (struct Node*)SymTableShm_at(oSymTable, uNode);
+        if (psNode->uHash == uHash && strcmp((char*)(psNode + 1), pcKey) == 0)
+            return puLink;
+        puLink = &psNode->uNext;
+    }
+    return NULL;
+}
+
+/*helper: return the node with key pcKey in oSymTable, or NULL*/
+static struct Node *SymTableShm_node(SymTableShm_T oSymTable, const char *pcKey){
+    uint64_t *puLink = SymTableShm_find(oSymTable, pcKey);
+    if (puLink == NULL) return NULL;
+    return (struct Node*)SymTableShm_at(oSymTable, SymTableShm_load(puLink));
+}
+
+/*helper: allocate uBytes (rounded up to 8) in oSymTable and return
+  their offset, or 0 if the table is full*/
+static uint64_t SymTableShm_alloc(SymTableShm_T oSymTable, size_t uBytes){
+    struct Header *psHeader = SymTableShm_header(oSymTable);
+    uint64_t uOffset = psHeader->uUsed;
+
+    uBytes = (uBytes + 7) & ~(size_t)7;
+    if (uBytes > psHeader->uSize - uOffset) return 0;
+    psHeader->uUsed += uBytes;
+    return uOffset;
+}
+
+/*helper: copy the uLength bytes at pvValue into a new struct Value in
+  oSymTable and return its offset, or 0 if the table is full*/
+static uint64_t SymTableShm_newValue(SymTableShm_T oSymTable,
+    const void *pvValue, size_t uLength){
+    uint64_t uOffset;
+    struct Value *psValue;
+
+    uOffset = SymTableShm_alloc(oSymTable, sizeof(struct Value) + uLength);
+    if (uOffset == 0) return 0;
+    psValue = (struct Value*)SymTableShm_at(oSymTable, uOffset);
+    psValue->uLength = uLength;
+    if (uLength > 0) memcpy(psValue + 1, pvValue, uLength);
+    return uOffset;
+}
+
+/*--------------------------------------------------------------------*/
+
+SymTableShm_T SymTableShm_create(const char *pcName, size_t uBytes){
+    SymTableShm_T oSymTable;
+    struct Header *psHeader;
+    uint64_t uBucketCount = 1;
+    uint32_t uBucketBits = 0;
+    int iFd;
+
+    assert(pcName != NULL);
+
+    /*room for the header, one bucket and one small binding at least*/
+    if (uBytes < sizeof(struct Header) + SHM_BYTES_PER_BUCKET) return NULL;
+    while (uBucketCount * 2 * SHM_BYTES_PER_BUCKET <= uBytes){
+        uBucketCount *= 2;
+        uBucketBits++;
+    }
+
+    oSymTable = (SymTableShm_T)malloc(sizeof(struct SymTableShm));
+    if (oSymTable == NULL) return NULL;
+
+    shm_unlink(pcName);
+    iFd = shm_open(pcName, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (iFd < 0){
+        free(oSymTable);
+        return NULL;
+    }
+    /*a fresh object reads as zeros, so every bucket starts empty*/
+    if (ftruncate(iFd, (off_t)uBytes) != 0){
+        close(iFd);
+        shm_unlink(pcName);
+        free(oSymTable);
+        return NULL;
+    }
+    oSymTable->pucBase = (unsigned char*)mmap(NULL, uBytes,
+        PROT_READ | PROT_WRITE, MAP_SHARED, iFd, 0);
+    close(iFd);
+    if (oSymTable->pucBase == (unsigned char*)MAP_FAILED){
+        shm_unlink(pcName);
+        free(oSymTable);
+        return NULL;
+    }
+    oSymTable->uSize = uBytes;
+    oSymTable->iWritable = 1;
+
+    psHeader = SymTableShm_header(oSymTable);
+    psHeader->uBucketBits = uBucketBits;
+    psHeader->uSize = uBytes;
+    psHeader->uLength = 0;
+    psHeader->uBuckets = sizeof(struct Header);
+    psHeader->uUsed = sizeof(struct Header) + uBucketCount * sizeof(uint64_t);
+    /*the magic number goes last: attachers reject the region until then*/
+#ifdef __GNUC__
+    __atomic_store_n(&psHeader->uMagic, (uint32_t)SHM_MAGIC, __ATOMIC_RELEASE);
+#else
+    psHeader->uMagic = SHM_MAGIC;
+#endif
+    return oSymTable;
+}
+
+SymTableShm_T SymTableShm_attach(const char *pcName){
+    SymTableShm_T oSymTable;
+    struct Header *psHeader;
+    struct stat sStat;
+    uint32_t uMagic;
+    int iFd;
+
+    assert(pcName != NULL);
+
+    iFd = shm_open(pcName, O_RDONLY, 0);
+    if (iFd < 0) return NULL;
+    if (fstat(iFd, &sStat) != 0 || (size_t)sStat.st_size < sizeof(struct Header)){
+        close(iFd);
+        return NULL;
+    }
+    oSymTable = (SymTableShm_T)malloc(sizeof(struct SymTableShm));
+    if (oSymTable == NULL){
+        close(iFd);
+        return NULL;
+    }
+    oSymTable->uSize = (size_t)sStat.st_size;
+    oSymTable->iWritable = 0;
+    oSymTable->pucBase = (unsigned char*)mmap(NULL, oSymTable->uSize,
+        PROT_READ, MAP_SHARED, iFd, 0);
+    close(iFd);
+    if (oSymTable->pucBase == (unsigned char*)MAP_FAILED){
+        free(oSymTable);
+        return NULL;
+    }
+
+    psHeader = SymTableShm_header(oSymTable);
+#ifdef __GNUC__
+    uMagic = __atomic_load_n(&psHeader->uMagic, __ATOMIC_ACQUIRE);
+#else
+    uMagic = psHeader->uMagic;
+#endif
+    if (uMagic != SHM_MAGIC || psHeader->uSize != oSymTable->uSize){
+        SymTableShm_detach(oSymTable);
+        return NULL;
+    }
+    return oSymTable;
+}
+
+void SymTableShm_detach(SymTableShm_T oSymTable){
+    assert(oSymTable != NULL);
+    munmap(oSymTable->pucBase, oSymTable->uSize);
+    free(oSymTable);
+}
+
+int SymTableShm_unlink(const char *pcName){
+    assert(pcName != NULL);
+    return shm_unlink(pcName) == 0;
+}
+
+size_t SymTableShm_getLength(SymTableShm_T oSymTable){
+    assert(oSymTable != NULL);
+    return (size_t)SymTableShm_load(&SymTableShm_header(oSymTable)->uLength);
+}
+
+int SymTableShm_put(SymTableShm_T oSymTable, const char *pcKey,
+    const void *pvValue, size_t uLength){
+    struct Header *psHeader;
+    struct Node *psNode;
+    uint64_t *puBucket;
+    uint64_t uUsed;
+    uint64_t uValue;
+    uint64_t uNode;
+    size_t uKeyLength;
+
+    assert(oSymTable != NULL);
+    assert(oSymTable->iWritable);
+    assert(pcKey != NULL);
+    assert(pvValue != NULL || uLength == 0);
+
+    if (SymTableShm_find(oSymTable, pcKey) != NULL) return 0;
+
+    psHeader = SymTableShm_header(oSymTable);
+    uUsed = psHeader->uUsed;
+    uKeyLength = strlen(pcKey) + 1;
+    uValue = SymTableShm_newValue(oSymTable, pvValue, uLength);
+    uNode = uValue == 0 ? 0
+        : SymTableShm_alloc(oSymTable, sizeof(struct Node) + uKeyLength);
+    if (uNode == 0){
+        /*give back the value too; nothing points at it yet*/
+        psHeader->uUsed = uUsed;
+        return 0;
+    }
+    psNode = (struct Node*)SymTableShm_at(oSymTable, uNode);
+    psNode->uHash = SymTableShm_hash(pcKey);
+    psNode->uValue = uValue;
+    memcpy(psNode + 1, pcKey, uKeyLength);
+
+    /*publish the finished node at the head of its chain*/
+    puBucket = SymTableShm_bucket(oSymTable, psNode->uHash);
+    psNode->uNext = *puBucket;
+    SymTableShm_store(puBucket, uNode);
+    SymTableShm_store(&psHeader->uLength, psHeader->uLength + 1);
+    return 1;
+}
+
+int SymTableShm_replace(SymTableShm_T oSymTable, const char *pcKey,
+    const void *pvValue, size_t uLength){
+    struct Node *psNode;
+    uint64_t uValue;
+
+    assert(oSymTable != NULL);
+    assert(oSymTable->iWritable);
+    assert(pcKey != NULL);
+    assert(pvValue != NULL || uLength == 0);
+
+    psNode = SymTableShm_node(oSymTable, pcKey);
+    if (psNode == NULL) return 0;
+    uValue = SymTableShm_newValue(oSymTable, pvValue, uLength);
+    if (uValue == 0) return 0;
+    /*readers see the old value or the new one, never a mix*/
+    SymTableShm_store(&psNode->uValue, uValue);
+    return 1;
+}
+
+int SymTableShm_contains(SymTableShm_T oSymTable, const char *pcKey){
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+    return SymTableShm_find(oSymTable, pcKey) != NULL;
+}
+
+const void *SymTableShm_get(SymTableShm_T oSymTable, const char *pcKey,
+    size_t *puLength){
+    struct Node *psNode;
+    struct Value *psValue;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    psNode = SymTableShm_node(oSymTable, pcKey);
+    if (psNode == NULL) return NULL;
+    psValue = (struct Value*)SymTableShm_at(oSymTable,
+        SymTableShm_load(&psNode->uValue));
+    if (puLength != NULL) *puLength = (size_t)psValue->uLength;
+    return psValue + 1;
+}
+
+int SymTableShm_remove(SymTableShm_T oSymTable, const char *pcKey){
+    struct Header *psHeader;
+    struct Node *psNode;
+    uint64_t *puLink;
+
+    assert(oSymTable != NULL);
+    assert(oSymTable->iWritable);
+    assert(pcKey != NULL);
+
+    puLink = SymTableShm_find(oSymTable, pcKey);
+    if (puLink == NULL) return 0;
+    /*a reader standing on the node can still follow it onward*/
+    psNode = (struct Node*)SymTableShm_at(oSymTable, *puLink);
+    SymTableShm_store(puLink, psNode->uNext);
+    psHeader = SymTableShm_header(oSymTable);
+    SymTableShm_store(&psHeader->uLength, psHeader->uLength - 1);
+    return 1;
+}
+
+void SymTableShm_map(SymTableShm_T oSymTable,
+    void (*pfApply)(const char *pcKey, const void *pvValue, size_t uLength,
+        void *pvExtra),
+    const void *pvExtra){
+    struct Header *psHeader;
+    struct Node *psNode;
+    struct Value *psValue;
+    uint64_t *puBuckets;
+    uint64_t uNode;
+    uint64_t i;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    psHeader = SymTableShm_header(oSymTable);
+    puBuckets = (uint64_t*)SymTableShm_at(oSymTable, psHeader->uBuckets);
+    for (i = 0; i < ((uint64_t)1 << psHeader->uBucketBits); i++){
+        for (uNode = SymTableShm_load(&puBuckets[i]); uNode != 0;
+            uNode = SymTableShm_load(&psNode->uNext)){
+            psNode = (struct Node*)SymTableShm_at(oSymTable, uNode);
+            psValue = (struct Value*)SymTableShm_at(oSymTable,
+                SymTableShm_load(&psNode->uValue));
+            (*pfApply)((const char*)(psNode + 1), psValue + 1,
+                (size_t)psValue->uLength, (void*)pvExtra);
+        }
+    }
+}
+
+/*--------------------------------------------------------------------*/
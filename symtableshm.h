@@ -0,0 +1,86 @@
+/*--------------------------------------------------------------------*/
+/* symtableshm.h                                                      */
+/* Author: Tara Shukla                                                */
+/*--------------------------------------------------------------------*/
+#ifndef SYMTABLESHM_INCLUDED
+#define SYMTABLESHM_INCLUDED
+#include <stddef.h>
+
+/* symtableshm.c implements a symbol table that lives in a named POSIX
+   shared-memory object, laid out with offsets instead of pointers so
+   that every process can map it at a different address. One process
+   creates and updates the table; any number of others attach to it
+   read-only and look bindings up in place. Values are byte strings
+   copied into the table, since pointers mean nothing in another
+   process.
+
+   Storage is append-only: replacing or removing a binding never
+   overwrites bytes a reader may be looking at, and each change is
+   published with a single atomic store, so readers need no locks and
+   never see a half-made change. The price is that space freed by
+   remove and replace is not reused; the table is created with a fixed
+   size, and puts fail once it is full. Only one process at a time may
+   update a table. */
+
+/*struct storing a SymTableShm handle*/
+struct SymTableShm;
+/*SymTableShm_T stores pointer to a SymTableShm handle*/
+typedef struct SymTableShm *SymTableShm_T;
+
+/*create the shared-memory object pcName (replacing any old one) holding
+  an empty table of uBytes bytes, map it for update and return a handle
+  to it, or NULL if that fails. pcName is as for shm_open: "/name".*/
+SymTableShm_T SymTableShm_create(const char *pcName, size_t uBytes);
+
+/*map the existing table pcName read-only and return a handle to it,
+  or NULL if it does not exist or is not a table*/
+SymTableShm_T SymTableShm_attach(const char *pcName);
+
+/*unmap oSymTable and free its handle; the table itself stays until
+  SymTableShm_unlink*/
+void SymTableShm_detach(SymTableShm_T oSymTable);
+
+/*remove the shared-memory object pcName; processes that have it mapped
+  keep their mappings. Return 1 on success, else 0.*/
+int SymTableShm_unlink(const char *pcName);
+
+/*return size_t the number of bindings in oSymTable*/
+size_t SymTableShm_getLength(SymTableShm_T oSymTable);
+
+/*add a binding of pcKey to a copy of the uLength bytes at pvValue to
+  oSymTable, which must have been created by this process, and return
+  1 (TRUE); if pcKey already exists or the table is full, leave it
+  unchanged and return 0 (FALSE)*/
+int SymTableShm_put(SymTableShm_T oSymTable, const char *pcKey,
+    const void *pvValue, size_t uLength);
+
+/*if a binding w key pcKey exists in oSymTable, which must have been
+  created by this process, replace its value w a copy of the uLength
+  bytes at pvValue and return 1; else (or if the table is full) leave
+  it unchanged and return 0*/
+int SymTableShm_replace(SymTableShm_T oSymTable, const char *pcKey,
+    const void *pvValue, size_t uLength);
+
+/*return 1 (TRUE) if oSymTable contains a binding whose key is pcKey, else 0 (FALSE)*/
+int SymTableShm_contains(SymTableShm_T oSymTable, const char *pcKey);
+
+/*return the address of the value in oSymTable w key pcKey, storing its
+  length in *puLength unless puLength is NULL, or NULL if no such
+  binding exists. The bytes stay valid while oSymTable is attached,
+  even if the binding is later replaced or removed.*/
+const void *SymTableShm_get(SymTableShm_T oSymTable, const char *pcKey,
+    size_t *puLength);
+
+/*remove the binding in oSymTable, which must have been created by this
+  process, with key pcKey and return 1; if nonexistent, return 0*/
+int SymTableShm_remove(SymTableShm_T oSymTable, const char *pcKey);
+
+/*apply pfApply to each binding's pcKey, value and value length in
+  oSymTable, passing pvExtra as parameter*/
+void SymTableShm_map(SymTableShm_T oSymTable,
+    void (*pfApply)(const char *pcKey, const void *pvValue, size_t uLength,
+        void *pvExtra),
+    const void *pvExtra);
+
+/*--------------------------------------------------------------------*/
+#endif
@@ -0,0 +1,91 @@
+/*--------------------------------------------------------------------*/
+/* symtablestatic.c                                                   */
+/* Author: Tara Shukla                                                */
+/*--------------------------------------------------------------------*/
+
+#include "symtablestatic.h"
+#include <assert.h>
+#include <string.h>
+
+size_t SymTableStatic_hash(const char *pcKey, size_t uSeed)
+{
+   const size_t HASH_MULTIPLIER = 65599;
+   size_t u;
+   size_t uHash = uSeed;
+
+   assert(pcKey != NULL);
+
+   for (u = 0; pcKey[u] != '\0'; u++)
+      uHash = uHash * HASH_MULTIPLIER + (size_t)(unsigned char)pcKey[u];
+
+   /*scramble the bits so that each seed gives an independent placement*/
+   uHash ^= uHash >> 15;
+   uHash *= (size_t)0x2c1b3c6dUL;
+   uHash ^= uHash >> 12;
+   uHash *= (size_t)0x297a2d39UL;
+   uHash ^= uHash >> 15;
+   return uHash;
+}
+
+/*helper func: return the slot pcKey would occupy in oSymTable if present*/
+static const struct SymTableStaticBinding *SymTableStatic_slot(
+    SymTableStatic_T oSymTable, const char *pcKey){
+    size_t uBucket;
+    size_t uSlot;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    uBucket = SymTableStatic_hash(pcKey, 0) % oSymTable->uBucketCount;
+    uSlot = SymTableStatic_hash(pcKey, oSymTable->puSeeds[uBucket])
+        % oSymTable->uSlotCount;
+    return &oSymTable->psSlots[uSlot];
+}
+
+size_t SymTableStatic_getLength(SymTableStatic_T oSymTable){
+    assert(oSymTable != NULL);
+    return oSymTable->len;
+}
+
+int SymTableStatic_contains(SymTableStatic_T oSymTable, const char *pcKey){
+    const struct SymTableStaticBinding *psSlot;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    if (oSymTable->len == 0) return 0;
+    psSlot = SymTableStatic_slot(oSymTable, pcKey);
+    if (psSlot->pcKey == NULL) return 0;
+    return strcmp(psSlot->pcKey, pcKey) == 0;
+}
+
+void *SymTableStatic_get(SymTableStatic_T oSymTable, const char *pcKey){
+    const struct SymTableStaticBinding *psSlot;
+
+    assert(oSymTable != NULL);
+    assert(pcKey != NULL);
+
+    if (oSymTable->len == 0) return NULL;
+    psSlot = SymTableStatic_slot(oSymTable, pcKey);
+    if (psSlot->pcKey == NULL || strcmp(psSlot->pcKey, pcKey) != 0)
+        return NULL;
+    return (void*)psSlot->pcValue;
+}
+
+void SymTableStatic_map(SymTableStatic_T oSymTable,
+     void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+     const void *pvExtra)
+{
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    for (i = 0; i < oSymTable->uSlotCount; i++){
+        if (oSymTable->psSlots[i].pcKey != NULL)
+            (*pfApply)(oSymTable->psSlots[i].pcKey,
+                (void*)oSymTable->psSlots[i].pcValue, (void*)pvExtra);
+    }
+}
+
+/*--------------------------------------------------------------------*/
@@ -0,0 +1,57 @@
+/*--------------------------------------------------------------------*/
+/* symtablestatic.h                                                   */
+/* Author: Tara Shukla                                                */
+/*--------------------------------------------------------------------*/
+#ifndef SYMTABLESTATIC_INCLUDED
+#define SYMTABLESTATIC_INCLUDED
+#include <stddef.h>
+
+/*one slot of a static table: pcKey is NULL if the slot is empty*/
+struct SymTableStaticBinding {
+    /*the binding key*/
+    const char *pcKey;
+    /*the matching value (NULL for key-only bindings)*/
+    const char *pcValue;
+};
+
+/*read-only, perfect-hashed symbol table emitted by symtablegen.
+  All fields are filled in at build time; nothing is allocated.*/
+struct SymTableStatic {
+    /*array of uSlotCount slots, indexed by the perfect hash*/
+    const struct SymTableStaticBinding *psSlots;
+    /*number of slots in psSlots*/
+    size_t uSlotCount;
+    /*per-bucket seed that places that bucket's keys without collision*/
+    const size_t *puSeeds;
+    /*number of first-level buckets (entries in puSeeds)*/
+    size_t uBucketCount;
+    /*number of bindings*/
+    size_t len;
+};
+
+/*SymTableStatic_T stores pointer to a constant static table*/
+typedef const struct SymTableStatic *SymTableStatic_T;
+
+/*return the seeded hash of pcKey; symtablegen and the lookup
+  functions below must agree on it, so both use this one. It works in
+  size_t arithmetic, so a generated table is tied to the width of
+  size_t where it was generated; its source will not compile where
+  size_t is wider or narrower.*/
+size_t SymTableStatic_hash(const char *pcKey, size_t uSeed);
+
+/*return size_t the number of bindings in oSymTable*/
+size_t SymTableStatic_getLength(SymTableStatic_T oSymTable);
+
+/*return 1 (TRUE) if oSymTable contains a binding whose key is pcKey, else 0 (FALSE)*/
+int SymTableStatic_contains(SymTableStatic_T oSymTable, const char *pcKey);
+
+/*return the value in oSymTable w key pcKey, or NULL if no such binding exists*/
+void *SymTableStatic_get(SymTableStatic_T oSymTable, const char *pcKey);
+
+/*apply pfApply to each binding's pcKey and pvValue in oSymTable, passing pvExtra as parameter*/
+void SymTableStatic_map(SymTableStatic_T oSymTable,
+     void (*pfApply)(const char *pcKey, void *pvValue, void *pvExtra),
+     const void *pvExtra);
+
+/*--------------------------------------------------------------------*/
+#endif
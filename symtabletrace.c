@@ -0,0 +1,276 @@
+/*--------------------------------------------------------------------*/
+/* symtabletrace.c                                                    */
+/* Author: Tara Shukla                                                */
+/*--------------------------------------------------------------------*/
+
+#include "symtabletrace.h"
+#include <assert.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* A trace file is a header followed by records:
+     8 bytes   TRACE_MAGIC
+     1 byte    TRACE_VERSION
+     1 byte    SYMTABLE_TRACE_HASHED or SYMTABLE_TRACE_NUMBERED
+   and each record is
+     1 byte    SYMTABLE_TRACE_ kind
+     4 bytes   key token (little-endian)
+     2 bytes   key length, capped at 65535 (little-endian)
+   Fixed-size records keep the file at 7 bytes an operation and let
+   SymTableTrace_load size its array from the file's length. */
+
+/*first bytes of every trace*/
+static const char TRACE_MAGIC[8] = {'S', 'Y', 'M', 'T', 'R', 'A', 'C', 'E'};
+/*format version, and bytes in the header and in a record*/
+enum {TRACE_VERSION = 1, TRACE_HEADER = 10, TRACE_RECORD = 7};
+/*bytes of records buffered before they are written*/
+enum {BUFFER_SIZE = 65536};
+/*largest recorded key length*/
+enum {MAX_KEY_LENGTH = 65535};
+
+/*stores SymTableTrace struct*/
+struct SymTableTrace {
+    /*the table whose operations are recorded*/
+    SymTable_T oTable;
+    /*SYMTABLE_TRACE_HASHED or SYMTABLE_TRACE_NUMBERED*/
+    int iMode;
+    /*for SYMTABLE_TRACE_NUMBERED, each key seen so far bound to its
+      number plus 1, so that no number is stored as NULL*/
+    SymTable_T oNumbers;
+    /*trace file*/
+    FILE *psFile;
+    /*records not yet written to psFile*/
+    unsigned char aucBuffer[BUFFER_SIZE];
+    size_t uBuffered;
+    /*operations recorded*/
+    size_t uLength;
+    /*1 once a record has been dropped*/
+    int iFailed;
+};
+
+/*helper: return the 32-bit FNV-1a hash of pcKey*/
+static uint32_t SymTableTrace_hash(const char *pcKey){
+    uint32_t uHash = UINT32_C(2166136261);
+
+    for (; *pcKey != '\0'; pcKey++){
+        uHash ^= (unsigned char)*pcKey;
+        uHash *= UINT32_C(16777619);
+    }
+    return uHash;
+}
+
+/*helper: store *puToken, the token for pcKey in oTrace; return 1, or 0
+  if insufficient memory is available to number a new key*/
+static int SymTableTrace_token(SymTableTrace_T oTrace, const char *pcKey,
+    uint32_t *puToken){
+    uintptr_t uNumber;
+
+    if (oTrace->iMode == SYMTABLE_TRACE_HASHED){
+        *puToken = SymTableTrace_hash(pcKey);
+        return 1;
+    }
+    uNumber = (uintptr_t)SymTable_get(oTrace->oNumbers, pcKey);
+    if (uNumber == 0){
+        uNumber = SymTable_getLength(oTrace->oNumbers) + 1;
+        if (!SymTable_put(oTrace->oNumbers, pcKey, (void*)uNumber)) return 0;
+    }
+    *puToken = (uint32_t)(uNumber - 1);
+    return 1;
+}
+
+/*helper: write oTrace's buffered records to its file; return 1, or 0 on failure*/
+static int SymTableTrace_flush(SymTableTrace_T oTrace){
+    if (oTrace->uBuffered == 0) return 1;
+    if (fwrite(oTrace->aucBuffer, 1, oTrace->uBuffered, oTrace->psFile)
+        != oTrace->uBuffered)
+        oTrace->iFailed = 1;
+    oTrace->uBuffered = 0;
+    return !oTrace->iFailed;
+}
+
+/*helper: append a record of kind iKind for pcKey to oTrace*/
+static void SymTableTrace_record(SymTableTrace_T oTrace, int iKind,
+    const char *pcKey){
+    unsigned char *pucRecord;
+    uint32_t uToken;
+    size_t uKeyLength;
+
+    if (!SymTableTrace_token(oTrace, pcKey, &uToken)){
+        oTrace->iFailed = 1;
+        return;
+    }
+    uKeyLength = strlen(pcKey);
+    if (uKeyLength > MAX_KEY_LENGTH) uKeyLength = MAX_KEY_LENGTH;
+    if (oTrace->uBuffered + TRACE_RECORD > BUFFER_SIZE)
+        SymTableTrace_flush(oTrace);
+
+    pucRecord = oTrace->aucBuffer + oTrace->uBuffered;
+    pucRecord[0] = (unsigned char)iKind;
+    pucRecord[1] = (unsigned char)uToken;
+    pucRecord[2] = (unsigned char)(uToken >> 8);
+    pucRecord[3] = (unsigned char)(uToken >> 16);
+    pucRecord[4] = (unsigned char)(uToken >> 24);
+    pucRecord[5] = (unsigned char)uKeyLength;
+    pucRecord[6] = (unsigned char)(uKeyLength >> 8);
+    oTrace->uBuffered += TRACE_RECORD;
+    oTrace->uLength++;
+}
+
+/*map function: record binding pcKey as a preload in the trace pvExtra*/
+static void SymTableTrace_recordBinding(const char *pcKey, void *pvValue,
+    void *pvExtra){
+    (void)pvValue;
+    SymTableTrace_record((SymTableTrace_T)pvExtra, SYMTABLE_TRACE_PRELOAD,
+        pcKey);
+}
+
+SymTableTrace_T SymTableTrace_open(SymTable_T oSymTable, const char *pcPath,
+    int iMode){
+    SymTableTrace_T oTrace;
+    unsigned char aucHeader[TRACE_HEADER];
+
+    assert(oSymTable != NULL);
+    assert(pcPath != NULL);
+    assert(iMode == SYMTABLE_TRACE_HASHED || iMode == SYMTABLE_TRACE_NUMBERED);
+
+    oTrace = (SymTableTrace_T)calloc(1, sizeof(struct SymTableTrace));
+    if (oTrace == NULL) return NULL;
+    oTrace->oTable = oSymTable;
+    oTrace->iMode = iMode;
+    if (iMode == SYMTABLE_TRACE_NUMBERED){
+        oTrace->oNumbers = SymTable_new();
+        if (oTrace->oNumbers == NULL){
+            free(oTrace);
+            return NULL;
+        }
+    }
+    oTrace->psFile = fopen(pcPath, "wb");
+    if (oTrace->psFile == NULL){
+        if (oTrace->oNumbers != NULL) SymTable_free(oTrace->oNumbers);
+        free(oTrace);
+        return NULL;
+    }
+
+    memcpy(aucHeader, TRACE_MAGIC, sizeof(TRACE_MAGIC));
+    aucHeader[8] = TRACE_VERSION;
+    aucHeader[9] = (unsigned char)iMode;
+    memcpy(oTrace->aucBuffer, aucHeader, TRACE_HEADER);
+    oTrace->uBuffered = TRACE_HEADER;
+    SymTable_map(oSymTable, SymTableTrace_recordBinding, oTrace);
+    return oTrace;
+}
+
+int SymTableTrace_close(SymTableTrace_T oTrace){
+    int iSuccessful;
+
+    assert(oTrace != NULL);
+
+    SymTableTrace_flush(oTrace);
+    iSuccessful = !oTrace->iFailed;
+    if (fclose(oTrace->psFile) != 0) iSuccessful = 0;
+    if (oTrace->oNumbers != NULL) SymTable_free(oTrace->oNumbers);
+    free(oTrace);
+    return iSuccessful;
+}
+
+size_t SymTableTrace_getLength(SymTableTrace_T oTrace){
+    assert(oTrace != NULL);
+    return oTrace->uLength;
+}
+
+int SymTableTrace_put(SymTableTrace_T oTrace, const char *pcKey,
+    const void *pvValue){
+    assert(oTrace != NULL);
+    assert(pcKey != NULL);
+    SymTableTrace_record(oTrace, SYMTABLE_TRACE_PUT, pcKey);
+    return SymTable_put(oTrace->oTable, pcKey, pvValue);
+}
+
+void *SymTableTrace_replace(SymTableTrace_T oTrace, const char *pcKey,
+    const void *pvValue){
+    assert(oTrace != NULL);
+    assert(pcKey != NULL);
+    SymTableTrace_record(oTrace, SYMTABLE_TRACE_REPLACE, pcKey);
+    return SymTable_replace(oTrace->oTable, pcKey, pvValue);
+}
+
+void *SymTableTrace_get(SymTableTrace_T oTrace, const char *pcKey){
+    assert(oTrace != NULL);
+    assert(pcKey != NULL);
+    SymTableTrace_record(oTrace, SYMTABLE_TRACE_GET, pcKey);
+    return SymTable_get(oTrace->oTable, pcKey);
+}
+
+int SymTableTrace_contains(SymTableTrace_T oTrace, const char *pcKey){
+    assert(oTrace != NULL);
+    assert(pcKey != NULL);
+    SymTableTrace_record(oTrace, SYMTABLE_TRACE_CONTAINS, pcKey);
+    return SymTable_contains(oTrace->oTable, pcKey);
+}
+
+void *SymTableTrace_remove(SymTableTrace_T oTrace, const char *pcKey){
+    assert(oTrace != NULL);
+    assert(pcKey != NULL);
+    SymTableTrace_record(oTrace, SYMTABLE_TRACE_REMOVE, pcKey);
+    return SymTable_remove(oTrace->oTable, pcKey);
+}
+
+/*--------------------------------------------------------------------*/
+
+struct SymTableTraceOp *SymTableTrace_load(const char *pcPath,
+    size_t *puCount, int *piMode){
+    FILE *psFile;
+    unsigned char aucRecord[TRACE_HEADER];
+    struct SymTableTraceOp *psOps;
+    long lSize;
+    size_t uCount;
+    size_t i;
+
+    assert(pcPath != NULL);
+    assert(puCount != NULL);
+
+    psFile = fopen(pcPath, "rb");
+    if (psFile == NULL) return NULL;
+    if (fread(aucRecord, 1, TRACE_HEADER, psFile) != TRACE_HEADER
+        || memcmp(aucRecord, TRACE_MAGIC, sizeof(TRACE_MAGIC)) != 0
+        || aucRecord[8] != TRACE_VERSION
+        || (aucRecord[9] != SYMTABLE_TRACE_HASHED
+            && aucRecord[9] != SYMTABLE_TRACE_NUMBERED)
+        || fseek(psFile, 0, SEEK_END) != 0 || (lSize = ftell(psFile)) < 0
+        || fseek(psFile, TRACE_HEADER, SEEK_SET) != 0){
+        fclose(psFile);
+        return NULL;
+    }
+    if (piMode != NULL) *piMode = aucRecord[9];
+
+    uCount = ((size_t)lSize - TRACE_HEADER) / TRACE_RECORD;
+    /*one spare element so that an empty trace is not mistaken for failure*/
+    psOps = (struct SymTableTraceOp*)malloc((uCount + 1)
+        * sizeof(struct SymTableTraceOp));
+    if (psOps == NULL){
+        fclose(psFile);
+        return NULL;
+    }
+    for (i = 0; i < uCount; i++){
+        if (fread(aucRecord, 1, TRACE_RECORD, psFile) != TRACE_RECORD
+            || aucRecord[0] < SYMTABLE_TRACE_PUT
+            || aucRecord[0] > SYMTABLE_TRACE_PRELOAD){
+            free(psOps);
+            fclose(psFile);
+            return NULL;
+        }
+        psOps[i].iKind = aucRecord[0];
+        psOps[i].ulKey = (unsigned long)aucRecord[1]
+            | (unsigned long)aucRecord[2] << 8
+            | (unsigned long)aucRecord[3] << 16
+            | (unsigned long)aucRecord[4] << 24;
+        psOps[i].uKeyLength = (size_t)aucRecord[5] | (size_t)aucRecord[6] << 8;
+    }
+    fclose(psFile);
+    *puCount = uCount;
+    return psOps;
+}
+
+/*--------------------------------------------------------------------*/
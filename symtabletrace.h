@@ -0,0 +1,89 @@
+/*--------------------------------------------------------------------*/
+/* symtabletrace.h                                                    */
+/* Author: Tara Shukla                                                */
+/*--------------------------------------------------------------------*/
+#ifndef SYMTABLETRACE_INCLUDED
+#define SYMTABLETRACE_INCLUDED
+#include "symtable.h"
+#include <stddef.h>
+
+/* symtabletrace.c records the operations a program performs on a
+   SymTable as a compact binary trace that can be replayed against any
+   backend (see replaysymtable.c) without the program's data. A trace
+   holds no values and no key bytes: each operation is stored as its
+   kind, the key's length and a 32-bit token standing for the key.
+   The program calls SymTableTrace_put and its siblings in place of the
+   SymTable functions they forward to. */
+
+/*how keys are turned into tokens*/
+enum {
+    /*a hash of the key: no memory per key, but distinct keys may share
+      a token, and short or guessable keys can be recovered by hashing
+      candidates*/
+    SYMTABLE_TRACE_HASHED = 1,
+    /*the order in which the key first appeared: exact, reveals nothing
+      about the key, and costs a binding per distinct key*/
+    SYMTABLE_TRACE_NUMBERED = 2
+};
+
+/*kinds of traced operation. SYMTABLE_TRACE_PRELOAD is a binding the
+  table already held when tracing began; replay puts it untimed.*/
+enum {
+    SYMTABLE_TRACE_PUT = 1, SYMTABLE_TRACE_REPLACE = 2,
+    SYMTABLE_TRACE_GET = 3, SYMTABLE_TRACE_CONTAINS = 4,
+    SYMTABLE_TRACE_REMOVE = 5, SYMTABLE_TRACE_PRELOAD = 6
+};
+
+/*one traced operation, as read back by SymTableTrace_load*/
+struct SymTableTraceOp {
+    /*a SYMTABLE_TRACE_ kind*/
+    int iKind;
+    /*key length in bytes, capped at 65535*/
+    size_t uKeyLength;
+    /*token standing for the key*/
+    unsigned long ulKey;
+};
+
+/*struct storing a trace being recorded*/
+struct SymTableTrace;
+/*SymTableTrace_T stores pointer to a trace being recorded*/
+typedef struct SymTableTrace *SymTableTrace_T;
+
+/*start tracing the operations on oSymTable to the file pcPath,
+  replacing any file there, with keys turned into tokens as iMode (a
+  SYMTABLE_TRACE_ mode) says. The bindings oSymTable already holds are
+  recorded first as SYMTABLE_TRACE_PRELOAD. Return the trace, or NULL
+  if the file cannot be written or insufficient memory is available.*/
+SymTableTrace_T SymTableTrace_open(SymTable_T oSymTable, const char *pcPath,
+    int iMode);
+
+/*write any buffered records, close oTrace's file and free all memory
+  occupied by oTrace, but not the table it traces. Return 1, or 0 if
+  any record could not be written.*/
+int SymTableTrace_close(SymTableTrace_T oTrace);
+
+/*return the number of operations recorded to oTrace*/
+size_t SymTableTrace_getLength(SymTableTrace_T oTrace);
+
+/*record each call, then return what SymTable_put, SymTable_replace,
+  SymTable_get, SymTable_contains and SymTable_remove return for the
+  traced table. A record that cannot be written is dropped and makes
+  SymTableTrace_close fail; the table operation happens regardless.*/
+int SymTableTrace_put(SymTableTrace_T oTrace, const char *pcKey,
+    const void *pvValue);
+void *SymTableTrace_replace(SymTableTrace_T oTrace, const char *pcKey,
+    const void *pvValue);
+void *SymTableTrace_get(SymTableTrace_T oTrace, const char *pcKey);
+int SymTableTrace_contains(SymTableTrace_T oTrace, const char *pcKey);
+void *SymTableTrace_remove(SymTableTrace_T oTrace, const char *pcKey);
+
+/*read the trace in the file pcPath into a new array of its operations,
+  storing its length in *puCount and the trace's mode in *piMode unless
+  piMode is NULL. Return the array, which the caller frees, or NULL if
+  the file cannot be read, is not a trace, or insufficient memory is
+  available. A record cut short at the end of the file is ignored.*/
+struct SymTableTraceOp *SymTableTrace_load(const char *pcPath,
+    size_t *puCount, int *piMode);
+
+/*--------------------------------------------------------------------*/
+#endif
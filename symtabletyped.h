@@ -0,0 +1,203 @@
+/*--------------------------------------------------------------------*/
+/* symtabletyped.h                                                    */
+/* Author: Tara Shukla                                                */
+/*--------------------------------------------------------------------*/
+#ifndef SYMTABLETYPED_INCLUDED
+#define SYMTABLETYPED_INCLUDED
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+/* SYMTABLE_DEFINE(Name, KeyType, ValType, hashfn, eqfn) defines a hash
+   table type Name_T whose keys and values are stored by value, with
+   the operations below, all static inline so that the compiler can
+   specialize them, hashfn and eqfn included:
+
+     Name_T Name_new(void);
+     void Name_free(Name_T oTable);
+     size_t Name_getLength(Name_T oTable);
+     int Name_put(Name_T oTable, KeyType key, ValType value);
+     int Name_replace(Name_T oTable, KeyType key, ValType value,
+         ValType *pOldValue);
+     int Name_contains(Name_T oTable, KeyType key);
+     ValType *Name_get(Name_T oTable, KeyType key);
+     int Name_remove(Name_T oTable, KeyType key, ValType *pOldValue);
+     void Name_map(Name_T oTable,
+         void (*pfApply)(const KeyType *pKey, ValType *pValue, void *pvExtra),
+         const void *pvExtra);
+
+   They behave as their SymTable counterparts, except that Name_get
+   returns the address of the stored value (valid until oTable is next
+   changed), and Name_replace and Name_remove return 1 if the key was
+   found, storing the old value in *pOldValue unless pOldValue is NULL.
+   hashfn(key) must return a size_t whose low bits are well mixed, and
+   eqfn(key1, key2) nonzero if the keys are equal; either may be a
+   function-like macro. Slots are probed linearly and the table never
+   allocates anything per binding. */
+
+/*return a well-mixed hash of uKey (the splitmix64 finalizer)*/
+static inline size_t SymTable_hashU64(uint64_t uKey){
+    uKey ^= uKey >> 30;
+    uKey *= UINT64_C(0xbf58476d1ce4e5b9);
+    uKey ^= uKey >> 27;
+    uKey *= UINT64_C(0x94d049bb133111eb);
+    uKey ^= uKey >> 31;
+    return (size_t)uKey;
+}
+
+/*slots a new table starts with; always a power of 2*/
+enum {SYMTABLE_TYPED_MIN_SLOTS = 16};
+
+#define SYMTABLE_DEFINE(Name, KeyType, ValType, hashfn, eqfn)             \
+                                                                          \
+/*one slot of the table: key and value live in place*/                    \
+struct Name##Slot {                                                       \
+    KeyType key;                                                          \
+    ValType value;                                                        \
+    /*1 if the slot holds a binding*/                                     \
+    unsigned char ucFull;                                                 \
+};                                                                        \
+                                                                          \
+struct Name {                                                             \
+    /*array of uSlotCount slots (a power of 2)*/                          \
+    struct Name##Slot *psSlots;                                           \
+    size_t uSlotCount;                                                    \
+    /*number of bindings*/                                                \
+    size_t len;                                                           \
+};                                                                        \
+                                                                          \
+typedef struct Name *Name##_T;                                            \
+                                                                          \
+/*helper: return the index of key's slot in oTable, or of the empty    */ \
+/*slot where it would go                                               */ \
+static inline size_t Name##_find(Name##_T oTable, KeyType key){           \
+    size_t uMask = oTable->uSlotCount - 1;                                \
+    size_t i = (size_t)(hashfn(key)) & uMask;                             \
+    while (oTable->psSlots[i].ucFull && !(eqfn(oTable->psSlots[i].key, key))) \
+        i = (i + 1) & uMask;                                              \
+    return i;                                                             \
+}                                                                         \
+                                                                          \
+/*helper: move every binding of oTable into uSlotCount slots; return */   \
+/*0 if insufficient memory is available, leaving oTable unchanged    */   \
+static inline int Name##_resize(Name##_T oTable, size_t uSlotCount){      \
+    struct Name##Slot *psOld = oTable->psSlots;                           \
+    size_t uOldCount = oTable->uSlotCount;                                \
+    size_t i;                                                             \
+    struct Name##Slot *psNew = (struct Name##Slot*)                       \
+        calloc(uSlotCount, sizeof(struct Name##Slot));                    \
+    if (psNew == NULL) return 0;                                          \
+    oTable->psSlots = psNew;                                              \
+    oTable->uSlotCount = uSlotCount;                                      \
+    for (i = 0; i < uOldCount; i++)                                       \
+        if (psOld[i].ucFull)                                              \
+            psNew[Name##_find(oTable, psOld[i].key)] = psOld[i];          \
+    free(psOld);                                                          \
+    return 1;                                                             \
+}                                                                         \
+                                                                          \
+static inline Name##_T Name##_new(void){                                  \
+    Name##_T oTable = (Name##_T)malloc(sizeof(struct Name));              \
+    if (oTable == NULL) return NULL;                                      \
+    oTable->psSlots = (struct Name##Slot*)                                \
+        calloc(SYMTABLE_TYPED_MIN_SLOTS, sizeof(struct Name##Slot));      \
+    if (oTable->psSlots == NULL){                                         \
+        free(oTable);                                                     \
+        return NULL;                                                      \
+    }                                                                     \
+    oTable->uSlotCount = SYMTABLE_TYPED_MIN_SLOTS;                        \
+    oTable->len = 0;                                                      \
+    return oTable;                                                        \
+}                                                                         \
+                                                                          \
+static inline void Name##_free(Name##_T oTable){                          \
+    assert(oTable != NULL);                                               \
+    free(oTable->psSlots);                                                \
+    free(oTable);                                                         \
+}                                                                         \
+                                                                          \
+static inline size_t Name##_getLength(Name##_T oTable){                   \
+    assert(oTable != NULL);                                               \
+    return oTable->len;                                                   \
+}                                                                         \
+                                                                          \
+static inline int Name##_put(Name##_T oTable, KeyType key, ValType value){ \
+    size_t i;                                                             \
+    assert(oTable != NULL);                                               \
+    i = Name##_find(oTable, key);                                         \
+    if (oTable->psSlots[i].ucFull) return 0;                              \
+    /*keep the load factor at or below 3/4*/                              \
+    if ((oTable->len + 1) * 4 > oTable->uSlotCount * 3){                  \
+        if (!Name##_resize(oTable, oTable->uSlotCount * 2)) return 0;     \
+        i = Name##_find(oTable, key);                                     \
+    }                                                                     \
+    oTable->psSlots[i].key = key;                                         \
+    oTable->psSlots[i].value = value;                                     \
+    oTable->psSlots[i].ucFull = 1;                                        \
+    oTable->len++;                                                        \
+    return 1;                                                             \
+}                                                                         \
+                                                                          \
+static inline int Name##_replace(Name##_T oTable, KeyType key,            \
+    ValType value, ValType *pOldValue){                                   \
+    size_t i;                                                             \
+    assert(oTable != NULL);                                               \
+    i = Name##_find(oTable, key);                                         \
+    if (!oTable->psSlots[i].ucFull) return 0;                             \
+    if (pOldValue != NULL) *pOldValue = oTable->psSlots[i].value;         \
+    oTable->psSlots[i].value = value;                                     \
+    return 1;                                                             \
+}                                                                         \
+                                                                          \
+static inline int Name##_contains(Name##_T oTable, KeyType key){          \
+    assert(oTable != NULL);                                               \
+    return oTable->psSlots[Name##_find(oTable, key)].ucFull;              \
+}                                                                         \
+                                                                          \
+static inline ValType *Name##_get(Name##_T oTable, KeyType key){          \
+    size_t i;                                                             \
+    assert(oTable != NULL);                                               \
+    i = Name##_find(oTable, key);                                         \
+    return oTable->psSlots[i].ucFull ? &oTable->psSlots[i].value : NULL;  \
+}                                                                         \
+                                                                          \
+static inline int Name##_remove(Name##_T oTable, KeyType key,             \
+    ValType *pOldValue){                                                  \
+    size_t uMask;                                                         \
+    size_t i;                                                             \
+    size_t j;                                                             \
+    size_t uHome;                                                         \
+    assert(oTable != NULL);                                               \
+    uMask = oTable->uSlotCount - 1;                                       \
+    i = Name##_find(oTable, key);                                         \
+    if (!oTable->psSlots[i].ucFull) return 0;                             \
+    if (pOldValue != NULL) *pOldValue = oTable->psSlots[i].value;         \
+    /*shift later members of the run back so probes never need       */   \
+    /*tombstones: slot j moves into the hole at i unless its home    */   \
+    /*lies cyclically in (i, j]                                      */   \
+    for (j = (i + 1) & uMask; oTable->psSlots[j].ucFull; j = (j + 1) & uMask){ \
+        uHome = (size_t)(hashfn(oTable->psSlots[j].key)) & uMask;         \
+        if (((j - uHome) & uMask) < ((j - i) & uMask)) continue;          \
+        oTable->psSlots[i] = oTable->psSlots[j];                          \
+        i = j;                                                            \
+    }                                                                     \
+    oTable->psSlots[i].ucFull = 0;                                        \
+    oTable->len--;                                                        \
+    return 1;                                                             \
+}                                                                         \
+                                                                          \
+static inline void Name##_map(Name##_T oTable,                            \
+    void (*pfApply)(const KeyType *pKey, ValType *pValue, void *pvExtra), \
+    const void *pvExtra){                                                 \
+    size_t i;                                                             \
+    assert(oTable != NULL);                                               \
+    assert(pfApply != NULL);                                              \
+    for (i = 0; i < oTable->uSlotCount; i++)                              \
+        if (oTable->psSlots[i].ucFull)                                    \
+            (*pfApply)(&oTable->psSlots[i].key, &oTable->psSlots[i].value, \
+                (void*)pvExtra);                                          \
+}
+
+/*--------------------------------------------------------------------*/
+#endif
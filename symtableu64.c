@@ -0,0 +1,76 @@
+/*--------------------------------------------------------------------*/
+/* symtableu64.c                                                      */
+/* Author: Tara Shukla                                                */
+/*--------------------------------------------------------------------*/
+
+#include "symtableu64.h"
+#include "symtabletyped.h"
+
+/*key comparison for the generated table*/
+#define SYMTABLEU64_EQUAL(uKey1, uKey2) ((uKey1) == (uKey2))
+
+SYMTABLE_DEFINE(SymTableU64Impl, uint64_t, const void *, SymTable_hashU64,
+    SYMTABLEU64_EQUAL)
+
+SymTableU64_T SymTableU64_new(void){
+    return SymTableU64Impl_new();
+}
+
+void SymTableU64_free(SymTableU64_T oSymTable){
+    SymTableU64Impl_free(oSymTable);
+}
+
+size_t SymTableU64_getLength(SymTableU64_T oSymTable){
+    return SymTableU64Impl_getLength(oSymTable);
+}
+
+int SymTableU64_put(SymTableU64_T oSymTable,
+    uint64_t uKey, const void *pvValue){
+    return SymTableU64Impl_put(oSymTable, uKey, pvValue);
+}
+
+void *SymTableU64_replace(SymTableU64_T oSymTable,
+    uint64_t uKey, const void *pvValue){
+    const void *pvOldValue;
+
+    if (!SymTableU64Impl_replace(oSymTable, uKey, pvValue, &pvOldValue))
+        return NULL;
+    return (void*)pvOldValue;
+}
+
+int SymTableU64_contains(SymTableU64_T oSymTable, uint64_t uKey){
+    return SymTableU64Impl_contains(oSymTable, uKey);
+}
+
+void *SymTableU64_get(SymTableU64_T oSymTable, uint64_t uKey){
+    const void **ppvValue = SymTableU64Impl_get(oSymTable, uKey);
+    return ppvValue == NULL ? NULL : (void*)*ppvValue;
+}
+
+void *SymTableU64_remove(SymTableU64_T oSymTable, uint64_t uKey){
+    const void *pvOldValue;
+
+    if (!SymTableU64Impl_remove(oSymTable, uKey, &pvOldValue))
+        return NULL;
+    return (void*)pvOldValue;
+}
+
+void SymTableU64_map(SymTableU64_T oSymTable,
+     void (*pfApply)(uint64_t uKey, void *pvValue, void *pvExtra),
+     const void *pvExtra){
+    struct SymTableU64ImplSlot *psSlot;
+    size_t i;
+
+    assert(oSymTable != NULL);
+    assert(pfApply != NULL);
+
+    /*walk the slots directly: the generated map's callback takes
+      addresses, which this interface does not*/
+    for (i = 0; i < oSymTable->uSlotCount; i++){
+        psSlot = &oSymTable->psSlots[i];
+        if (psSlot->ucFull)
+            (*pfApply)(psSlot->key, (void*)psSlot->value, (void*)pvExtra);
+    }
+}
+
+/*--------------------------------------------------------------------*/
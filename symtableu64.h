@@ -0,0 +1,55 @@
+/*--------------------------------------------------------------------*/
+/* symtableu64.h                                                      */
+/* Author: Tara Shukla                                                */
+/*--------------------------------------------------------------------*/
+#ifndef SYMTABLEU64_INCLUDED
+#define SYMTABLEU64_INCLUDED
+#include <stddef.h>
+#include <stdint.h>
+
+/* symtableu64.c implements a symbol table keyed by 64-bit integers.
+   Keys are stored by value in an open-addressed array, so there is no
+   formatting, no key copy and no per-binding allocation. */
+
+/*struct storing a SymTableU64; defined in symtableu64.c*/
+struct SymTableU64Impl;
+/*SymTableU64_T stores pointer to a SymTableU64 struct*/
+typedef struct SymTableU64Impl *SymTableU64_T;
+
+/*return a new SymTableU64 object that contains no bindings,
+  or NULL if insufficient memory is available.*/
+SymTableU64_T SymTableU64_new(void);
+
+/*free all memory occupied by oSymTable*/
+void SymTableU64_free(SymTableU64_T oSymTable);
+
+/*return size_t the number of bindings in oSymTable*/
+size_t SymTableU64_getLength(SymTableU64_T oSymTable);
+
+/*add a new binding to oSymTable w key uKey, value pvValue and return 1 (TRUE)*/
+/*if already exists leave oSymTable unchanged and return 0 (FALSE)*/
+/*if insufficient mem, return 0*/
+int SymTableU64_put(SymTableU64_T oSymTable,
+    uint64_t uKey, const void *pvValue);
+
+/*if binding w key uKey exists in oSymTable, replace value w pvValue and return old val*/
+/*else leave unchanged, return null*/
+void *SymTableU64_replace(SymTableU64_T oSymTable,
+    uint64_t uKey, const void *pvValue);
+
+/*return 1 (TRUE) if oSymTable contains a binding whose key is uKey, else 0 (FALSE)*/
+int SymTableU64_contains(SymTableU64_T oSymTable, uint64_t uKey);
+
+/*return the value in oSymTable w key uKey, or NULL if no such binding exists*/
+void *SymTableU64_get(SymTableU64_T oSymTable, uint64_t uKey);
+
+/*remove and return value in oSymTable with key uKey; if nonexistent, return null*/
+void *SymTableU64_remove(SymTableU64_T oSymTable, uint64_t uKey);
+
+/*apply pfApply to each binding's uKey and pvValue in oSymTable, passing pvExtra as parameter*/
+void SymTableU64_map(SymTableU64_T oSymTable,
+     void (*pfApply)(uint64_t uKey, void *pvValue, void *pvExtra),
+     const void *pvExtra);
+
+/*--------------------------------------------------------------------*/
+#endif
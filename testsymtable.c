@@ -9,11 +9,16 @@
 #include <time.h>
 #include <string.h>
 #include <assert.h>
+#include <limits.h>
 
 #ifndef S_SPLINT_S
 #include <sys/resource.h>
 #endif
 
+#ifdef SYMTABLE_SNAPSHOT
+#include "symtablehamt.h"
+#endif
+
 /*--------------------------------------------------------------------*/
 
 #define ASSURE(i) assure(i, __LINE__)
@@ -34,6 +39,61 @@ static void assure(int iSuccessful, int iLineNum)
 
 /*--------------------------------------------------------------------*/
 
+#ifdef SYMTABLE_SNAPSHOT
+/* The snapshot build is linked with malloc, calloc, realloc and free
+   wrapped, so that testSnapshot can check that every block is freed. */
+
+/* Number of allocated blocks not yet freed. */
+
+static long lLiveBlocks = 0;
+
+void *__real_malloc(size_t uSize);
+void *__real_calloc(size_t uCount, size_t uSize);
+void *__real_realloc(void *pv, size_t uSize);
+void __real_free(void *pv);
+
+/* Count a block, then forward to the real malloc. */
+
+void *__wrap_malloc(size_t uSize)
+{
+   void *pv = __real_malloc(uSize);
+   if (pv != NULL)
+      lLiveBlocks++;
+   return pv;
+}
+
+/* Count a block, then forward to the real calloc. */
+
+void *__wrap_calloc(size_t uCount, size_t uSize)
+{
+   void *pv = __real_calloc(uCount, uSize);
+   if (pv != NULL)
+      lLiveBlocks++;
+   return pv;
+}
+
+/* Count a block if pv is NULL, then forward to the real realloc. */
+
+void *__wrap_realloc(void *pv, size_t uSize)
+{
+   void *pvNew = __real_realloc(pv, uSize);
+   if (pv == NULL && pvNew != NULL)
+      lLiveBlocks++;
+   return pvNew;
+}
+
+/* Uncount a block, then forward to the real free. */
+
+void __wrap_free(void *pv)
+{
+   if (pv != NULL)
+      lLiveBlocks--;
+   __real_free(pv);
+}
+
+/*--------------------------------------------------------------------*/
+#endif
+
 #ifndef S_SPLINT_S
 /* Set the process's "CPU time" resource limit.  After the CPU
    time limit expires, the OS will send a SIGKILL signal to the
@@ -776,190 +836,1914 @@ static void testCollisions(void)
 
 /*--------------------------------------------------------------------*/
 
-/* Test the ability of a SymTable object to be large, that is, to
-   contain iBindingCount bindings. Write the time consumed to stdout. */
+/* Test the SymTable_clone() function. */
 
-static void testLargeTable(int iBindingCount)
+static void testClone(void)
 {
-   enum {MAX_KEY_LENGTH = 10};
-
    SymTable_T oSymTable;
-   SymTable_T oSymTableSmall;
-   char acKey[MAX_KEY_LENGTH];
+   SymTable_T oClone;
+   SymTable_T oEmptyClone;
+   char acKey[] = "Jeter";
+   char acShortstop[] = "Shortstop";
+   char acCenterField[] = "Center Field";
+   char acFirstBase[] = "First Base";
    char *pcValue;
-   int i;
-   int iSmall;
-   int iLarge;
    int iSuccessful;
-   clock_t iInitialClock;
-   clock_t iFinalClock;
-   size_t uLength = 0;
-   size_t uLength2;
+   size_t uLength;
 
    printf("------------------------------------------------------\n");
-   printf("Testing a potentially large SymTable object.\n");
-   printf("No output except CPU time consumed should appear here:\n");
+   printf("Testing the SymTable_clone() function.\n");
+   printf("No output should appear here:\n");
    fflush(stdout);
 
-   /* Note the current time. */
-   iInitialClock = clock();
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
 
-   /* Create oSymTableSmall, and put a couple of bindings into it. */
-   oSymTableSmall = SymTable_new();
-   ASSURE(oSymTableSmall != NULL);
-   iSuccessful = SymTable_put(oSymTableSmall, "xxx", "xxx");
+   oEmptyClone = SymTable_clone(oSymTable);
+   ASSURE(oEmptyClone != NULL);
+   uLength = SymTable_getLength(oEmptyClone);
+   ASSURE(uLength == 0);
+
+   iSuccessful = SymTable_put(oSymTable, acKey, acShortstop);
    ASSURE(iSuccessful);
-   iSuccessful = SymTable_put(oSymTableSmall, "yyy", "yyy");
+   iSuccessful = SymTable_put(oSymTable, "Mantle", acCenterField);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_put(oSymTable, "Gehrig", NULL);
    ASSURE(iSuccessful);
 
-   /* Create oSymTable, the primary SymTable object. */
-   oSymTable = SymTable_new();
-   ASSURE(oSymTable != NULL);
+   oClone = SymTable_clone(oSymTable);
+   ASSURE(oClone != NULL);
 
-   /* Put iBindingCount new bindings into oSymTable.  Each binding's
-      key and value contain the same characters. */
-   for (i = 0; i < iBindingCount; i++)
-   {
-      sprintf(acKey, "%d", i);
-      pcValue = (char*)malloc(sizeof(char) * (strlen(acKey) + 1));
-      ASSURE(pcValue != NULL);
-      strcpy(pcValue, acKey);
-      iSuccessful = SymTable_put(oSymTable, acKey, pcValue);
-      ASSURE(iSuccessful);
-      uLength = SymTable_getLength(oSymTable);
-      ASSURE(uLength == (size_t)(i+1));
-   }
+   /* The clone owns its own copies of the keys. */
+   strcpy(acKey, "xxxxx");
 
-   /* Get each binding's value, and make sure that it contains
-      the same characters as its key. */
-   iSmall = 0;
-   iLarge = iBindingCount - 1;
-   while (iSmall < iLarge)
-   {
-      /* Get the smallest of the remaining bindings. */
-      sprintf(acKey, "%d", iSmall);
-      pcValue = (char*)SymTable_get(oSymTable, acKey);
-      ASSURE(pcValue != NULL);
-      ASSURE((pcValue != NULL) && (strcmp(pcValue, acKey) == 0));
-      iSmall++;
-      /* Get the largest of the remaining bindings. */
-      sprintf(acKey, "%d", iLarge);
-      pcValue = (char*)SymTable_get(oSymTable, acKey);
-      ASSURE(pcValue != NULL);
-      ASSURE((pcValue != NULL) && (strcmp(pcValue, acKey) == 0));
-      iLarge--;
-   }
-   /* Get the middle binding -- if there is one. */
-   if (iSmall == iLarge)
-   {
-      sprintf(acKey, "%d", iSmall);
-      pcValue = (char*)SymTable_get(oSymTable, acKey);
-      ASSURE(pcValue != NULL);
-      ASSURE((pcValue != NULL) && (strcmp(pcValue, acKey) == 0));
-   }
+   uLength = SymTable_getLength(oClone);
+   ASSURE(uLength == 3);
+   pcValue = (char*)SymTable_get(oClone, "Jeter");
+   ASSURE(pcValue == acShortstop);
+   pcValue = (char*)SymTable_get(oClone, "Mantle");
+   ASSURE(pcValue == acCenterField);
+   ASSURE(SymTable_contains(oClone, "Gehrig"));
 
-   /* Remove each binding. Also free each binding's value. */
-   iSmall = 0;
-   iLarge = iBindingCount - 1;
-   while (iSmall < iLarge)
-   {
-      /* Remove the smallest of the remaining bindings. */
-      sprintf(acKey, "%d", iSmall);
-      pcValue = (char*)SymTable_remove(oSymTable, acKey);
-      ASSURE(pcValue != NULL);
-      ASSURE((pcValue != NULL) && (strcmp(pcValue, acKey) == 0));
-      free(pcValue);
-      uLength--;
-      uLength2 = SymTable_getLength(oSymTable);
-      ASSURE(uLength2 == uLength);
-      iSmall++;
-      /* Remove the largest of the remaining bindings. */
-      sprintf(acKey, "%d", iLarge);
-      pcValue = (char*)SymTable_remove(oSymTable, acKey);
-      ASSURE(pcValue != NULL);
-      ASSURE((pcValue != NULL) && (strcmp(pcValue, acKey) == 0));
-      free(pcValue);
-      uLength--;
-      uLength2 = SymTable_getLength(oSymTable);
-      ASSURE(uLength2 == uLength);
-      iLarge--;
-   }
-   /* Remove the middle binding -- if there is one. */
-   if (iSmall == iLarge)
-   {
-      sprintf(acKey, "%d", iSmall);
-      pcValue = (char*)SymTable_remove(oSymTable, acKey);
-      ASSURE(pcValue != NULL);
-      ASSURE((pcValue != NULL) && (strcmp(pcValue, acKey) == 0));
-      free(pcValue);
-      uLength--;
-      uLength2 = SymTable_getLength(oSymTable);
-      ASSURE(uLength2 == uLength);  
-   }
+   /* Changes to one table do not show up in the other. */
+   pcValue = (char*)SymTable_replace(oSymTable, "Mantle", acFirstBase);
+   ASSURE(pcValue == acCenterField);
+   pcValue = (char*)SymTable_get(oClone, "Mantle");
+   ASSURE(pcValue == acCenterField);
 
-   /* Make sure oSymTableSmall hasn't been corrupted by expansion
-      of oSymTable. */
-   pcValue = (char*)SymTable_get(oSymTableSmall, "xxx");
-   ASSURE((pcValue != NULL) && (strcmp(pcValue, "xxx") == 0));
-   pcValue = (char*)SymTable_get(oSymTableSmall, "yyy");
-   ASSURE((pcValue != NULL) && (strcmp(pcValue, "yyy") == 0));
+   pcValue = (char*)SymTable_remove(oClone, "Jeter");
+   ASSURE(pcValue == acShortstop);
+   ASSURE(! SymTable_contains(oClone, "Jeter"));
+   ASSURE(SymTable_contains(oSymTable, "Jeter"));
 
-   /* Free both SymTable objects. */
-   SymTable_free(oSymTable);
-   SymTable_free(oSymTableSmall);
+   iSuccessful = SymTable_put(oClone, "Ruth", acFirstBase);
+   ASSURE(iSuccessful);
+   ASSURE(! SymTable_contains(oSymTable, "Ruth"));
 
-   /* Note the current time, and print the time consumed to stdout. */
-   iFinalClock = clock();
-   printf("CPU time (%d bindings):  %f seconds\n", iBindingCount,
-      ((double)(iFinalClock - iInitialClock)) / CLOCKS_PER_SEC);
-   fflush(stdout);
+   uLength = SymTable_getLength(oClone);
+   ASSURE(uLength == 3);
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == 3);
+
+   SymTable_free(oSymTable);
+   SymTable_free(oClone);
+   SymTable_free(oEmptyClone);
 }
 
 /*--------------------------------------------------------------------*/
 
-/* Test the SymTable ADT.  Write the output of the tests to stdout.
-   As always, argc is the command-line argument count, argv contains
-   the command-line arguments, and argv[0] is the name of the
-   executable binary file. argv[1] is the number of bindings to put
-   into a potentially large SymTable object.  Exit with EXIT_FAILURE
-   if argv[1] is missing or not numeric.  Otherwise return 0. */
+#ifdef SYMTABLE_SNAPSHOT
+/* Test SymTable_snapshot on a trie deep enough that a change copies
+   only a small part of it. Changes to the table or to its snapshot
+   must not show through to the other, the subtrees they still share
+   must stay intact, and freeing the two in either order must free
+   every block. */
 
-int main(int argc, char *argv[])
+static void testSnapshot(void)
 {
-   int iBindingCount;
+   enum {KEY_COUNT = 2000};
+   SymTable_T oSymTable;
+   SymTable_T oSnapshot;
+   SymTable_T oEmptySnapshot;
+   SymTable_T oSurvivor;
+   int aiValues[KEY_COUNT];
+   int iOther;
+   char acKey[16];
+   long lLive;
+   int iRound;
+   int i;
 
-   if (argc != 2)
-   {
-      fprintf(stderr, "Usage: %s bindingcount\n", argv[0]);
-      exit(EXIT_FAILURE);
-   }
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_snapshot() function.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
 
-   if (sscanf(argv[1], "%d", &iBindingCount) != 1)
+   for (iRound = 0; iRound < 2; iRound++)
    {
-      fprintf(stderr, "bindingcount must be numeric\n");
-      exit(EXIT_FAILURE);
+      lLive = lLiveBlocks;
+      oSymTable = SymTable_new();
+      ASSURE(oSymTable != NULL);
+      oEmptySnapshot = SymTable_snapshot(oSymTable);
+      ASSURE(oEmptySnapshot != NULL);
+
+      for (i = 0; i < KEY_COUNT; i++)
+      {
+         sprintf(acKey, "%d", i);
+         ASSURE(SymTable_put(oSymTable, acKey, &aiValues[i]));
+      }
+      ASSURE(SymTable_getLength(oEmptySnapshot) == 0);
+
+      oSnapshot = SymTable_snapshot(oSymTable);
+      ASSURE(oSnapshot != NULL);
+      ASSURE(SymTable_getLength(oSnapshot) == KEY_COUNT);
+
+      /* Changes to the table do not show up in the snapshot. */
+      ASSURE(SymTable_replace(oSymTable, "0", &iOther) == &aiValues[0]);
+      ASSURE(SymTable_remove(oSymTable, "1") == &aiValues[1]);
+      ASSURE(SymTable_put(oSymTable, "Ruth", &iOther));
+      ASSURE(SymTable_get(oSnapshot, "0") == &aiValues[0]);
+      ASSURE(SymTable_get(oSnapshot, "1") == &aiValues[1]);
+      ASSURE(! SymTable_contains(oSnapshot, "Ruth"));
+
+      /* Changes to the snapshot do not show up in the table. */
+      ASSURE(SymTable_replace(oSnapshot, "2", &iOther) == &aiValues[2]);
+      ASSURE(SymTable_remove(oSnapshot, "3") == &aiValues[3]);
+      ASSURE(SymTable_put(oSnapshot, "Gehrig", &iOther));
+      ASSURE(SymTable_get(oSymTable, "2") == &aiValues[2]);
+      ASSURE(SymTable_get(oSymTable, "3") == &aiValues[3]);
+      ASSURE(! SymTable_contains(oSymTable, "Gehrig"));
+      ASSURE(SymTable_get(oSymTable, "0") == &iOther);
+      ASSURE(! SymTable_contains(oSymTable, "1"));
+
+      ASSURE(SymTable_getLength(oSymTable) == KEY_COUNT);
+      ASSURE(SymTable_getLength(oSnapshot) == KEY_COUNT);
+      ASSURE(SymTable_getLength(oEmptySnapshot) == 0);
+
+      /* The untouched bindings, reached through shared subtrees, are
+         intact in both. */
+      for (i = 4; i < KEY_COUNT; i++)
+      {
+         sprintf(acKey, "%d", i);
+         ASSURE(SymTable_get(oSymTable, acKey) == &aiValues[i]);
+         ASSURE(SymTable_get(oSnapshot, acKey) == &aiValues[i]);
+      }
+
+      /* Free the table first in one round and the snapshot first in
+         the other; the survivor keeps every binding. */
+      if (iRound == 0)
+      {
+         SymTable_free(oSymTable);
+         oSurvivor = oSnapshot;
+      }
+      else
+      {
+         SymTable_free(oSnapshot);
+         oSurvivor = oSymTable;
+      }
+      for (i = 4; i < KEY_COUNT; i++)
+      {
+         sprintf(acKey, "%d", i);
+         ASSURE(SymTable_get(oSurvivor, acKey) == &aiValues[i]);
+      }
+      ASSURE(SymTable_remove(oSurvivor, "4") == &aiValues[4]);
+      SymTable_free(oSurvivor);
+      SymTable_free(oEmptySnapshot);
+      ASSURE(lLiveBlocks == lLive);
    }
-   if (iBindingCount < 0)
+}
+#endif
+
+/*--------------------------------------------------------------------*/
+
+#ifndef SYMTABLE_CORE_ONLY
+/* Count one eviction in the int that pvExtra points to. pcKey and
+   pvValue are unused. */
+
+static void countEviction(const char *pcKey, void *pvValue,
+   void *pvExtra)
+{
+   assert(pcKey != NULL);
+   assert(pvExtra != NULL);
+   (void)pvValue;
+
+   (*(int*)pvExtra)++;
+}
+
+/* Test a SymTable object created by SymTable_newBounded(). */
+
+static void testBounded(void)
+{
+   SymTable_T oSymTable;
+   char acShortstop[] = "Shortstop";
+   char acCenterField[] = "Center Field";
+   char acFirstBase[] = "First Base";
+   char acKey[16];
+   char *pcValue;
+   int iSuccessful;
+   int iEvictions = 0;
+   int i;
+   size_t uLength;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a SymTable object with bounded capacity.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_newBounded(2, countEviction, &iEvictions);
+   ASSURE(oSymTable != NULL);
+
+   iSuccessful = SymTable_put(oSymTable, "Jeter", acShortstop);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_put(oSymTable, "Mantle", acCenterField);
+   ASSURE(iSuccessful);
+   ASSURE(iEvictions == 0);
+
+   /* A duplicate put evicts nothing. */
+   iSuccessful = SymTable_put(oSymTable, "Mantle", acFirstBase);
+   ASSURE(! iSuccessful);
+   ASSURE(iEvictions == 0);
+
+   /* Use Jeter, so that Mantle is the one evicted. */
+   pcValue = (char*)SymTable_get(oSymTable, "Jeter");
+   ASSURE(pcValue == acShortstop);
+
+   iSuccessful = SymTable_put(oSymTable, "Gehrig", acFirstBase);
+   ASSURE(iSuccessful);
+   ASSURE(iEvictions == 1);
+   uLength = SymTable_getLength(oSymTable);
+   ASSURE(uLength == 2);
+   ASSURE(SymTable_contains(oSymTable, "Jeter"));
+   ASSURE(SymTable_contains(oSymTable, "Gehrig"));
+   ASSURE(! SymTable_contains(oSymTable, "Mantle"));
+
+   SymTable_free(oSymTable);
+
+   /* Many puts never grow the table past its bound. */
+   iEvictions = 0;
+   oSymTable = SymTable_newBounded(100, countEviction, &iEvictions);
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < 1000; i++)
    {
-      fprintf(stderr, "bindingcount cannot be negative\n");
-      exit(EXIT_FAILURE);
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, acShortstop);
+      ASSURE(iSuccessful);
+      ASSURE(SymTable_getLength(oSymTable) <= 100);
    }
-   
-#ifndef S_SPLINT_S
-   setCpuTimeLimit();
-#endif
+   ASSURE(iEvictions == 900);
+   ASSURE(SymTable_contains(oSymTable, "999"));
 
-   testBasics();
-   testKeyComparison();
-   testKeyOwnership();
-   testRemove();
-   testMap();
-   testEmptyTable();
-   testEmptyKey();
-   testNullValue();
-   testLongKey();
-   testTableOfTables();
-   testCollisions();
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test a SymTable object created by SymTable_newExpiring(). */
+
+static void testExpiry(void)
+{
+   SymTable_T oSymTable;
+   SymTable_T oClone;
+   char acShortstop[] = "Shortstop";
+   char acCenterField[] = "Center Field";
+   char acFirstBase[] = "First Base";
+   char acKey[16];
+   char *pcValue;
+   int iSuccessful;
+   int iExpirations = 0;
+   int iDue;
+   int i;
+   size_t uReclaimed;
+   unsigned long ulNow;
+   static const unsigned long aulLifetimes[] = {1, 2, 63, 64, 65, 127,
+      128, 255, 256, 257, 4095, 4096, 4097, 99999, 262143, 262144,
+      262145, 5000000, 16777215, 16777216, 16777217, ULONG_MAX};
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a SymTable object with expiring bindings.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_newExpiring(countEviction, &iExpirations);
+   ASSURE(oSymTable != NULL);
+
+   iSuccessful = SymTable_putWithTTL(oSymTable, "Jeter", acShortstop, 10);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_putWithTTL(oSymTable, "Mantle", acCenterField, 1000);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_put(oSymTable, "Gehrig", acFirstBase);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_putWithTTL(oSymTable, "Jeter", acFirstBase, 10);
+   ASSURE(! iSuccessful);
+
+   /* Nothing is due yet. */
+   uReclaimed = SymTable_expire(oSymTable, 9, 100);
+   ASSURE(uReclaimed == 0);
+   ASSURE(SymTable_getLength(oSymTable) == 3);
+
+   /* Replacing a value keeps the binding's expiry. */
+   pcValue = (char*)SymTable_replace(oSymTable, "Jeter", acFirstBase);
+   ASSURE(pcValue == acShortstop);
+
+   uReclaimed = SymTable_expire(oSymTable, 10, 100);
+   ASSURE(uReclaimed == 1);
+   ASSURE(iExpirations == 1);
+   ASSURE(SymTable_getLength(oSymTable) == 2);
+   ASSURE(! SymTable_contains(oSymTable, "Jeter"));
+   ASSURE(SymTable_get(oSymTable, "Mantle") == acCenterField);
+
+   /* An expired binding is absent even before it is reclaimed. */
+   uReclaimed = SymTable_expire(oSymTable, 5000, 0);
+   ASSURE(uReclaimed == 0);
+   ASSURE(SymTable_get(oSymTable, "Mantle") == NULL);
+   ASSURE(iExpirations == 2);
+   ASSURE(SymTable_getLength(oSymTable) == 1);
+
+   /* Bindings added with SymTable_put never expire. */
+   ASSURE(SymTable_get(oSymTable, "Gehrig") == acFirstBase);
+
+   /* The key of an expired binding can be put again. */
+   iSuccessful = SymTable_putWithTTL(oSymTable, "Mantle", acShortstop, 5);
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_get(oSymTable, "Mantle") == acShortstop);
+   iSuccessful = (int)SymTable_expire(oSymTable, 5005, 100);
+   ASSURE(iSuccessful == 1);
+   ASSURE(iExpirations == 3);
+
+   SymTable_free(oSymTable);
+
+   /* Many bindings with spread-out lifetimes, reclaimed a few at a
+      time, across a clone. */
+   iExpirations = 0;
+   oSymTable = SymTable_newExpiring(countEviction, &iExpirations);
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < 1000; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_putWithTTL(oSymTable, acKey, acShortstop,
+         (unsigned long)(i + 1));
+      ASSURE(iSuccessful);
+   }
+   oClone = SymTable_clone(oSymTable);
+   ASSURE(oClone != NULL);
+
+   uReclaimed = SymTable_expire(oSymTable, 500, 100);
+   ASSURE(uReclaimed == 100);
+   while (SymTable_expire(oSymTable, 500, 100) > 0)
+      ;
+   ASSURE(iExpirations == 500);
+   ASSURE(SymTable_getLength(oSymTable) == 500);
+   ASSURE(! SymTable_contains(oSymTable, "499"));
+   ASSURE(SymTable_contains(oSymTable, "500"));
+
+   SymTable_remove(oSymTable, "999");
+   uReclaimed = SymTable_expire(oSymTable, 2000, 1000);
+   ASSURE(uReclaimed == 499);
+   ASSURE(SymTable_getLength(oSymTable) == 0);
+   SymTable_free(oSymTable);
+
+   /* The clone's bindings expire on their own schedule. */
+   ASSURE(SymTable_getLength(oClone) == 1000);
+   uReclaimed = SymTable_expire(oClone, 1000, 1000);
+   ASSURE(uReclaimed == 1000);
+   ASSURE(iExpirations == 1999);
+   SymTable_free(oClone);
+
+   /* A lifetime too long to add to the current time does not wrap
+      round to an early expiry. */
+   oSymTable = SymTable_newExpiring(NULL, NULL);
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_expire(oSymTable, 100, 10) == 0);
+   iSuccessful = SymTable_putWithTTL(oSymTable, "Jeter", acShortstop,
+      ULONG_MAX);
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_expire(oSymTable, 1000, 10) == 0);
+   ASSURE(SymTable_get(oSymTable, "Jeter") == acShortstop);
+   ASSURE(SymTable_expire(oSymTable, ULONG_MAX - 1, 10) == 0);
+   ASSURE(SymTable_contains(oSymTable, "Jeter"));
+   SymTable_free(oSymTable);
+
+   /* Lifetimes far beyond a lap of the timer wheel end on time, however
+      the clock is stepped. */
+   iExpirations = 0;
+   oSymTable = SymTable_newExpiring(countEviction, &iExpirations);
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < (int)(sizeof(aulLifetimes) / sizeof(aulLifetimes[0])); i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_putWithTTL(oSymTable, acKey, acShortstop,
+         aulLifetimes[i]);
+      ASSURE(iSuccessful);
+   }
+   for (ulNow = 0; ulNow < 40000000; ulNow += ulNow / 3 + 1)
+   {
+      SymTable_expire(oSymTable, ulNow, 100);
+      iDue = 0;
+      for (i = 0; i < (int)(sizeof(aulLifetimes) / sizeof(aulLifetimes[0])); i++)
+         if (aulLifetimes[i] <= ulNow)
+            iDue++;
+      ASSURE(iExpirations == iDue);
+   }
+   ASSURE(SymTable_getLength(oSymTable) == 1);
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the SymTable_upsert(), SymTable_getOrPut(), and SymTable_slot()
+   functions, and SymTable_remove() of bindings at each position. */
+
+static void testUpsert(void)
+{
+   SymTable_T oSymTable;
+   char acShortstop[] = "Shortstop";
+   char acCenterField[] = "Center Field";
+   char acFirstBase[] = "First Base";
+   char acKey[16];
+   char *pcValue;
+   void *pvOldValue;
+   void **ppvSlot;
+   int iSuccessful;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_upsert(), SymTable_getOrPut(), and\n");
+   printf("SymTable_slot() functions.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   pvOldValue = acFirstBase;
+   iSuccessful = SymTable_upsert(oSymTable, "Jeter", acShortstop, &pvOldValue);
+   ASSURE(iSuccessful);
+   ASSURE(pvOldValue == NULL);
+   ASSURE(SymTable_getLength(oSymTable) == 1);
+
+   iSuccessful = SymTable_upsert(oSymTable, "Jeter", acCenterField, &pvOldValue);
+   ASSURE(iSuccessful);
+   ASSURE(pvOldValue == acShortstop);
+   ASSURE(SymTable_get(oSymTable, "Jeter") == acCenterField);
+   ASSURE(SymTable_getLength(oSymTable) == 1);
+
+   iSuccessful = SymTable_upsert(oSymTable, "Jeter", acShortstop, NULL);
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_get(oSymTable, "Jeter") == acShortstop);
+
+   pcValue = (char*)SymTable_getOrPut(oSymTable, "Jeter", acFirstBase);
+   ASSURE(pcValue == acShortstop);
+   pcValue = (char*)SymTable_getOrPut(oSymTable, "Gehrig", acFirstBase);
+   ASSURE(pcValue == acFirstBase);
+   ASSURE(SymTable_get(oSymTable, "Gehrig") == acFirstBase);
+   ASSURE(SymTable_getLength(oSymTable) == 2);
+
+   ppvSlot = SymTable_slot(oSymTable, "Mantle");
+   ASSURE(ppvSlot != NULL);
+   ASSURE(*ppvSlot == NULL);
+   ASSURE(SymTable_getLength(oSymTable) == 3);
+   *ppvSlot = acCenterField;
+   ASSURE(SymTable_get(oSymTable, "Mantle") == acCenterField);
+   ppvSlot = SymTable_slot(oSymTable, "Gehrig");
+   ASSURE(ppvSlot != NULL);
+   ASSURE(*ppvSlot == acFirstBase);
+   ASSURE(SymTable_getLength(oSymTable) == 3);
+
+   SymTable_free(oSymTable);
+
+   /* Remove bindings from the front, middle, and end of chains. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < 100; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_slot(oSymTable, acKey) != NULL);
+   }
+   for (i = 0; i < 100; i += 3)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_contains(oSymTable, acKey));
+      SymTable_remove(oSymTable, acKey);
+      ASSURE(! SymTable_contains(oSymTable, acKey));
+   }
+   for (i = 0; i < 100; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_contains(oSymTable, acKey) == (i % 3 != 0));
+   }
+   ASSURE(SymTable_getLength(oSymTable) == 66);
+
+   SymTable_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* If pcKey is the key pvExtra points to, record that by setting the
+   pointer to NULL. */
+
+static void findBorrowedKey(const char *pcKey, void *pvValue,
+   void *pvExtra)
+{
+   (void)pvValue;
+   if (pcKey == *(const char**)pvExtra)
+      *(const char**)pvExtra = NULL;
+}
+
+/* Test the SymTable_putBorrowed() function. */
+
+static void testBorrowed(void)
+{
+   SymTable_T oSymTable;
+   SymTable_T oClone;
+   char acJeter[] = "Jeter";
+   char acMantle[] = "Mantle";
+   char acShortstop[] = "Shortstop";
+   char acCenterField[] = "Center Field";
+   const char *pcKey;
+   int iSuccessful;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_putBorrowed() function.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   iSuccessful = SymTable_putBorrowed(oSymTable, acJeter, acShortstop);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_put(oSymTable, acMantle, acCenterField);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_putBorrowed(oSymTable, "Jeter", acCenterField);
+   ASSURE(! iSuccessful);
+   ASSURE(SymTable_get(oSymTable, "Jeter") == acShortstop);
+
+   /* The table holds the caller's pointer, not a copy. */
+   pcKey = acJeter;
+   SymTable_map(oSymTable, findBorrowedKey, &pcKey);
+   ASSURE(pcKey == NULL);
+   pcKey = acMantle;
+   SymTable_map(oSymTable, findBorrowedKey, &pcKey);
+   ASSURE(pcKey == acMantle);
+
+   /* A clone copies borrowed keys like any others. */
+   oClone = SymTable_clone(oSymTable);
+   ASSURE(oClone != NULL);
+   pcKey = acJeter;
+   SymTable_map(oClone, findBorrowedKey, &pcKey);
+   ASSURE(pcKey == acJeter);
+
+   /* Removing or freeing leaves a borrowed key alone. */
+   ASSURE(SymTable_remove(oSymTable, "Jeter") == acShortstop);
+   ASSURE(strcmp(acJeter, "Jeter") == 0);
+   iSuccessful = SymTable_putBorrowed(oSymTable, acJeter, acShortstop);
+   ASSURE(iSuccessful);
+   SymTable_free(oSymTable);
+   ASSURE(strcmp(acJeter, "Jeter") == 0);
+
+   ASSURE(SymTable_get(oClone, "Jeter") == acShortstop);
+   SymTable_free(oClone);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Count a release of the resource: increment the int pvResource
+   points to. */
+
+static void countRelease(void *pvResource)
+{
+   (*(int*)pvResource)++;
+}
+
+/* Test the SymTable_newSized(), SymTable_putBorrowedBatch(), and
+   SymTable_adopt() functions. */
+
+static void testSized(void)
+{
+   enum {BINDING_COUNT = 3000};
+
+   SymTable_T oSymTable;
+   static char aacKeys[BINDING_COUNT][8];
+   const char *apcKeys[BINDING_COUNT];
+   const void *apvValues[BINDING_COUNT];
+   int iReleases = 0;
+   int iSuccessful;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_newSized(), SymTable_putBorrowedBatch(),\n");
+   printf("and SymTable_adopt() functions.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      /* Every third key repeats the one before it. */
+      sprintf(aacKeys[i], "%d", i % 3 == 2 ? i - 1 : i);
+      apcKeys[i] = aacKeys[i];
+      apvValues[i] = aacKeys[i];
+   }
+
+   oSymTable = SymTable_newSized(BINDING_COUNT);
+   ASSURE(oSymTable != NULL);
+   iSuccessful = SymTable_adopt(oSymTable, &iReleases, countRelease);
+   ASSURE(iSuccessful);
+
+   iSuccessful = SymTable_putBorrowedBatch(oSymTable, apcKeys, apvValues,
+      BINDING_COUNT);
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_getLength(oSymTable) == BINDING_COUNT / 3 * 2);
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      if (i % 3 == 2) continue;
+      ASSURE(SymTable_get(oSymTable, aacKeys[i]) == aacKeys[i]);
+   }
+
+   /* Removed bindings and bindings past the expected count work as
+      in any other table. */
+   ASSURE(SymTable_remove(oSymTable, "0") == aacKeys[0]);
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      char acKey[16];
+      sprintf(acKey, "x%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, NULL);
+      ASSURE(iSuccessful);
+   }
+   ASSURE(SymTable_getLength(oSymTable) == BINDING_COUNT / 3 * 5 - 1);
+   ASSURE(iReleases == 0);
+
+   SymTable_free(oSymTable);
+   ASSURE(iReleases == 1);
+}
+
+/* Test the SymTable_addFilter() function. */
+
+static void testFilter(void)
+{
+   enum {BINDING_COUNT = 3000};
+
+   SymTable_T oSymTable;
+   SymTable_T oClone;
+   char acKey[16];
+   int iSuccessful;
+   int i;
+#ifdef SYMTABLE_STATS
+   struct SymTableStats sStats;
+#endif
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_addFilter() function.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   /* A filter added to a table with bindings covers them. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   iSuccessful = SymTable_put(oSymTable, "Ruth", "RightField");
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_addFilter(oSymTable);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_addFilter(oSymTable);
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_contains(oSymTable, "Ruth"));
+   ASSURE(! SymTable_contains(oSymTable, "Gehrig"));
+
+   /* Lookups stay exact as the table grows past several expansions. */
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, NULL);
+      ASSURE(iSuccessful);
+   }
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_contains(oSymTable, acKey));
+      sprintf(acKey, "x%d", i);
+      ASSURE(! SymTable_contains(oSymTable, acKey));
+   }
+
+   /* Removed keys read as absent, and churn that rebuilds the filter
+      loses nothing. */
+   for (i = 0; i < BINDING_COUNT; i += 2)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_remove(oSymTable, acKey) == NULL);
+   }
+   for (i = 0; i < BINDING_COUNT * 2; i++)
+   {
+      sprintf(acKey, "y%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, NULL);
+      ASSURE(iSuccessful);
+      ASSURE(SymTable_remove(oSymTable, acKey) == NULL);
+   }
+   ASSURE(SymTable_getLength(oSymTable) == BINDING_COUNT / 2 + 1);
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_contains(oSymTable, acKey) == (i % 2 == 1));
+   }
+
+   /* A clone has the same filter. */
+   oClone = SymTable_clone(oSymTable);
+   ASSURE(oClone != NULL);
+   ASSURE(SymTable_contains(oClone, "Ruth"));
+   ASSURE(SymTable_contains(oClone, "1"));
+   ASSURE(! SymTable_contains(oClone, "0"));
+   SymTable_free(oClone);
+
+#ifdef SYMTABLE_STATS
+   SymTable_getStats(oSymTable, &sStats);
+   ASSURE(sStats.uBucketCount == 1
+      || (sStats.uFilterBytes > 0
+         && sStats.dFilterFalsePositiveRate < 0.1));
+#endif
+
+   SymTable_free(oSymTable);
+}
+
+/* Test the SymTable_setMoveToFront() function. */
+
+static void testMoveToFront(void)
+{
+   enum {BINDING_COUNT = 100};
+
+   SymTable_T oSymTable;
+   SymTable_T oClone;
+   static char aacKeys[BINDING_COUNT][8];
+   int iSuccessful;
+   int iRound;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_setMoveToFront() function.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   SymTable_setMoveToFront(oSymTable, 1);
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(aacKeys[i], "%d", i);
+      iSuccessful = SymTable_put(oSymTable, aacKeys[i], aacKeys[i]);
+      ASSURE(iSuccessful);
+   }
+
+   /* Lookups that reorder the table still find every binding. */
+   for (iRound = 0; iRound < 3; iRound++)
+      for (i = BINDING_COUNT - 1; i >= 0; i -= iRound + 1)
+         ASSURE(SymTable_get(oSymTable, aacKeys[i]) == aacKeys[i]);
+   ASSURE(SymTable_get(oSymTable, "x") == NULL);
+   ASSURE(SymTable_replace(oSymTable, "7", NULL) == aacKeys[7]);
+   ASSURE(SymTable_remove(oSymTable, "7") == NULL);
+   ASSURE(SymTable_remove(oSymTable, aacKeys[BINDING_COUNT - 1])
+      == aacKeys[BINDING_COUNT - 1]);
+   ASSURE(SymTable_getLength(oSymTable) == BINDING_COUNT - 2);
+
+   oClone = SymTable_clone(oSymTable);
+   ASSURE(oClone != NULL);
+   for (i = 0; i < BINDING_COUNT - 1; i++)
+      ASSURE(SymTable_contains(oClone, aacKeys[i]) == (i != 7));
+   SymTable_free(oClone);
+
+   SymTable_setMoveToFront(oSymTable, 0);
+   for (i = 0; i < BINDING_COUNT - 1; i++)
+      ASSURE(SymTable_contains(oSymTable, aacKeys[i]) == (i != 7));
+   SymTable_free(oSymTable);
+
+   /* A bounded table keeps its limit. */
+   oSymTable = SymTable_newBounded(10, NULL, NULL);
+   ASSURE(oSymTable != NULL);
+   SymTable_setMoveToFront(oSymTable, 1);
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      iSuccessful = SymTable_put(oSymTable, aacKeys[i], NULL);
+      ASSURE(iSuccessful);
+      ASSURE(SymTable_contains(oSymTable, aacKeys[i / 2]) || i >= 10);
+   }
+   ASSURE(SymTable_getLength(oSymTable) == 10);
+   ASSURE(SymTable_contains(oSymTable, aacKeys[BINDING_COUNT - 1]));
+   SymTable_free(oSymTable);
+}
+
+/* Test the SymTable_clear() function. */
+
+static void testClear(void)
+{
+   enum {BINDING_COUNT = 1000};
+
+   SymTable_T oSymTable;
+   SymTableInterns_T oInterns;
+   char acKey[32];
+   int iSuccessful;
+   int iRound;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_clear() function.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   /* Refills reuse nodes and key buffers, whether keys grow or shrink. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   SymTable_clear(oSymTable);
+   ASSURE(SymTable_getLength(oSymTable) == 0);
+   for (iRound = 0; iRound < 4; iRound++)
+   {
+      for (i = 0; i < BINDING_COUNT / (iRound + 1); i++)
+      {
+         sprintf(acKey, iRound % 2 == 0 ? "%d" : "key number %d", i);
+         iSuccessful = SymTable_put(oSymTable, acKey, &acKey[i % 8]);
+         ASSURE(iSuccessful);
+      }
+      iSuccessful = SymTable_putBorrowed(oSymTable, "Ruth", NULL);
+      ASSURE(iSuccessful);
+      ASSURE(SymTable_getLength(oSymTable)
+         == (size_t)(BINDING_COUNT / (iRound + 1) + 1));
+      sprintf(acKey, iRound % 2 == 0 ? "%d" : "key number %d", 7);
+      ASSURE(SymTable_get(oSymTable, acKey) == &acKey[7]);
+      ASSURE(! SymTable_contains(oSymTable, iRound % 2 == 0
+         ? "key number 7" : "7"));
+      SymTable_clear(oSymTable);
+      ASSURE(SymTable_getLength(oSymTable) == 0);
+      ASSURE(! SymTable_contains(oSymTable, acKey));
+      ASSURE(! SymTable_contains(oSymTable, "Ruth"));
+   }
+   SymTable_free(oSymTable);
+
+   /* Bounded, expiring and filtered tables work as new after clearing. */
+   oSymTable = SymTable_newBounded(2, NULL, NULL);
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_put(oSymTable, "Ruth", NULL));
+   ASSURE(SymTable_put(oSymTable, "Gehrig", NULL));
+   SymTable_clear(oSymTable);
+   ASSURE(SymTable_put(oSymTable, "Mantle", NULL));
+   ASSURE(SymTable_put(oSymTable, "Jeter", NULL));
+   ASSURE(SymTable_put(oSymTable, "Ruth", NULL));
+   ASSURE(SymTable_getLength(oSymTable) == 2);
+   SymTable_free(oSymTable);
+
+   oSymTable = SymTable_newExpiring(NULL, NULL);
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_putWithTTL(oSymTable, "Ruth", NULL, 5));
+   ASSURE(SymTable_putWithTTL(oSymTable, "Mantle", NULL, 20));
+   SymTable_clear(oSymTable);
+   ASSURE(SymTable_putWithTTL(oSymTable, "Gehrig", NULL, 5));
+   ASSURE(SymTable_expire(oSymTable, 10, 10) == 1);
+   ASSURE(SymTable_getLength(oSymTable) == 0);
+   /* Timers kept for reuse are freed with the table. */
+   ASSURE(SymTable_putWithTTL(oSymTable, "Jeter", NULL, 5));
+   SymTable_clear(oSymTable);
+   SymTable_free(oSymTable);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_addFilter(oSymTable));
+   ASSURE(SymTable_put(oSymTable, "Ruth", NULL));
+   SymTable_clear(oSymTable);
+   ASSURE(! SymTable_contains(oSymTable, "Ruth"));
+   ASSURE(SymTable_put(oSymTable, "Gehrig", NULL));
+   ASSURE(SymTable_contains(oSymTable, "Gehrig"));
+   SymTable_free(oSymTable);
+
+   /* Clearing an interned table releases its keys. */
+   oInterns = SymTableInterns_new();
+   ASSURE(oInterns != NULL);
+   oSymTable = SymTable_newInterned(oInterns);
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_put(oSymTable, "Ruth", NULL));
+   SymTable_clear(oSymTable);
+   ASSURE(SymTableInterns_getLength(oInterns) == 0);
+   ASSURE(SymTable_put(oSymTable, "Gehrig", NULL));
+   ASSURE(SymTable_contains(oSymTable, "Gehrig"));
+   SymTable_free(oSymTable);
+   ASSURE(SymTableInterns_getLength(oInterns) == 0);
+   SymTableInterns_free(oInterns);
+}
+
+/* Return 1 if the int that pvValue points to is odd, else 0. pcKey
+   and pvExtra are unused. */
+
+static int isOdd(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   assert(pcKey != NULL);
+   assert(pvValue != NULL);
+
+   (void)pvExtra;
+   return *(int*)pvValue % 2 != 0;
+}
+
+/* Add the int that pvValue points to to the int that pvExtra points
+   to. pcKey is unused. */
+
+static void addValue(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   assert(pcKey != NULL);
+   assert(pvValue != NULL);
+   assert(pvExtra != NULL);
+
+   *(int*)pvExtra += *(int*)pvValue;
+}
+
+/* Test the SymTable_removeIf() function. */
+
+static void testRemoveIf(void)
+{
+   enum {BINDING_COUNT = 1000};
+
+   SymTable_T oSymTable;
+   static int aiValues[BINDING_COUNT];
+   char acKey[16];
+   int iSuccessful;
+   int iSum = 0;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_removeIf() function.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_removeIf(oSymTable, isOdd, NULL, NULL) == 0);
+   ASSURE(SymTable_addFilter(oSymTable));
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      aiValues[i] = i;
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSymTable, acKey, &aiValues[i]);
+      ASSURE(iSuccessful);
+   }
+
+   /* Every odd value goes, and is handed over once. */
+   ASSURE(SymTable_removeIf(oSymTable, isOdd, addValue, &iSum)
+      == BINDING_COUNT / 2);
+   ASSURE(iSum == (BINDING_COUNT / 2) * (BINDING_COUNT / 2));
+   ASSURE(SymTable_getLength(oSymTable) == BINDING_COUNT / 2);
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_contains(oSymTable, acKey) == (i % 2 == 0));
+   }
+   ASSURE(SymTable_removeIf(oSymTable, isOdd, NULL, NULL) == 0);
+
+   /* Survivors can be removed and put again as usual. */
+   ASSURE(SymTable_remove(oSymTable, "0") == &aiValues[0]);
+   iSuccessful = SymTable_put(oSymTable, "1", &aiValues[1]);
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_getLength(oSymTable) == BINDING_COUNT / 2);
+   SymTable_free(oSymTable);
+
+   /* Expired bindings are not offered to the test. */
+   oSymTable = SymTable_newExpiring(NULL, NULL);
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_putWithTTL(oSymTable, "1", &aiValues[1], 5));
+   ASSURE(SymTable_put(oSymTable, "3", &aiValues[3]));
+   ASSURE(SymTable_put(oSymTable, "4", &aiValues[4]));
+   ASSURE(SymTable_expire(oSymTable, 5, 0) == 0);
+   ASSURE(SymTable_removeIf(oSymTable, isOdd, NULL, NULL) == 1);
+   ASSURE(SymTable_getLength(oSymTable) == 1);
+   ASSURE(SymTable_contains(oSymTable, "4"));
+   SymTable_free(oSymTable);
+}
+
+/* Test the SymTable_addReverseIndex() and SymTable_findKeyByValue()
+   functions. */
+
+static void testReverseIndex(void)
+{
+   enum {BINDING_COUNT = 1000, SHARED_COUNT = 40000};
+
+   SymTable_T oSymTable;
+   SymTable_T oClone;
+   static int aiValues[BINDING_COUNT];
+   static char aacKeys[BINDING_COUNT][8];
+   char acKey[16];
+   int iSuccessful;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_findKeyByValue() function.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   /* The index covers bindings put before and after it was added,
+      through every expansion. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_findKeyByValue(oSymTable, &aiValues[0]) == NULL);
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(aacKeys[i], "%d", i);
+      if (i == BINDING_COUNT / 10)
+         ASSURE(SymTable_addReverseIndex(oSymTable));
+      iSuccessful = SymTable_put(oSymTable, aacKeys[i], &aiValues[i]);
+      ASSURE(iSuccessful);
+   }
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      ASSURE(SymTable_findKeyByValue(oSymTable, &aiValues[i]) != NULL);
+      ASSURE(strcmp(SymTable_findKeyByValue(oSymTable, &aiValues[i]),
+         aacKeys[i]) == 0);
+   }
+
+   /* Replacing and removing keep it up to date. */
+   ASSURE(SymTable_replace(oSymTable, "0", &aiValues[1]) == &aiValues[0]);
+   ASSURE(SymTable_findKeyByValue(oSymTable, &aiValues[0]) == NULL);
+   ASSURE(SymTable_remove(oSymTable, "1") == &aiValues[1]);
+   ASSURE(strcmp(SymTable_findKeyByValue(oSymTable, &aiValues[1]), "0")
+      == 0);
+   iSuccessful = SymTable_upsert(oSymTable, "0", &aiValues[0], NULL);
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_findKeyByValue(oSymTable, &aiValues[1]) == NULL);
+   for (i = 0; i < BINDING_COUNT; i += 2)
+      ASSURE(SymTable_remove(oSymTable, aacKeys[i]) == &aiValues[i]);
+   for (i = 0; i < BINDING_COUNT; i++)
+      ASSURE((SymTable_findKeyByValue(oSymTable, &aiValues[i]) != NULL)
+         == (i % 2 == 1 && i != 1));
+
+   oClone = SymTable_clone(oSymTable);
+   ASSURE(oClone != NULL);
+   ASSURE(strcmp(SymTable_findKeyByValue(oClone, &aiValues[3]), "3")
+      == 0);
+   SymTable_free(oClone);
+
+   /* A slot drops the index; lookups by value still work. */
+   ASSURE(SymTable_slot(oSymTable, "x") != NULL);
+   *SymTable_slot(oSymTable, "x") = &aiValues[0];
+   ASSURE(strcmp(SymTable_findKeyByValue(oSymTable, &aiValues[0]), "x")
+      == 0);
+   ASSURE(strcmp(SymTable_findKeyByValue(oSymTable, &aiValues[5]), "5")
+      == 0);
+   SymTable_clear(oSymTable);
+   ASSURE(SymTable_findKeyByValue(oSymTable, &aiValues[5]) == NULL);
+   SymTable_free(oSymTable);
+
+   /* Evicted and expired bindings leave the index. */
+   oSymTable = SymTable_newBounded(2, NULL, NULL);
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_addReverseIndex(oSymTable));
+   ASSURE(SymTable_put(oSymTable, "0", &aiValues[0]));
+   ASSURE(SymTable_put(oSymTable, "1", &aiValues[1]));
+   ASSURE(SymTable_put(oSymTable, "2", &aiValues[2]));
+   ASSURE(SymTable_findKeyByValue(oSymTable, &aiValues[0]) == NULL);
+   ASSURE(SymTable_findKeyByValue(oSymTable, &aiValues[2]) != NULL);
+   SymTable_free(oSymTable);
+
+   oSymTable = SymTable_newExpiring(NULL, NULL);
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_addReverseIndex(oSymTable));
+   ASSURE(SymTable_putWithTTL(oSymTable, "0", &aiValues[0], 5));
+   ASSURE(SymTable_findKeyByValue(oSymTable, &aiValues[0]) != NULL);
+   ASSURE(SymTable_expire(oSymTable, 5, 0) == 0);
+   ASSURE(SymTable_findKeyByValue(oSymTable, &aiValues[0]) == NULL);
+   ASSURE(SymTable_expire(oSymTable, 5, 1) == 1);
+   ASSURE(SymTable_findKeyByValue(oSymTable, &aiValues[0]) == NULL);
+   SymTable_free(oSymTable);
+
+   /* Many bindings sharing a value cost no more to put, replace or
+      remove than bindings with values of their own. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_addReverseIndex(oSymTable));
+   for (i = 0; i < SHARED_COUNT; i++)
+   {
+      sprintf(acKey, "s%d", i);
+      ASSURE(SymTable_put(oSymTable, acKey, &aiValues[i % 2]));
+   }
+   for (i = 0; i < SHARED_COUNT; i += 2)
+   {
+      sprintf(acKey, "s%d", i);
+      ASSURE(SymTable_replace(oSymTable, acKey, &aiValues[1])
+         == &aiValues[0]);
+   }
+   ASSURE(SymTable_findKeyByValue(oSymTable, &aiValues[0]) == NULL);
+   for (i = 0; i < SHARED_COUNT; i++)
+   {
+      ASSURE(SymTable_findKeyByValue(oSymTable, &aiValues[1]) != NULL);
+      sprintf(acKey, "s%d", i);
+      ASSURE(SymTable_remove(oSymTable, acKey) == &aiValues[1]);
+   }
+   ASSURE(SymTable_findKeyByValue(oSymTable, &aiValues[1]) == NULL);
+   SymTable_free(oSymTable);
+}
+
+/* Add the int that pvValueA points to, less the one pvValueB points
+   to, to the int that pvExtra points to. pcKey is unused. */
+
+static void addDifference(const char *pcKey, void *pvValueA,
+   void *pvValueB, void *pvExtra)
+{
+   assert(pcKey != NULL);
+   assert(pvValueA != NULL);
+   assert(pvValueB != NULL);
+   assert(pvExtra != NULL);
+
+   *(int*)pvExtra += *(int*)pvValueA - *(int*)pvValueB;
+}
+
+/* Append pcKey and a space to the string that pvExtra points to.
+   pvValue is unused. */
+
+static void appendKey(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   assert(pcKey != NULL);
+   assert(pvExtra != NULL);
+   (void)pvValue;
+
+   strcat((char*)pvExtra, pcKey);
+   strcat((char*)pvExtra, " ");
+}
+
+/* Test the SymTable_diff(), SymTable_intersectMap(), and
+   SymTable_unionInto() functions. */
+
+static void testSetOperations(void)
+{
+   enum {BINDING_COUNT = 3000, ORDER_COUNT = 1000};
+
+   SymTable_T oA;
+   SymTable_T oB;
+   static int aiValues[BINDING_COUNT];
+   static char acBefore[8 * ORDER_COUNT];
+   static char acAfter[8 * ORDER_COUNT];
+   int iZero = 0;
+   int iThree = 3;
+   char acKey[16];
+   int iSuccessful;
+   int iSum;
+   int iRound;
+   int iExpirations = 0;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable set operations.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   /* oA binds the keys below 2000, oB those from 1000 up. In the
+      second round the tables have different bucket counts. */
+   for (iRound = 0; iRound < 2; iRound++)
+   {
+      oA = SymTable_new();
+      ASSURE(oA != NULL);
+      oB = iRound == 0 ? SymTable_new() : SymTable_newSized(100000);
+      ASSURE(oB != NULL);
+      for (i = 0; i < BINDING_COUNT; i++)
+      {
+         aiValues[i] = 1;
+         sprintf(acKey, "%d", i);
+         if (i < 2000)
+         {
+            iSuccessful = SymTable_put(oA, acKey, &aiValues[i]);
+            ASSURE(iSuccessful);
+         }
+         if (i >= 1000)
+         {
+            iSuccessful = SymTable_put(oB, acKey, &aiValues[i]);
+            ASSURE(iSuccessful);
+         }
+      }
+
+      iSum = 0;
+      SymTable_diff(oA, oB, addValue, &iSum);
+      ASSURE(iSum == 1000);
+      iSum = 0;
+      SymTable_diff(oB, oA, addValue, &iSum);
+      ASSURE(iSum == 1000);
+
+      /* Shared keys see both values. */
+      iSum = 0;
+      SymTable_intersectMap(oA, oB, addDifference, &iSum);
+      ASSURE(iSum == 0);
+      ASSURE(SymTable_replace(oB, "1500", &iThree) == &aiValues[1500]);
+      iSum = 0;
+      SymTable_intersectMap(oA, oB, addDifference, &iSum);
+      ASSURE(iSum == -2);
+      iSum = 0;
+      SymTable_intersectMap(oB, oA, addDifference, &iSum);
+      ASSURE(iSum == 2);
+
+      iSuccessful = SymTable_unionInto(oA, oB);
+      ASSURE(iSuccessful);
+      ASSURE(SymTable_getLength(oA) == BINDING_COUNT);
+      ASSURE(SymTable_getLength(oB) == 2000);
+      ASSURE(SymTable_get(oA, "1500") == &aiValues[1500]);
+      ASSURE(SymTable_get(oA, "2500") == &aiValues[2500]);
+      iSum = 0;
+      SymTable_diff(oB, oA, addValue, &iSum);
+      ASSURE(iSum == 0);
+
+      SymTable_free(oA);
+      SymTable_free(oB);
+   }
+
+   /* The lookups they make leave the tables as they were: nothing
+      moves to the front and expired bindings are not reclaimed. oA's
+      extra keys give it more buckets than oB. */
+   oA = SymTable_newExpiring(countEviction, &iExpirations);
+   ASSURE(oA != NULL);
+   oB = SymTable_newExpiring(countEviction, &iExpirations);
+   ASSURE(oB != NULL);
+   SymTable_setMoveToFront(oB, 1);
+   for (i = 0; i < ORDER_COUNT; i++)
+   {
+      aiValues[i] = 1;
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_put(oA, acKey, &aiValues[i]));
+      ASSURE(SymTable_put(oB, acKey, &aiValues[i]));
+      sprintf(acKey, "x%d", i);
+      ASSURE(SymTable_put(oA, acKey, &iZero));
+   }
+   ASSURE(SymTable_put(oA, "Mantle", &iThree));
+   ASSURE(SymTable_putWithTTL(oB, "Mantle", &aiValues[0], 5));
+   ASSURE(SymTable_expire(oB, 10, 0) == 0);
+   acBefore[0] = '\0';
+   SymTable_map(oB, appendKey, acBefore);
+
+   iSum = 0;
+   SymTable_diff(oA, oB, addValue, &iSum);
+   ASSURE(iSum == 3);
+   iSum = 0;
+   SymTable_intersectMap(oA, oB, addDifference, &iSum);
+   ASSURE(iSum == 0);
+   iSum = 0;
+   SymTable_diff(oB, oA, addValue, &iSum);
+   ASSURE(iSum == 0);
+   ASSURE(iExpirations == 0);
+   ASSURE(SymTable_getLength(oB) == ORDER_COUNT + 1);
+   acAfter[0] = '\0';
+   SymTable_map(oB, appendKey, acAfter);
+   ASSURE(strcmp(acBefore, acAfter) == 0);
+
+   /* Adding a key whose binding has expired reclaims that binding
+      first, so the key is bound once. */
+   iSuccessful = SymTable_unionInto(oB, oA);
+   ASSURE(iSuccessful);
+   ASSURE(iExpirations == 1);
+   ASSURE(SymTable_getLength(oB) == 2 * ORDER_COUNT + 1);
+   ASSURE(SymTable_remove(oB, "Mantle") == &iThree);
+   ASSURE(! SymTable_contains(oB, "Mantle"));
+
+   SymTable_free(oA);
+   SymTable_free(oB);
+}
+
+/* Store pvValue in the pointer that pvExtra points to. pcKey is
+   unused. */
+
+static void saveValue(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   assert(pcKey != NULL);
+   assert(pvExtra != NULL);
+
+   *(void**)pvExtra = pvValue;
+}
+
+/* Test the SymTable_merge() function. */
+
+static void testMerge(void)
+{
+   enum {BINDING_COUNT = 2000};
+
+   SymTable_T oDst;
+   SymTable_T oSrc;
+   SymTable_T oClone;
+   char acKey[16];
+   int iSuccessful;
+   int iEvictions = 0;
+   int iExpirations = 0;
+   int i;
+   void *pvDropped = NULL;
+#ifdef SYMTABLE_STATS
+   struct SymTableStats sStats;
+#endif
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_merge() function.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oDst = SymTable_new();
+   ASSURE(oDst != NULL);
+   oSrc = SymTable_new();
+   ASSURE(oSrc != NULL);
+   ASSURE(SymTable_put(oDst, "Ruth", "Right Field"));
+   ASSURE(SymTable_put(oDst, "Gehrig", "First Base"));
+   ASSURE(SymTable_put(oSrc, "Gehrig", "Pinch Hitter"));
+   ASSURE(SymTable_put(oSrc, "Mantle", "Center Field"));
+   ASSURE(SymTable_putBorrowed(oSrc, "Jeter", "Shortstop"));
+
+   /* Keys in both keep the destination's value, or take the source's,
+      and the other value is handed back. */
+   ASSURE(SymTable_merge(oDst, oSrc, SYMTABLE_MERGE_KEEP, saveValue,
+      &pvDropped) == 1);
+   ASSURE(strcmp((char*)pvDropped, "Pinch Hitter") == 0);
+   ASSURE(SymTable_getLength(oSrc) == 0);
+   ASSURE(! SymTable_contains(oSrc, "Mantle"));
+   ASSURE(SymTable_getLength(oDst) == 4);
+   ASSURE(strcmp((char*)SymTable_get(oDst, "Gehrig"), "First Base") == 0);
+   ASSURE(strcmp((char*)SymTable_get(oDst, "Mantle"), "Center Field") == 0);
+   ASSURE(strcmp((char*)SymTable_get(oDst, "Jeter"), "Shortstop") == 0);
+   ASSURE(SymTable_put(oSrc, "Gehrig", "Pinch Hitter"));
+   ASSURE(SymTable_merge(oDst, oSrc, SYMTABLE_MERGE_REPLACE, saveValue,
+      &pvDropped) == 1);
+   ASSURE(strcmp((char*)pvDropped, "First Base") == 0);
+   ASSURE(strcmp((char*)SymTable_get(oDst, "Gehrig"), "Pinch Hitter") == 0);
+   ASSURE(SymTable_merge(oDst, oSrc, SYMTABLE_MERGE_KEEP, NULL, NULL) == 0);
+   ASSURE(SymTable_getLength(oDst) == 4);
+
+   /* Merging a large table, then freeing the emptied source. */
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(oSrc, acKey, &acKey[i % 8]);
+      ASSURE(iSuccessful);
+   }
+   ASSURE(SymTable_merge(oDst, oSrc, SYMTABLE_MERGE_KEEP, NULL, NULL) == 0);
+   SymTable_free(oSrc);
+   ASSURE(SymTable_getLength(oDst) == BINDING_COUNT + 4);
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_get(oDst, acKey) == &acKey[i % 8]);
+   }
+
+   /* A clone's keys live in its block, which moves with them. */
+   oClone = SymTable_clone(oDst);
+   ASSURE(oClone != NULL);
+   SymTable_free(oDst);
+   oDst = SymTable_new();
+   ASSURE(oDst != NULL);
+   ASSURE(SymTable_put(oDst, "Berra", "Catcher"));
+   ASSURE(SymTable_merge(oDst, oClone, SYMTABLE_MERGE_KEEP, NULL, NULL) == 0);
+   SymTable_free(oClone);
+   ASSURE(SymTable_getLength(oDst) == BINDING_COUNT + 5);
+   ASSURE(SymTable_contains(oDst, "Jeter"));
+   ASSURE(SymTable_contains(oDst, "1999"));
+   SymTable_free(oDst);
+
+   /* Expiries carry over, and bindings already expired go to the
+      source's callback; a bounded destination keeps its limit. */
+   oDst = SymTable_newExpiring(NULL, NULL);
+   ASSURE(oDst != NULL);
+   oSrc = SymTable_newExpiring(countEviction, &iExpirations);
+   ASSURE(oSrc != NULL);
+   ASSURE(SymTable_expire(oDst, 100, 10) == 0);
+   ASSURE(SymTable_putWithTTL(oSrc, "Ruth", NULL, 5));
+   ASSURE(SymTable_putWithTTL(oSrc, "Mantle", NULL, 1));
+   ASSURE(SymTable_put(oSrc, "Gehrig", NULL));
+   ASSURE(SymTable_expire(oSrc, 1, 0) == 0);
+   ASSURE(SymTable_merge(oDst, oSrc, SYMTABLE_MERGE_KEEP, NULL, NULL) == 0);
+   ASSURE(iExpirations == 1);
+   ASSURE(! SymTable_contains(oDst, "Mantle"));
+   ASSURE(SymTable_getLength(oDst) == 2);
+   ASSURE(SymTable_expire(oDst, 103, 10) == 0);
+   ASSURE(SymTable_expire(oDst, 104, 10) == 1);
+   ASSURE(SymTable_getLength(oDst) == 1);
+   SymTable_free(oSrc);
+   SymTable_free(oDst);
+
+   oDst = SymTable_newBounded(3, NULL, NULL);
+   ASSURE(oDst != NULL);
+   oSrc = SymTable_new();
+   ASSURE(oSrc != NULL);
+   for (i = 0; i < 10; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_put(oSrc, acKey, NULL));
+   }
+   ASSURE(SymTable_merge(oDst, oSrc, SYMTABLE_MERGE_KEEP, NULL, NULL) == 0);
+   ASSURE(SymTable_getLength(oDst) == 3);
+   SymTable_free(oSrc);
+   SymTable_free(oDst);
+
+   /* A bounded destination does not grow its buckets past its limit,
+      so later evictions stay cheap. */
+   oDst = SymTable_newBounded(8, countEviction, &iEvictions);
+   ASSURE(oDst != NULL);
+   oSrc = SymTable_new();
+   ASSURE(oSrc != NULL);
+   for (i = 0; i < 20; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_put(oSrc, acKey, NULL));
+   }
+   ASSURE(SymTable_merge(oDst, oSrc, SYMTABLE_MERGE_KEEP, NULL, NULL) == 0);
+   ASSURE(SymTable_getLength(oDst) == 8);
+   ASSURE(iEvictions == 12);
+#ifdef SYMTABLE_STATS
+   SymTable_getStats(oDst, &sStats);
+   ASSURE(sStats.uBucketCount <= 8);
+#endif
+   SymTable_free(oSrc);
+   SymTable_free(oDst);
+}
+
+/* Test the SymTableInterns functions and SymTable_newInterned(). */
+
+static void testInterned(void)
+{
+   enum {TABLE_COUNT = 10};
+
+   SymTableInterns_T oInterns;
+   SymTable_T aoTables[TABLE_COUNT];
+   SymTable_T oClone;
+   char acKey[16];
+   int iSuccessful;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_newInterned() function.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oInterns = SymTableInterns_new();
+   ASSURE(oInterns != NULL);
+   ASSURE(SymTableInterns_getLength(oInterns) == 0);
+
+   /* Every table binds the same keys; the pool holds one of each. */
+   for (i = 0; i < TABLE_COUNT; i++)
+   {
+      aoTables[i] = SymTable_newInterned(oInterns);
+      ASSURE(aoTables[i] != NULL);
+      iSuccessful = SymTable_put(aoTables[i], "Ruth", "Right Field");
+      ASSURE(iSuccessful);
+      iSuccessful = SymTable_put(aoTables[i], "Gehrig", "First Base");
+      ASSURE(iSuccessful);
+      iSuccessful = SymTable_putBorrowed(aoTables[i], "Mantle", NULL);
+      ASSURE(iSuccessful);
+      ASSURE(! SymTable_put(aoTables[i], "Ruth", NULL));
+   }
+   ASSURE(SymTableInterns_getLength(oInterns) == 3);
+
+   /* Lookups need not pass the pool's copy of a key. */
+   strcpy(acKey, "Gehrig");
+   ASSURE(SymTable_get(aoTables[0], acKey) != NULL);
+   ASSURE(strcmp((char*)SymTable_get(aoTables[0], acKey),
+      "First Base") == 0);
+   ASSURE(! SymTable_contains(aoTables[0], "Jeter"));
+   ASSURE(SymTableInterns_getLength(oInterns) == 3);
+
+   /* A key stays in the pool while any table binds it. */
+   iSuccessful = SymTable_put(aoTables[0], "Jeter", NULL);
+   ASSURE(iSuccessful);
+   ASSURE(! SymTable_contains(aoTables[1], "Jeter"));
+   ASSURE(SymTableInterns_getLength(oInterns) == 4);
+   oClone = SymTable_clone(aoTables[0]);
+   ASSURE(oClone != NULL);
+   ASSURE(SymTable_remove(aoTables[0], "Jeter") == NULL);
+   ASSURE(SymTableInterns_getLength(oInterns) == 4);
+   ASSURE(SymTable_contains(oClone, "Jeter"));
+   ASSURE(SymTable_getLength(oClone) == 4);
+   SymTable_free(oClone);
+   ASSURE(SymTableInterns_getLength(oInterns) == 3);
+
+   for (i = 0; i < TABLE_COUNT; i++)
+      ASSURE(SymTable_remove(aoTables[i], "Ruth") != NULL);
+   ASSURE(SymTableInterns_getLength(oInterns) == 2);
+   ASSURE(! SymTable_contains(aoTables[0], "Ruth"));
+
+   /* Many keys make the pool grow. */
+   for (i = 0; i < 1000; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iSuccessful = SymTable_put(aoTables[i % TABLE_COUNT], acKey, NULL);
+      ASSURE(iSuccessful);
+   }
+   ASSURE(SymTableInterns_getLength(oInterns) == 1002);
+   for (i = 0; i < 1000; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_contains(aoTables[i % TABLE_COUNT], acKey));
+      ASSURE(! SymTable_contains(aoTables[(i + 1) % TABLE_COUNT], acKey));
+   }
+
+   for (i = 0; i < TABLE_COUNT; i++)
+      SymTable_free(aoTables[i]);
+   ASSURE(SymTableInterns_getLength(oInterns) == 0);
+   SymTableInterns_free(oInterns);
+}
+
+/* Test the SymTable_increment(), SymTable_incrementAtomic(), and
+   SymTable_getCount() functions. */
+
+static void testCounters(void)
+{
+   SymTable_T oSymTable;
+   char acKey[16];
+   int iSuccessful;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_increment() and SymTable_getCount()\n");
+   printf("functions.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   ASSURE(SymTable_getCount(oSymTable, "the") == 0);
+   iSuccessful = SymTable_increment(oSymTable, "the", 1);
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_getCount(oSymTable, "the") == 1);
+   iSuccessful = SymTable_increment(oSymTable, "the", 41);
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_getCount(oSymTable, "the") == 42);
+   iSuccessful = SymTable_incrementAtomic(oSymTable, "the", -50);
+   ASSURE(iSuccessful);
+   ASSURE(SymTable_getCount(oSymTable, "the") == -8);
+   ASSURE(SymTable_getLength(oSymTable) == 1);
+
+   /* Count word frequencies: key i is seen i times. */
+   for (i = 0; i < 100; i++)
+   {
+      int j;
+      sprintf(acKey, "%d", i);
+      for (j = 0; j < i; j++)
+      {
+         iSuccessful = SymTable_incrementAtomic(oSymTable, acKey, 1);
+         ASSURE(iSuccessful);
+      }
+   }
+   ASSURE(SymTable_getLength(oSymTable) == 100);
+   for (i = 0; i < 100; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_getCount(oSymTable, acKey) == i);
+   }
+
+   SymTable_free(oSymTable);
+}
+#endif
+
+/*--------------------------------------------------------------------*/
+
+#ifdef SYMTABLE_STATS
+/* Test the SymTable_getStats() function. */
+
+static void testStats(void)
+{
+   enum {BINDING_COUNT = 2000};
+
+   SymTable_T oSymTable;
+   struct SymTableStats sStats;
+   char acKey[16];
+   size_t uBuckets;
+   size_t uBindings;
+   int i;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTable_getStats() function.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   SymTable_getStats(oSymTable, &sStats);
+   ASSURE(sStats.uBucketCount >= 1);
+   ASSURE(sStats.uMaxChain == 0);
+   ASSURE(sStats.auChainHistogram[0] == sStats.uBucketCount);
+   ASSURE(sStats.uNodeBytes == 0);
+   ASSURE(sStats.uKeyBytes == 0);
+
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_put(oSymTable, acKey, NULL));
+   }
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_contains(oSymTable, acKey));
+      sprintf(acKey, "x%d", i);
+      ASSURE(! SymTable_contains(oSymTable, acKey));
+   }
+
+   SymTable_getStats(oSymTable, &sStats);
+   uBuckets = 0;
+   uBindings = 0;
+   for (i = 0; i < SYMTABLE_STATS_HISTOGRAM; i++)
+   {
+      uBuckets += sStats.auChainHistogram[i];
+      uBindings += (size_t)i * sStats.auChainHistogram[i];
+   }
+   ASSURE(uBuckets == sStats.uBucketCount);
+   ASSURE(uBindings <= BINDING_COUNT);
+   ASSURE(sStats.uMaxChain >= 1);
+   ASSURE(sStats.dLoadFactor ==
+      (double)BINDING_COUNT / (double)sStats.uBucketCount);
+   ASSURE(sStats.dAvgProbesHit >= 1.0);
+#ifdef SYMTABLE_CUCKOO
+   ASSURE(sStats.uNodeBytes == 0);
+#else
+   ASSURE(sStats.uNodeBytes > 0);
+#endif
+   ASSURE(sStats.uKeyBytes >= BINDING_COUNT * 2);
+
+   SymTable_free(oSymTable);
+}
+#endif
+
+/*--------------------------------------------------------------------*/
+
+#ifdef SYMTABLE_CUCKOO
+/* Test that a cuckoo table keeps every binding while it moves keys to
+   their other bucket, stashes them and grows. */
+
+static void testCuckoo(void)
+{
+   enum {BINDING_COUNT = 2000, BUCKET_SLOTS = 4};
+
+   static int aiValues[BINDING_COUNT];
+   SymTable_T oSymTable;
+   struct SymTableStats sStats;
+   char acKey[16];
+   size_t uMaxStashed = 0;
+   size_t uExpansions = 0;
+   size_t uBindings;
+   int i;
+   int j;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the displacement, stash and growth of a cuckoo\n");
+   printf("table.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   /* The table grows only once no displacement path is found and the
+      stash is full, so filling it must use all three. */
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_put(oSymTable, acKey, &aiValues[i]));
+      SymTable_getStats(oSymTable, &sStats);
+      if (sStats.uStashed > uMaxStashed)
+         uMaxStashed = sStats.uStashed;
+
+      /* Right after a growth, every binding must have been moved. */
+      if (sStats.uExpansions != uExpansions)
+      {
+         uExpansions = sStats.uExpansions;
+         for (j = 0; j <= i; j++)
+         {
+            sprintf(acKey, "%d", j);
+            ASSURE(SymTable_get(oSymTable, acKey) == &aiValues[j]);
+         }
+      }
+   }
+   ASSURE(uMaxStashed > 0);
+   ASSURE(sStats.uDisplacements > 0);
+   ASSURE(sStats.uExpansions > 0);
+   ASSURE(sStats.uBucketCount * BUCKET_SLOTS >= BINDING_COUNT);
+   ASSURE(SymTable_getLength(oSymTable) == BINDING_COUNT);
+
+   /* Each binding is in one bucket of at most BUCKET_SLOTS, or in the
+      stash. */
+   ASSURE(sStats.uMaxChain <= BUCKET_SLOTS);
+   uBindings = sStats.uStashed;
+   for (i = 0; i <= BUCKET_SLOTS; i++)
+      uBindings += (size_t)i * sStats.auChainHistogram[i];
+   ASSURE(uBindings == BINDING_COUNT);
+
+   /* Removing keys frees slots, into which stashed keys move. */
+   for (i = 0; i < BINDING_COUNT; i += 2)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_remove(oSymTable, acKey) == &aiValues[i]);
+   }
+   SymTable_getStats(oSymTable, &sStats);
+   ASSURE(sStats.uStashed == 0);
+   for (i = 0; i < BINDING_COUNT; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTable_get(oSymTable, acKey)
+         == (i % 2 == 0 ? NULL : &aiValues[i]));
+   }
+   ASSURE(SymTable_getLength(oSymTable) == BINDING_COUNT / 2);
+
+   SymTable_free(oSymTable);
+}
+#endif
+
+/*--------------------------------------------------------------------*/
+
+/* Test the ability of a SymTable object to be large, that is, to
+   contain iBindingCount bindings. Write the time consumed to stdout. */
+
+static void testLargeTable(int iBindingCount)
+{
+   enum {MAX_KEY_LENGTH = 10};
+
+   SymTable_T oSymTable;
+   SymTable_T oSymTableSmall;
+   char acKey[MAX_KEY_LENGTH];
+   char *pcValue;
+   int i;
+   int iSmall;
+   int iLarge;
+   int iSuccessful;
+   clock_t iInitialClock;
+   clock_t iFinalClock;
+   size_t uLength = 0;
+   size_t uLength2;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a potentially large SymTable object.\n");
+   printf("No output except CPU time consumed should appear here:\n");
+   fflush(stdout);
+
+   /* Note the current time. */
+   iInitialClock = clock();
+
+   /* Create oSymTableSmall, and put a couple of bindings into it. */
+   oSymTableSmall = SymTable_new();
+   ASSURE(oSymTableSmall != NULL);
+   iSuccessful = SymTable_put(oSymTableSmall, "xxx", "xxx");
+   ASSURE(iSuccessful);
+   iSuccessful = SymTable_put(oSymTableSmall, "yyy", "yyy");
+   ASSURE(iSuccessful);
+
+   /* Create oSymTable, the primary SymTable object. */
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+
+   /* Put iBindingCount new bindings into oSymTable.  Each binding's
+      key and value contain the same characters. */
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      pcValue = (char*)malloc(sizeof(char) * (strlen(acKey) + 1));
+      ASSURE(pcValue != NULL);
+      strcpy(pcValue, acKey);
+      iSuccessful = SymTable_put(oSymTable, acKey, pcValue);
+      ASSURE(iSuccessful);
+      uLength = SymTable_getLength(oSymTable);
+      ASSURE(uLength == (size_t)(i+1));
+   }
+
+   /* Get each binding's value, and make sure that it contains
+      the same characters as its key. */
+   iSmall = 0;
+   iLarge = iBindingCount - 1;
+   while (iSmall < iLarge)
+   {
+      /* Get the smallest of the remaining bindings. */
+      sprintf(acKey, "%d", iSmall);
+      pcValue = (char*)SymTable_get(oSymTable, acKey);
+      ASSURE(pcValue != NULL);
+      ASSURE((pcValue != NULL) && (strcmp(pcValue, acKey) == 0));
+      iSmall++;
+      /* Get the largest of the remaining bindings. */
+      sprintf(acKey, "%d", iLarge);
+      pcValue = (char*)SymTable_get(oSymTable, acKey);
+      ASSURE(pcValue != NULL);
+      ASSURE((pcValue != NULL) && (strcmp(pcValue, acKey) == 0));
+      iLarge--;
+   }
+   /* Get the middle binding -- if there is one. */
+   if (iSmall == iLarge)
+   {
+      sprintf(acKey, "%d", iSmall);
+      pcValue = (char*)SymTable_get(oSymTable, acKey);
+      ASSURE(pcValue != NULL);
+      ASSURE((pcValue != NULL) && (strcmp(pcValue, acKey) == 0));
+   }
+
+   /* Remove each binding. Also free each binding's value. */
+   iSmall = 0;
+   iLarge = iBindingCount - 1;
+   while (iSmall < iLarge)
+   {
+      /* Remove the smallest of the remaining bindings. */
+      sprintf(acKey, "%d", iSmall);
+      pcValue = (char*)SymTable_remove(oSymTable, acKey);
+      ASSURE(pcValue != NULL);
+      ASSURE((pcValue != NULL) && (strcmp(pcValue, acKey) == 0));
+      free(pcValue);
+      uLength--;
+      uLength2 = SymTable_getLength(oSymTable);
+      ASSURE(uLength2 == uLength);
+      iSmall++;
+      /* Remove the largest of the remaining bindings. */
+      sprintf(acKey, "%d", iLarge);
+      pcValue = (char*)SymTable_remove(oSymTable, acKey);
+      ASSURE(pcValue != NULL);
+      ASSURE((pcValue != NULL) && (strcmp(pcValue, acKey) == 0));
+      free(pcValue);
+      uLength--;
+      uLength2 = SymTable_getLength(oSymTable);
+      ASSURE(uLength2 == uLength);
+      iLarge--;
+   }
+   /* Remove the middle binding -- if there is one. */
+   if (iSmall == iLarge)
+   {
+      sprintf(acKey, "%d", iSmall);
+      pcValue = (char*)SymTable_remove(oSymTable, acKey);
+      ASSURE(pcValue != NULL);
+      ASSURE((pcValue != NULL) && (strcmp(pcValue, acKey) == 0));
+      free(pcValue);
+      uLength--;
+      uLength2 = SymTable_getLength(oSymTable);
+      ASSURE(uLength2 == uLength);  
+   }
+
+   /* Make sure oSymTableSmall hasn't been corrupted by expansion
+      of oSymTable. */
+   pcValue = (char*)SymTable_get(oSymTableSmall, "xxx");
+   ASSURE((pcValue != NULL) && (strcmp(pcValue, "xxx") == 0));
+   pcValue = (char*)SymTable_get(oSymTableSmall, "yyy");
+   ASSURE((pcValue != NULL) && (strcmp(pcValue, "yyy") == 0));
+
+   /* Free both SymTable objects. */
+   SymTable_free(oSymTable);
+   SymTable_free(oSymTableSmall);
+
+   /* Note the current time, and print the time consumed to stdout. */
+   iFinalClock = clock();
+   printf("CPU time (%d bindings):  %f seconds\n", iBindingCount,
+      ((double)(iFinalClock - iInitialClock)) / CLOCKS_PER_SEC);
+   fflush(stdout);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the SymTable ADT.  Write the output of the tests to stdout.
+   As always, argc is the command-line argument count, argv contains
+   the command-line arguments, and argv[0] is the name of the
+   executable binary file. argv[1] is the number of bindings to put
+   into a potentially large SymTable object.  Exit with EXIT_FAILURE
+   if argv[1] is missing or not numeric.  Otherwise return 0. */
+
+int main(int argc, char *argv[])
+{
+   int iBindingCount;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s bindingcount\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+
+   if (sscanf(argv[1], "%d", &iBindingCount) != 1)
+   {
+      fprintf(stderr, "bindingcount must be numeric\n");
+      exit(EXIT_FAILURE);
+   }
+   if (iBindingCount < 0)
+   {
+      fprintf(stderr, "bindingcount cannot be negative\n");
+      exit(EXIT_FAILURE);
+   }
+   
+#ifndef S_SPLINT_S
+   setCpuTimeLimit();
+#endif
+
+   testBasics();
+   testKeyComparison();
+   testKeyOwnership();
+   testRemove();
+   testMap();
+   testEmptyTable();
+   testEmptyKey();
+   testNullValue();
+   testLongKey();
+   testTableOfTables();
+   testCollisions();
+   testClone();
+#ifdef SYMTABLE_SNAPSHOT
+   testSnapshot();
+#endif
+#ifndef SYMTABLE_CORE_ONLY
+   testBounded();
+   testExpiry();
+   testUpsert();
+   testCounters();
+   testBorrowed();
+   testSized();
+   testFilter();
+   testMoveToFront();
+   testInterned();
+   testClear();
+   testMerge();
+   testRemoveIf();
+   testReverseIndex();
+   testSetOperations();
+#endif
+#ifdef SYMTABLE_STATS
+   testStats();
+#endif
+#ifdef SYMTABLE_CUCKOO
+   testCuckoo();
+#endif
    testLargeTable(iBindingCount);
 
    printf("------------------------------------------------------\n");
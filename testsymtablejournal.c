@@ -0,0 +1,319 @@
+/*--------------------------------------------------------------------*/
+/* testsymtablejournal.c                                              */
+/* Author: Tara Shukla                                                */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "symtablejournal.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* This program is linked with fsync wrapped, so that testSyncFailures
+   can make it fail. */
+
+/* Whether fsync fails on regular files, and on directories. */
+
+static int iFailFileSyncs = 0;
+static int iFailDirectorySyncs = 0;
+
+int __real_fsync(int iFd);
+
+/* Fail with EIO if asked to for the kind of file iFd is open on, else
+   forward to the real fsync. */
+
+int __wrap_fsync(int iFd)
+{
+   struct stat sStat;
+
+   if (fstat(iFd, &sStat) == 0
+      && (S_ISDIR(sStat.st_mode) ? iFailDirectorySyncs : iFailFileSyncs))
+   {
+      errno = EIO;
+      return -1;
+   }
+   return __real_fsync(iFd);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 if oSymTable binds pcKey to the string pcValue, else 0. */
+
+static int bindsTo(SymTableJournal_T oSymTable, const char *pcKey,
+   const char *pcValue)
+{
+   const char *pcFound;
+   size_t uLength;
+
+   pcFound = (const char*)SymTableJournal_get(oSymTable, pcKey, &uLength);
+   return pcFound != NULL && uLength == strlen(pcValue) + 1
+      && strcmp(pcFound, pcValue) == 0;
+}
+
+/* Return the size in bytes of the file pcPath, or -1 if it cannot be
+   found. */
+
+static long fileSize(const char *pcPath)
+{
+   struct stat sStat;
+
+   if (stat(pcPath, &sStat) != 0)
+      return -1;
+   return (long)sStat.st_size;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test changing a table, reopening it, and recovering from a log
+   whose last record was cut short. pcPath names the log. */
+
+static void testBasics(const char *pcPath)
+{
+   SymTableJournal_T oSymTable;
+   long lSize;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the basic SymTableJournal functions.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_openJournaled(pcPath);
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTableJournal_getLength(oSymTable) == 0);
+
+   ASSURE(SymTableJournal_put(oSymTable, "Jeter", "Shortstop", 10));
+   ASSURE(SymTableJournal_put(oSymTable, "Mantle", "Center Field", 13));
+   ASSURE(SymTableJournal_put(oSymTable, "Gehrig", "First Base", 11));
+   ASSURE(! SymTableJournal_put(oSymTable, "Jeter", "Catcher", 8));
+   ASSURE(SymTableJournal_put(oSymTable, "", "", 0));
+   ASSURE(SymTableJournal_replace(oSymTable, "Mantle", "Outfield", 9));
+   ASSURE(! SymTableJournal_replace(oSymTable, "Ruth", "Outfield", 9));
+   ASSURE(SymTableJournal_remove(oSymTable, "Gehrig"));
+   ASSURE(! SymTableJournal_remove(oSymTable, "Gehrig"));
+   ASSURE(SymTableJournal_getLength(oSymTable) == 3);
+   ASSURE(bindsTo(oSymTable, "Mantle", "Outfield"));
+   ASSURE(SymTableJournal_close(oSymTable));
+
+   /* Reopening replays the log. */
+   oSymTable = SymTable_openJournaled(pcPath);
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTableJournal_getLength(oSymTable) == 3);
+   ASSURE(bindsTo(oSymTable, "Jeter", "Shortstop"));
+   ASSURE(bindsTo(oSymTable, "Mantle", "Outfield"));
+   ASSURE(SymTableJournal_contains(oSymTable, ""));
+   ASSURE(! SymTableJournal_contains(oSymTable, "Gehrig"));
+   ASSURE(SymTableJournal_put(oSymTable, "Ruth", "Right Field", 12));
+   ASSURE(SymTableJournal_close(oSymTable));
+
+   /* A torn last record is dropped, and later records follow the
+      ones before it. */
+   lSize = fileSize(pcPath);
+   ASSURE(lSize > 0);
+   ASSURE(truncate(pcPath, (off_t)(lSize - 3)) == 0);
+   oSymTable = SymTable_openJournaled(pcPath);
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTableJournal_getLength(oSymTable) == 3);
+   ASSURE(! SymTableJournal_contains(oSymTable, "Ruth"));
+   ASSURE(SymTableJournal_put(oSymTable, "Berra", "Catcher", 8));
+   ASSURE(SymTableJournal_sync(oSymTable));
+   ASSURE(SymTableJournal_close(oSymTable));
+
+   oSymTable = SymTable_openJournaled(pcPath);
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTableJournal_getLength(oSymTable) == 4);
+   ASSURE(bindsTo(oSymTable, "Berra", "Catcher"));
+   ASSURE(SymTableJournal_close(oSymTable));
+
+   ASSURE(unlink(pcPath) == 0);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that a failed fsync is reported without losing track of what
+   the log holds. pcPath names the log. */
+
+static void testSyncFailures(const char *pcPath)
+{
+   SymTableJournal_T oSymTable;
+   long lSize;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing SymTableJournal with failing fsyncs.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   /* A change whose record was written stays, though its fsync failed;
+      later changes, syncs and the close then fail. */
+   oSymTable = SymTable_openJournaled(pcPath);
+   ASSURE(oSymTable != NULL);
+   SymTableJournal_setSyncInterval(oSymTable, 1);
+   ASSURE(SymTableJournal_put(oSymTable, "Jeter", "Shortstop", 10));
+   iFailFileSyncs = 1;
+   ASSURE(SymTableJournal_put(oSymTable, "Mantle", "Center Field", 13));
+   iFailFileSyncs = 0;
+   ASSURE(bindsTo(oSymTable, "Mantle", "Center Field"));
+   ASSURE(! SymTableJournal_put(oSymTable, "Gehrig", "First Base", 11));
+   ASSURE(! SymTableJournal_contains(oSymTable, "Gehrig"));
+   ASSURE(! SymTableJournal_sync(oSymTable));
+   ASSURE(! SymTableJournal_close(oSymTable));
+
+   oSymTable = SymTable_openJournaled(pcPath);
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTableJournal_getLength(oSymTable) == 2);
+   ASSURE(bindsTo(oSymTable, "Mantle", "Center Field"));
+
+   /* Once the compacted log is renamed into place it is the log, even
+      if the directory cannot be synced. */
+   ASSURE(SymTableJournal_replace(oSymTable, "Mantle", "Outfield", 9));
+   ASSURE(SymTableJournal_sync(oSymTable));
+   lSize = fileSize(pcPath);
+   iFailDirectorySyncs = 1;
+   ASSURE(! SymTableJournal_compact(oSymTable));
+   iFailDirectorySyncs = 0;
+   ASSURE(fileSize(pcPath) < lSize);
+   ASSURE(SymTableJournal_put(oSymTable, "Berra", "Catcher", 8));
+   ASSURE(SymTableJournal_close(oSymTable));
+
+   oSymTable = SymTable_openJournaled(pcPath);
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTableJournal_getLength(oSymTable) == 3);
+   ASSURE(bindsTo(oSymTable, "Mantle", "Outfield"));
+   ASSURE(bindsTo(oSymTable, "Berra", "Catcher"));
+   ASSURE(SymTableJournal_close(oSymTable));
+
+   ASSURE(unlink(pcPath) == 0);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test a table of iBindingCount bindings, each replaced once, and
+   compacting its log. pcPath names the log. */
+
+static void testLargeTable(const char *pcPath, int iBindingCount)
+{
+   SymTableJournal_T oSymTable;
+   char acKey[16];
+   int iValue;
+   const int *piFound;
+   long lSize;
+   int i;
+   clock_t iInitialClock;
+   clock_t iFinalClock;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a potentially large SymTableJournal object.\n");
+   printf("No output except CPU time consumed should appear here:\n");
+   fflush(stdout);
+
+   iInitialClock = clock();
+
+   oSymTable = SymTable_openJournaled(pcPath);
+   ASSURE(oSymTable != NULL);
+   SymTableJournal_setSyncInterval(oSymTable, 4096);
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTableJournal_put(oSymTable, acKey, &i, sizeof(int)));
+   }
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      iValue = -i;
+      ASSURE(SymTableJournal_replace(oSymTable, acKey, &iValue,
+         sizeof(int)));
+   }
+   for (i = 0; i < iBindingCount; i += 2)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTableJournal_remove(oSymTable, acKey));
+   }
+   ASSURE(SymTableJournal_sync(oSymTable));
+
+   /* Compacting keeps only the live bindings, so the log shrinks. */
+   lSize = fileSize(pcPath);
+   ASSURE(SymTableJournal_compact(oSymTable));
+   ASSURE(iBindingCount == 0 || fileSize(pcPath) < lSize);
+   ASSURE(SymTableJournal_put(oSymTable, "after", "compact", 8));
+   ASSURE(SymTableJournal_close(oSymTable));
+
+   oSymTable = SymTable_openJournaled(pcPath);
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTableJournal_getLength(oSymTable)
+      == (size_t)(iBindingCount / 2) + 1);
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      piFound = (const int*)SymTableJournal_get(oSymTable, acKey, NULL);
+      if (i % 2 == 0)
+         ASSURE(piFound == NULL);
+      else
+         ASSURE(piFound != NULL && *piFound == -i);
+   }
+   ASSURE(bindsTo(oSymTable, "after", "compact"));
+   ASSURE(SymTableJournal_close(oSymTable));
+
+   ASSURE(unlink(pcPath) == 0);
+
+   iFinalClock = clock();
+   printf("CPU time (%d bindings):  %f seconds\n", iBindingCount,
+      ((double)(iFinalClock - iInitialClock)) / CLOCKS_PER_SEC);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the SymTableJournal implementation with argv[1] bindings in the
+   large table. Return 0, or exit with EXIT_FAILURE on bad usage. */
+
+int main(int argc, char *argv[])
+{
+   char acPath[64];
+   int iBindingCount;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s bindingcount\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+   if (sscanf(argv[1], "%d", &iBindingCount) != 1 || iBindingCount < 0)
+   {
+      fprintf(stderr, "bindingcount must be a nonnegative number\n");
+      exit(EXIT_FAILURE);
+   }
+
+   /* A per-process name keeps concurrent runs apart. */
+   sprintf(acPath, "/tmp/testsymtablejournal.%ld", (long)getpid());
+   testBasics(acPath);
+   testSyncFailures(acPath);
+   testLargeTable(acPath, iBindingCount);
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
+
+/*--------------------------------------------------------------------*/
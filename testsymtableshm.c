@@ -0,0 +1,213 @@
+/*--------------------------------------------------------------------*/
+/* testsymtableshm.c                                                  */
+/* Author: Tara Shukla                                                */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "symtableshm.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return 1 if oSymTable binds pcKey to the string pcValue, else 0. */
+
+static int bindsTo(SymTableShm_T oSymTable, const char *pcKey,
+   const char *pcValue)
+{
+   const char *pcFound;
+   size_t uLength;
+
+   pcFound = (const char*)SymTableShm_get(oSymTable, pcKey, &uLength);
+   return pcFound != NULL && uLength == strlen(pcValue) + 1
+      && strcmp(pcFound, pcValue) == 0;
+}
+
+/* Add the length of pvValue to the sum pvExtra points to. */
+
+static void sumLengths(const char *pcKey, const void *pvValue,
+   size_t uLength, void *pvExtra)
+{
+   (void)pcKey;
+   (void)pvValue;
+   *(size_t*)pvExtra += uLength;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test building a table in one process and reading it in another, and
+   reading a table while it changes. pcName names the shared object. */
+
+static void testBasics(const char *pcName)
+{
+   SymTableShm_T oWriter;
+   SymTableShm_T oReader;
+   size_t uSum = 0;
+   pid_t iPid;
+   int iStatus;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the basic SymTableShm functions.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   ASSURE(SymTableShm_attach(pcName) == NULL);
+   oWriter = SymTableShm_create(pcName, 4096);
+   ASSURE(oWriter != NULL);
+
+   ASSURE(SymTableShm_put(oWriter, "Jeter", "Shortstop", 10));
+   ASSURE(SymTableShm_put(oWriter, "Mantle", "Center Field", 13));
+   ASSURE(SymTableShm_put(oWriter, "Gehrig", "First Base", 11));
+   ASSURE(! SymTableShm_put(oWriter, "Jeter", "Catcher", 8));
+   ASSURE(SymTableShm_put(oWriter, "", "", 0));
+   ASSURE(SymTableShm_getLength(oWriter) == 4);
+
+   /* Another process maps the table and reads it in place. */
+   fflush(stdout);
+   iPid = fork();
+   ASSURE(iPid >= 0);
+   if (iPid == 0)
+   {
+      oReader = SymTableShm_attach(pcName);
+      if (oReader == NULL || SymTableShm_getLength(oReader) != 4
+         || ! bindsTo(oReader, "Jeter", "Shortstop")
+         || ! bindsTo(oReader, "Mantle", "Center Field")
+         || ! SymTableShm_contains(oReader, "")
+         || SymTableShm_contains(oReader, "Ruth"))
+         _exit(1);
+      SymTableShm_detach(oReader);
+      _exit(0);
+   }
+   ASSURE(waitpid(iPid, &iStatus, 0) == iPid);
+   ASSURE(WIFEXITED(iStatus) && WEXITSTATUS(iStatus) == 0);
+
+   /* A reader sees the writer's later changes. */
+   oReader = SymTableShm_attach(pcName);
+   ASSURE(oReader != NULL);
+   ASSURE(SymTableShm_replace(oWriter, "Mantle", "Outfield", 9));
+   ASSURE(! SymTableShm_replace(oWriter, "Ruth", "Outfield", 9));
+   ASSURE(bindsTo(oReader, "Mantle", "Outfield"));
+   ASSURE(SymTableShm_remove(oWriter, "Gehrig"));
+   ASSURE(! SymTableShm_remove(oWriter, "Gehrig"));
+   ASSURE(! SymTableShm_contains(oReader, "Gehrig"));
+   ASSURE(SymTableShm_getLength(oReader) == 3);
+
+   SymTableShm_map(oReader, sumLengths, &uSum);
+   ASSURE(uSum == 10 + 9 + 0);
+
+   SymTableShm_detach(oReader);
+   SymTableShm_detach(oWriter);
+   ASSURE(SymTableShm_unlink(pcName));
+   ASSURE(SymTableShm_attach(pcName) == NULL);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test a table of iBindingCount bindings, including filling it up.
+   pcName names the shared object. */
+
+static void testLargeTable(const char *pcName, int iBindingCount)
+{
+   SymTableShm_T oSymTable;
+   char acKey[16];
+   int iPuts;
+   int i;
+   clock_t iInitialClock;
+   clock_t iFinalClock;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a potentially large SymTableShm object.\n");
+   printf("No output except CPU time consumed should appear here:\n");
+   fflush(stdout);
+
+   iInitialClock = clock();
+
+   oSymTable = SymTableShm_create(pcName, (size_t)iBindingCount * 64 + 4096);
+   ASSURE(oSymTable != NULL);
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTableShm_put(oSymTable, acKey, &i, sizeof(int)));
+   }
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTableShm_contains(oSymTable, acKey));
+   }
+
+   /* Once full, puts fail and leave the table as it was. */
+   for (iPuts = 0; ; iPuts++)
+   {
+      sprintf(acKey, "x%d", iPuts);
+      if (! SymTableShm_put(oSymTable, acKey, &iPuts, sizeof(int)))
+         break;
+   }
+   ASSURE(SymTableShm_getLength(oSymTable)
+      == (size_t)iBindingCount + (size_t)iPuts);
+   sprintf(acKey, "x%d", iPuts);
+   ASSURE(! SymTableShm_contains(oSymTable, acKey));
+
+   SymTableShm_detach(oSymTable);
+   ASSURE(SymTableShm_unlink(pcName));
+
+   iFinalClock = clock();
+   printf("CPU time (%d bindings):  %f seconds\n", iBindingCount,
+      ((double)(iFinalClock - iInitialClock)) / CLOCKS_PER_SEC);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the SymTableShm implementation with argv[1] bindings in the
+   large table. Return 0, or exit with EXIT_FAILURE on bad usage. */
+
+int main(int argc, char *argv[])
+{
+   char acName[64];
+   int iBindingCount;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s bindingcount\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+   if (sscanf(argv[1], "%d", &iBindingCount) != 1 || iBindingCount < 0)
+   {
+      fprintf(stderr, "bindingcount must be a nonnegative number\n");
+      exit(EXIT_FAILURE);
+   }
+
+   /* A per-process name keeps concurrent runs apart. */
+   sprintf(acName, "/testsymtableshm.%ld", (long)getpid());
+   testBasics(acName);
+   testLargeTable(acName, iBindingCount);
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
+
+/*--------------------------------------------------------------------*/
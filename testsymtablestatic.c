@@ -0,0 +1,168 @@
+/*--------------------------------------------------------------------*/
+/* testsymtablestatic.c                                               */
+/* Author: Tara Shukla                                                */
+/*--------------------------------------------------------------------*/
+
+#include "symtablestatic.h"
+#include "testkeywords.h"
+#include "testempty.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* The keys of testkeywords.tsv, each followed by its value or NULL. */
+
+static const char *const apcKeywords[] =
+{
+   "auto", "AUTO", "break", "BREAK", "case", "CASE", "char", "CHAR",
+   "const", "CONST", "continue", "CONTINUE", "default", "DEFAULT",
+   "do", "DO", "double", "DOUBLE", "else", "ELSE", "enum", "ENUM",
+   "extern", "EXTERN", "float", "FLOAT", "for", "FOR", "goto", "GOTO",
+   "if", "IF", "inline", "INLINE", "int", "INT", "long", "LONG",
+   "register", "REGISTER", "restrict", "RESTRICT", "return", "RETURN",
+   "short", "SHORT", "signed", "SIGNED", "sizeof", "SIZEOF",
+   "static", "STATIC", "struct", "STRUCT", "switch", "SWITCH",
+   "typedef", "TYPEDEF", "union", "UNION", "unsigned", "UNSIGNED",
+   "void", "VOID", "volatile", "VOLATILE", "while", "WHILE",
+   "_Bool", NULL, "_Complex", NULL, "_Imaginary", NULL,
+   "\"quoted\"", "say \"hi\"\\n", "a?\?=b", "what?\?/"
+};
+
+/* Keys absent from testkeywords.tsv, most of them a character away
+   from one that is present. */
+
+static const char *const apcAbsent[] =
+{
+   "", "in", "intt", "Int", "INT", "int ", " int", "whilE", "dO",
+   "unsigne", "unsignedd", "_bool", "_Boo", "quoted", "\"quoted",
+   "sizeof\t", "struct\n", "#", "auto\tAUTO", "typedef_", "enum2",
+   "a#b", "a?=b"
+};
+
+/* Count in *(size_t*)pvExtra each binding of the keyword table that
+   appears in apcKeywords with the value pvValue. */
+
+static void countKnown(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   size_t i;
+
+   for (i = 0; i < sizeof(apcKeywords) / sizeof(apcKeywords[0]); i += 2)
+   {
+      if (strcmp(apcKeywords[i], pcKey) == 0
+         && (apcKeywords[i + 1] == NULL ? pvValue == NULL
+            : pvValue != NULL && strcmp(apcKeywords[i + 1], pvValue) == 0))
+         (*(size_t*)pvExtra)++;
+   }
+}
+
+/* Count in *(size_t*)pvExtra each binding. */
+
+static void countAll(const char *pcKey, void *pvValue, void *pvExtra)
+{
+   (void)pcKey;
+   (void)pvValue;
+   (*(size_t*)pvExtra)++;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the table symtablegen built from testkeywords.tsv. */
+
+static void testKeywords(void)
+{
+   size_t uKeyCount = sizeof(apcKeywords) / sizeof(apcKeywords[0]) / 2;
+   size_t uCount;
+   size_t i;
+   const char *pcValue;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a generated static table.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   ASSURE(SymTableStatic_getLength(&testkeywords) == uKeyCount);
+   ASSURE(testkeywords.uSlotCount >= uKeyCount);
+
+   for (i = 0; i < 2 * uKeyCount; i += 2)
+   {
+      ASSURE(SymTableStatic_contains(&testkeywords, apcKeywords[i]));
+      pcValue = (const char*)SymTableStatic_get(&testkeywords,
+         apcKeywords[i]);
+      if (apcKeywords[i + 1] == NULL)
+         ASSURE(pcValue == NULL);
+      else
+         ASSURE(pcValue != NULL && strcmp(pcValue, apcKeywords[i + 1]) == 0);
+   }
+
+   for (i = 0; i < sizeof(apcAbsent) / sizeof(apcAbsent[0]); i++)
+   {
+      ASSURE(! SymTableStatic_contains(&testkeywords, apcAbsent[i]));
+      ASSURE(SymTableStatic_get(&testkeywords, apcAbsent[i]) == NULL);
+   }
+
+   /* map visits every binding once, with its own value. */
+   uCount = 0;
+   SymTableStatic_map(&testkeywords, countKnown, &uCount);
+   ASSURE(uCount == uKeyCount);
+   uCount = 0;
+   SymTableStatic_map(&testkeywords, countAll, &uCount);
+   ASSURE(uCount == uKeyCount);
+}
+
+/* Test the table symtablegen built from the empty testempty.tsv. */
+
+static void testEmpty(void)
+{
+   size_t uCount = 0;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing an empty static table.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   ASSURE(SymTableStatic_getLength(&testempty) == 0);
+   ASSURE(! SymTableStatic_contains(&testempty, ""));
+   ASSURE(! SymTableStatic_contains(&testempty, "int"));
+   ASSURE(SymTableStatic_get(&testempty, "int") == NULL);
+   SymTableStatic_map(&testempty, countAll, &uCount);
+   ASSURE(uCount == 0);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the static tables generated for this program. Any arguments
+   are ignored, since the tables are fixed at build time. Return 0. */
+
+int main(int argc, char *argv[])
+{
+   (void)argc;
+
+   testKeywords();
+   testEmpty();
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
+
+/*--------------------------------------------------------------------*/
@@ -0,0 +1,246 @@
+/*--------------------------------------------------------------------*/
+/* testsymtabletrace.c                                                */
+/* Author: Tara Shukla                                                */
+/*--------------------------------------------------------------------*/
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "symtabletrace.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Return the size in bytes of the file pcPath, or -1 if it cannot be
+   found. */
+
+static long fileSize(const char *pcPath)
+{
+   struct stat sStat;
+
+   if (stat(pcPath, &sStat) != 0)
+      return -1;
+   return (long)sStat.st_size;
+}
+
+/* Return 1 if psOp is an operation of kind iKind on a key of
+   uKeyLength bytes, else 0. */
+
+static int isOp(const struct SymTableTraceOp *psOp, int iKind,
+   size_t uKeyLength)
+{
+   return psOp->iKind == iKind && psOp->uKeyLength == uKeyLength;
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test that the traced functions act as the SymTable functions do,
+   and that the trace read back records each operation, in both
+   modes. pcPath names the trace. */
+
+static void testBasics(const char *pcPath)
+{
+   SymTable_T oSymTable;
+   SymTableTrace_T oTrace;
+   struct SymTableTraceOp *psOps;
+   size_t uCount;
+   int iMode;
+   int iOne = 1;
+   int iTwo = 2;
+   FILE *psFile;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the SymTableTrace functions.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTable_put(oSymTable, "Ruth", &iOne));
+
+   oTrace = SymTableTrace_open(oSymTable, pcPath, SYMTABLE_TRACE_NUMBERED);
+   ASSURE(oTrace != NULL);
+   ASSURE(SymTableTrace_getLength(oTrace) == 1);
+   ASSURE(SymTableTrace_put(oTrace, "Jeter", &iOne));
+   ASSURE(SymTableTrace_put(oTrace, "Mantle", &iOne));
+   ASSURE(! SymTableTrace_put(oTrace, "Jeter", &iTwo));
+   ASSURE(SymTableTrace_get(oTrace, "Jeter") == &iOne);
+   ASSURE(! SymTableTrace_contains(oTrace, "Gehrig"));
+   ASSURE(SymTableTrace_replace(oTrace, "Mantle", &iTwo) == &iOne);
+   ASSURE(SymTableTrace_remove(oTrace, "Jeter") == &iOne);
+   ASSURE(SymTableTrace_put(oTrace, "", &iOne));
+   ASSURE(SymTableTrace_getLength(oTrace) == 9);
+   ASSURE(SymTableTrace_close(oTrace));
+   ASSURE(SymTable_getLength(oSymTable) == 3);
+   ASSURE(SymTable_get(oSymTable, "Mantle") == &iTwo);
+   ASSURE(fileSize(pcPath) == 10 + 9 * 7);
+
+   /* Keys are numbered in the order they first appear. */
+   psOps = SymTableTrace_load(pcPath, &uCount, &iMode);
+   ASSURE(psOps != NULL);
+   ASSURE(uCount == 9);
+   ASSURE(iMode == SYMTABLE_TRACE_NUMBERED);
+   ASSURE(isOp(&psOps[0], SYMTABLE_TRACE_PRELOAD, 4) && psOps[0].ulKey == 0);
+   ASSURE(isOp(&psOps[1], SYMTABLE_TRACE_PUT, 5) && psOps[1].ulKey == 1);
+   ASSURE(isOp(&psOps[2], SYMTABLE_TRACE_PUT, 6) && psOps[2].ulKey == 2);
+   ASSURE(isOp(&psOps[3], SYMTABLE_TRACE_PUT, 5) && psOps[3].ulKey == 1);
+   ASSURE(isOp(&psOps[4], SYMTABLE_TRACE_GET, 5) && psOps[4].ulKey == 1);
+   ASSURE(isOp(&psOps[5], SYMTABLE_TRACE_CONTAINS, 6) && psOps[5].ulKey == 3);
+   ASSURE(isOp(&psOps[6], SYMTABLE_TRACE_REPLACE, 6) && psOps[6].ulKey == 2);
+   ASSURE(isOp(&psOps[7], SYMTABLE_TRACE_REMOVE, 5) && psOps[7].ulKey == 1);
+   ASSURE(isOp(&psOps[8], SYMTABLE_TRACE_PUT, 0) && psOps[8].ulKey == 4);
+   free(psOps);
+
+   /* Hashed keys give equal tokens for equal keys. */
+   oTrace = SymTableTrace_open(oSymTable, pcPath, SYMTABLE_TRACE_HASHED);
+   ASSURE(oTrace != NULL);
+   ASSURE(SymTableTrace_get(oTrace, "Mantle") == &iTwo);
+   ASSURE(SymTableTrace_remove(oTrace, "Mantle") == &iTwo);
+   ASSURE(SymTableTrace_getLength(oTrace) == 5);
+   ASSURE(SymTableTrace_close(oTrace));
+   psOps = SymTableTrace_load(pcPath, &uCount, &iMode);
+   ASSURE(psOps != NULL);
+   ASSURE(uCount == 5);
+   ASSURE(iMode == SYMTABLE_TRACE_HASHED);
+   ASSURE(isOp(&psOps[3], SYMTABLE_TRACE_GET, 6));
+   ASSURE(isOp(&psOps[4], SYMTABLE_TRACE_REMOVE, 6));
+   ASSURE(psOps[3].ulKey == psOps[4].ulKey);
+   free(psOps);
+
+   /* A torn last record is ignored. */
+   ASSURE(truncate(pcPath, (off_t)(fileSize(pcPath) - 3)) == 0);
+   psOps = SymTableTrace_load(pcPath, &uCount, NULL);
+   ASSURE(psOps != NULL);
+   ASSURE(uCount == 4);
+   free(psOps);
+
+   /* A file that is not a trace is refused. */
+   psFile = fopen(pcPath, "w");
+   ASSURE(psFile != NULL);
+   fputs("Jeter\tShortstop\n", psFile);
+   fclose(psFile);
+   ASSURE(SymTableTrace_load(pcPath, &uCount, NULL) == NULL);
+   ASSURE(SymTableTrace_open(oSymTable, "/nonexistent/trace",
+      SYMTABLE_TRACE_HASHED) == NULL);
+
+   SymTable_free(oSymTable);
+   ASSURE(unlink(pcPath) == 0);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test tracing iBindingCount puts, gets and removes, and print the CPU
+   time spent recording and reading back the trace. pcPath names the
+   trace. */
+
+static void testLargeTrace(const char *pcPath, int iBindingCount)
+{
+   SymTable_T oSymTable;
+   SymTableTrace_T oTrace;
+   struct SymTableTraceOp *psOps;
+   size_t uCount;
+   char acKey[32];
+   int iSmall;
+   int i;
+   clock_t iInitialClock;
+   clock_t iFinalClock;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a large trace.\n");
+   printf("No output except CPU time consumed should appear here:\n");
+   fflush(stdout);
+
+   iInitialClock = clock();
+
+   oSymTable = SymTable_new();
+   ASSURE(oSymTable != NULL);
+   oTrace = SymTableTrace_open(oSymTable, pcPath, SYMTABLE_TRACE_NUMBERED);
+   ASSURE(oTrace != NULL);
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTableTrace_put(oTrace, acKey, &iSmall));
+   }
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(SymTableTrace_get(oTrace, acKey) == &iSmall);
+      ASSURE(SymTableTrace_remove(oTrace, acKey) == &iSmall);
+   }
+   ASSURE(SymTableTrace_close(oTrace));
+   ASSURE(SymTable_getLength(oSymTable) == 0);
+   SymTable_free(oSymTable);
+
+   psOps = SymTableTrace_load(pcPath, &uCount, NULL);
+   ASSURE(psOps != NULL);
+   ASSURE(uCount == 3 * (size_t)iBindingCount);
+   for (i = 0; i < iBindingCount; i++)
+   {
+      sprintf(acKey, "%d", i);
+      ASSURE(isOp(&psOps[i], SYMTABLE_TRACE_PUT, strlen(acKey)));
+      ASSURE(psOps[i].ulKey == (unsigned long)i);
+      ASSURE(psOps[iBindingCount + 2 * i].iKind == SYMTABLE_TRACE_GET);
+      ASSURE(psOps[iBindingCount + 2 * i + 1].ulKey == (unsigned long)i);
+   }
+   free(psOps);
+   ASSURE(unlink(pcPath) == 0);
+
+   iFinalClock = clock();
+   printf("CPU time (%d bindings):  %f seconds\n", iBindingCount,
+      ((double)(iFinalClock - iInitialClock)) / CLOCKS_PER_SEC);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the SymTableTrace implementation with argv[1] bindings in the
+   large trace. Return 0, or exit with EXIT_FAILURE on bad usage. */
+
+int main(int argc, char *argv[])
+{
+   char acPath[64];
+   int iBindingCount;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s bindingcount\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+   if (sscanf(argv[1], "%d", &iBindingCount) != 1 || iBindingCount < 0)
+   {
+      fprintf(stderr, "bindingcount must be a nonnegative number\n");
+      exit(EXIT_FAILURE);
+   }
+
+   /* A per-process name keeps concurrent runs apart. */
+   sprintf(acPath, "/tmp/testsymtabletrace.%ld", (long)getpid());
+   testBasics(acPath);
+   testLargeTrace(acPath, iBindingCount);
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
+
+/*--------------------------------------------------------------------*/
@@ -0,0 +1,180 @@
+/*--------------------------------------------------------------------*/
+/* testsymtableu64.c                                                  */
+/* Author: Tara Shukla                                                */
+/*--------------------------------------------------------------------*/
+
+#include "symtableu64.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+/*--------------------------------------------------------------------*/
+
+#define ASSURE(i) assure(i, __LINE__)
+
+/*--------------------------------------------------------------------*/
+
+/* If !iSuccessful, print a message to stdout indicating that the
+   test at line iLineNum failed. */
+
+static void assure(int iSuccessful, int iLineNum)
+{
+   if (! iSuccessful)
+   {
+      printf("Test at line %d failed.\n", iLineNum);
+      fflush(stdout);
+   }
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the put, get, replace, contains and remove functions. */
+
+static void testBasics(void)
+{
+   SymTableU64_T oSymTable;
+   char acShortstop[] = "Shortstop";
+   char acCenterField[] = "Center Field";
+   char acFirstBase[] = "First Base";
+   char *pcValue;
+   int iSuccessful;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing the basic SymTableU64 functions.\n");
+   printf("No output should appear here:\n");
+   fflush(stdout);
+
+   oSymTable = SymTableU64_new();
+   ASSURE(oSymTable != NULL);
+   ASSURE(SymTableU64_getLength(oSymTable) == 0);
+
+   iSuccessful = SymTableU64_put(oSymTable, 2, acShortstop);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTableU64_put(oSymTable, 7, acCenterField);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTableU64_put(oSymTable, UINT64_MAX, acFirstBase);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTableU64_put(oSymTable, 0, NULL);
+   ASSURE(iSuccessful);
+   iSuccessful = SymTableU64_put(oSymTable, 7, acFirstBase);
+   ASSURE(! iSuccessful);
+   ASSURE(SymTableU64_getLength(oSymTable) == 4);
+
+   ASSURE(SymTableU64_get(oSymTable, 2) == acShortstop);
+   ASSURE(SymTableU64_get(oSymTable, 7) == acCenterField);
+   ASSURE(SymTableU64_get(oSymTable, UINT64_MAX) == acFirstBase);
+   ASSURE(SymTableU64_contains(oSymTable, 0));
+   ASSURE(! SymTableU64_contains(oSymTable, 3));
+   ASSURE(SymTableU64_get(oSymTable, 3) == NULL);
+
+   pcValue = (char*)SymTableU64_replace(oSymTable, 7, acFirstBase);
+   ASSURE(pcValue == acCenterField);
+   ASSURE(SymTableU64_get(oSymTable, 7) == acFirstBase);
+   pcValue = (char*)SymTableU64_replace(oSymTable, 3, acFirstBase);
+   ASSURE(pcValue == NULL);
+   ASSURE(! SymTableU64_contains(oSymTable, 3));
+
+   pcValue = (char*)SymTableU64_remove(oSymTable, 2);
+   ASSURE(pcValue == acShortstop);
+   ASSURE(! SymTableU64_contains(oSymTable, 2));
+   pcValue = (char*)SymTableU64_remove(oSymTable, 2);
+   ASSURE(pcValue == NULL);
+   ASSURE(SymTableU64_getLength(oSymTable) == 3);
+
+   SymTableU64_free(oSymTable);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Add uKey to the sum that pvExtra points to, and check that pvValue
+   is the address of that sum. */
+
+static void sumKeys(uint64_t uKey, void *pvValue, void *pvExtra)
+{
+   ASSURE(pvValue == pvExtra);
+   *(uint64_t*)pvExtra += uKey;
+}
+
+/* Test a SymTableU64 object with iBindingCount bindings, removing
+   some of them so that probe runs are broken up, then mapping over
+   the rest. */
+
+static void testLargeTable(int iBindingCount)
+{
+   SymTableU64_T oSymTable;
+   uint64_t uSum = 0;
+   uint64_t uExpected = 0;
+   uint64_t uKey;
+   int iSuccessful;
+   int i;
+   clock_t iInitialClock;
+   clock_t iFinalClock;
+
+   printf("------------------------------------------------------\n");
+   printf("Testing a potentially large SymTableU64 object.\n");
+   printf("No output except CPU time consumed should appear here:\n");
+   fflush(stdout);
+
+   iInitialClock = clock();
+
+   oSymTable = SymTableU64_new();
+   ASSURE(oSymTable != NULL);
+
+   /* Keys that differ only in high bits still spread out. */
+   for (i = 0; i < iBindingCount; i++)
+   {
+      uKey = (uint64_t)i << 32;
+      iSuccessful = SymTableU64_put(oSymTable, uKey, &uSum);
+      ASSURE(iSuccessful);
+   }
+   ASSURE(SymTableU64_getLength(oSymTable) == (size_t)iBindingCount);
+
+   for (i = 0; i < iBindingCount; i += 3)
+      ASSURE(SymTableU64_remove(oSymTable, (uint64_t)i << 32) == &uSum);
+
+   for (i = 0; i < iBindingCount; i++)
+   {
+      uKey = (uint64_t)i << 32;
+      ASSURE(SymTableU64_contains(oSymTable, uKey) == (i % 3 != 0));
+      if (i % 3 != 0) uExpected += uKey;
+   }
+
+   SymTableU64_map(oSymTable, sumKeys, &uSum);
+   ASSURE(uSum == uExpected);
+
+   SymTableU64_free(oSymTable);
+
+   iFinalClock = clock();
+   printf("CPU time (%d bindings):  %f seconds\n", iBindingCount,
+      ((double)(iFinalClock - iInitialClock)) / CLOCKS_PER_SEC);
+}
+
+/*--------------------------------------------------------------------*/
+
+/* Test the SymTableU64 implementation with argv[1] bindings in the
+   large table. Return 0, or exit with EXIT_FAILURE on bad usage. */
+
+int main(int argc, char *argv[])
+{
+   int iBindingCount;
+
+   if (argc != 2)
+   {
+      fprintf(stderr, "Usage: %s bindingcount\n", argv[0]);
+      exit(EXIT_FAILURE);
+   }
+   if (sscanf(argv[1], "%d", &iBindingCount) != 1 || iBindingCount < 0)
+   {
+      fprintf(stderr, "bindingcount must be a nonnegative number\n");
+      exit(EXIT_FAILURE);
+   }
+
+   testBasics();
+   testLargeTable(iBindingCount);
+
+   printf("------------------------------------------------------\n");
+   printf("End of %s.\n", argv[0]);
+   return 0;
+}
+
+/*--------------------------------------------------------------------*/